@@ -0,0 +1,165 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Throughput of each ICP provider over a corpus of recorded reports.
+ *
+ * Usage: bench_icp_providers [corpus directory]
+ *
+ * Reports in the directory are given to the provider for their extension:
+ * ".html" to ATI, ".csv" to CSV and ".json" to JSON. Without a directory, a
+ * corpus is generated covering every element. Exits nonzero if any report
+ * fails to parse.
+ */
+
+#include <reef_moonshiners/icp_provider.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+/// each provider's reports are parsed for at least this long
+constexpr std::chrono::milliseconds run_time{1000};
+/// reports parsed per minute that each provider should sustain
+constexpr double target_rate = 100000.0;
+
+struct Corpus
+{
+  const reef_moonshiners::IcpProvider * provider;
+  std::vector<std::string> reports;
+};
+
+std::string generate_ati(const size_t seed)
+{
+  std::string page = "<html><body><script>\nvar dataTable = new AnalysisTable({\n";
+  for (size_t x = 0; x < reef_moonshiners::icp_element_count; ++x) {
+    page += "\"" + std::to_string(x) + "\": {\"id\": " + std::to_string(seed * 100 + x) +
+      ", \"element\": {\"id\": " + std::to_string(x) + ", \"symbol\": \"" +
+      std::string{reef_moonshiners::icp_element_symbols[x]} + "\", \"description_en\": \"" +
+      std::string{reef_moonshiners::icp_element_names[x]} + "\", \"units_id\": 1}" +
+      ", \"elements_value\": " + std::to_string(x + seed * 0.01) + "},\n";
+  }
+  return page + "tank: {\"volume\": 450}});\n</script></body></html>\n";
+}
+
+std::string generate_csv(const size_t seed)
+{
+  std::string report = "Date,Element,Value,Unit\n";
+  for (size_t x = 0; x < reef_moonshiners::icp_element_count; ++x) {
+    report += "2022-09-14," + std::string{reef_moonshiners::icp_element_names[x]} + "," +
+      std::to_string(x + seed * 0.01) + ",ug/L\n";
+  }
+  return report;
+}
+
+std::string generate_json(const size_t seed)
+{
+  std::string report = "{\"date\": \"2022-09-14\", \"results\": [\n";
+  for (size_t x = 0; x < reef_moonshiners::icp_element_count; ++x) {
+    report += std::string{x ? ",\n" : ""} + "{\"element\": \"" +
+      std::string{reef_moonshiners::icp_element_symbols[x]} + "\", \"value\": " +
+      std::to_string(x + seed * 0.01) + ", \"unit\": \"ug/L\"}";
+  }
+  return report + "]}\n";
+}
+
+void generate(std::vector<Corpus> & corpora)
+{
+  constexpr size_t reports = 64;
+  for (size_t seed = 0; seed < reports; ++seed) {
+    corpora[0].reports.push_back(generate_ati(seed));
+    corpora[1].reports.push_back(generate_csv(seed));
+    corpora[2].reports.push_back(generate_json(seed));
+  }
+}
+
+bool load(const std::filesystem::path & directory, std::vector<Corpus> & corpora)
+{
+  std::error_code error;
+  for (const auto & file : std::filesystem::directory_iterator{directory, error}) {
+    const auto extension = file.path().extension();
+    const size_t index = (".html" == extension) ? 0 : (".csv" == extension) ? 1 :
+      (".json" == extension) ? 2 : corpora.size();
+    if (index == corpora.size()) {
+      continue;
+    }
+    std::ifstream in{file.path(), std::ios::binary};
+    std::stringstream contents;
+    contents << in.rdbuf();
+    corpora[index].reports.push_back(contents.str());
+  }
+  if (error) {
+    fprintf(stderr, "Could not read '%s': %s\n", directory.c_str(), error.message().c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  const auto providers = reef_moonshiners::get_icp_providers();
+  std::vector<Corpus> corpora;
+  for (const auto * provider : providers) {
+    corpora.push_back(Corpus{provider, {}});
+  }
+  if (argc > 1) {
+    if (!load(argv[1], corpora)) {
+      return 1;
+    }
+  } else {
+    generate(corpora);
+  }
+
+  bool succeeded = true;
+  reef_moonshiners::IcpReport report;
+  std::string error;
+  for (const auto & corpus : corpora) {
+    if (corpus.reports.empty()) {
+      continue;
+    }
+    size_t parsed = 0, bytes = 0;
+    const auto start = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::duration{};
+    while (elapsed < run_time && succeeded) {
+      for (const auto & text : corpus.reports) {
+        if (!corpus.provider->parse(text, report, error)) {
+          fprintf(
+            stderr, "%s: report %zu failed: %s\n", std::string{corpus.provider->get_name()}.c_str(),
+            parsed % corpus.reports.size(), error.c_str());
+          succeeded = false;
+          break;
+        }
+        ++parsed;
+        bytes += text.size();
+      }
+      elapsed = std::chrono::steady_clock::now() - start;
+    }
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    const double rate = parsed / seconds * 60.0;
+    printf(
+      "%-12s %6zu reports %10.0f reports/min %8.1f MB/s%s\n",
+      std::string{corpus.provider->get_name()}.c_str(), corpus.reports.size(), rate,
+      bytes / seconds / 1E6, (rate < target_rate) ? "  (below target)" : "");
+  }
+  return succeeded ? 0 : 1;
+}
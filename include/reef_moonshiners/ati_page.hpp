@@ -0,0 +1,97 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__ATI_PAGE_HPP_
+#define REEF_MOONSHINERS__ATI_PAGE_HPP_
+
+#include <reef_moonshiners/icp_elements.hpp>
+
+#include <array>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace reef_moonshiners
+{
+
+/**
+ * @brief One result of an ATI analysis
+ */
+struct AtiMeasurement
+{
+  /// English name of the element, viewing the page it was scanned from
+  std::string_view name;
+  /// concentration in micrograms per liter
+  double value = 0.0;
+};
+
+/**
+ * @brief Results of an ATI analysis, scanned from the analysis page
+ *
+ * Names view the scanned page, so the page must outlive the results.
+ */
+class AtiPage
+{
+public:
+  /// most results a page may hold
+  constexpr static size_t max_measurements = 128;
+
+  /**
+   * @brief Scan the results out of an analysis page
+   *
+   * The page's "var dataTable" script holds one entry per element, keyed
+   * "0", "1" and so on. The entries are read in a single pass over the page,
+   * without copying it, up to the first key that is not an entry. Results in
+   * milligrams per liter are converted to micrograms per liter, and results
+   * without a value are skipped.
+   *
+   * @param page HTML of the analysis page
+   * @param error Output, reason the page could not be scanned
+   *
+   * @return True if the page was scanned
+   */
+  bool scan(const std::string_view page, std::string & error);
+
+  std::span<const AtiMeasurement> get_measurements() const;
+
+  /**
+   * @brief Resolve the results to elements
+   *
+   * @param results Output, results of known elements
+   * @param unknown Output, names that are not known elements
+   */
+  void get_results(IcpResults & results, std::vector<std::string_view> & unknown) const;
+
+private:
+  std::array<AtiMeasurement, max_measurements> m_measurements;
+  size_t m_size = 0;
+};
+
+/**
+ * @brief Scan an analysis page, as a BatchImporter::Parser
+ *
+ * Results for names that are not known elements are dropped.
+ *
+ * @param page HTML of the analysis page
+ * @param results Output, results of the analysis
+ * @param error Output, reason the page could not be scanned
+ *
+ * @return True if the page was scanned
+ */
+bool parse_ati_page(const std::string & page, IcpResults & results, std::string & error);
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__ATI_PAGE_HPP_
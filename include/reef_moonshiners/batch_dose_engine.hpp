@@ -0,0 +1,153 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__BATCH_DOSE_ENGINE_HPP_
+#define REEF_MOONSHINERS__BATCH_DOSE_ENGINE_HPP_
+
+#include <reef_moonshiners/correction_element.hpp>
+#include <reef_moonshiners/daily_element.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace reef_moonshiners
+{
+
+enum class BatchElementKind : uint8_t
+{
+  DAILY = 0,
+  CORRECTION = 1
+};
+
+/**
+ * @brief Dose calculator for many tanks at once
+ *
+ * Parameters are stored as structure-of-arrays: one array per field, with
+ * every tank's value for an element stored contiguously. The daily and
+ * correction formulas from DailyElement and CorrectionElement are evaluated
+ * per element across all tanks in loops with no virtual calls and only
+ * selects, which GCC vectorizes at -O3. Writing those doses out to the
+ * tank-major schedule is a contiguous fill per tank.
+ *
+ * Only the plain daily and correction formulas are modelled: dropper
+ * elements, Rubidium's calendar and nano doses are not.
+ */
+class BatchDoseEngine
+{
+public:
+  /**
+   * @brief Construct an engine for a fleet of tanks
+   * @param tanks Number of tanks in the fleet
+   */
+  explicit BatchDoseEngine(const size_t tanks);
+
+  /**
+   * @brief Add an element column
+   *
+   * @param kind Which dosing formula applies to this element
+   * @param element_concentration Supplement concentration in micrograms per liter
+   * @param target_concentration Default target concentration in micrograms per liter
+   * @param max_adjustment Maximum adjustment in micrograms per liter per day
+   *
+   * @return Index of the new element
+   */
+  size_t add_element(
+    const BatchElementKind kind, const double element_concentration,
+    const double target_concentration, const double max_adjustment);
+
+  /**
+   * @brief Add an element column with the parameters of a daily element
+   * @return Index of the new element
+   */
+  size_t add_element(const DailyElement & element);
+
+  /**
+   * @brief Add an element column with the parameters of a correction element
+   * @return Index of the new element
+   */
+  size_t add_element(const CorrectionElement & element);
+
+  size_t get_tank_count() const;
+
+  size_t get_element_count() const;
+
+  /**
+   * @brief Set the volume of a tank
+   * @param tank Index of the tank
+   * @param tank_size Tank volume in liters
+   */
+  void set_tank_size(const size_t tank, const double tank_size);
+
+  double get_tank_size(const size_t tank) const;
+
+  /**
+   * @brief Copy a tank's measurement and settings for an element
+   *
+   * @param tank Index of the tank
+   * @param element Index of the element column
+   * @param source Element holding this tank's state
+   */
+  void load(const size_t tank, const size_t element, const DailyElement & source);
+
+  void load(const size_t tank, const size_t element, const CorrectionElement & source);
+
+  void set_concentration(const size_t tank, const size_t element, const double concentration);
+
+  void set_target_concentration(
+    const size_t tank, const size_t element, const double target_concentration);
+
+  void set_multiplier(const size_t tank, const size_t element, const double multiplier);
+
+  void set_correction_start_date(
+    const size_t tank, const size_t element, const std::chrono::year_month_day & date);
+
+  /**
+   * @brief Compute the dose of every element for every tank over a range of days
+   *
+   * Doses are laid out tank-major: the dose of element e in tank t on day d
+   * is doses[(t * get_element_count() + e) * days + d].
+   *
+   * @param start First day of the schedule
+   * @param days Number of days in the schedule
+   * @param doses Output, resized to tanks * elements * days
+   */
+  void compute(
+    const std::chrono::year_month_day & start, const size_t days,
+    std::vector<double> & doses) const;
+
+private:
+  size_t _index(const size_t tank, const size_t element) const;
+
+  size_t m_tanks;
+
+  /// tank volume (liters), per tank
+  std::vector<double> m_tank_sizes;
+
+  /* per element */
+  std::vector<BatchElementKind> m_kinds;
+  std::vector<double> m_element_concentrations;
+  std::vector<double> m_max_adjustments;
+
+  /* per element, then per tank */
+  std::vector<double> m_concentrations;
+  std::vector<double> m_target_concentrations;
+  std::vector<double> m_multipliers;
+  /// correction start date, as days since the epoch
+  std::vector<int32_t> m_start_days;
+};
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__BATCH_DOSE_ENGINE_HPP_
@@ -0,0 +1,170 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__BATCH_IMPORTER_HPP_
+#define REEF_MOONSHINERS__BATCH_IMPORTER_HPP_
+
+#include <reef_moonshiners/ati_page.hpp>
+#include <reef_moonshiners/element_base.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace reef_moonshiners
+{
+
+/**
+ * @brief One ICP sample to import
+ */
+struct BatchImportEntry
+{
+  /// lab's identifier of the analysis
+  std::string analysis_id;
+  /// elements of the tank the sample was taken from
+  std::vector<ElementBase *> elements;
+  /// date the sample was taken
+  std::chrono::year_month_day collection_date;
+};
+
+enum class FetchStatus : uint8_t
+{
+  OK = 0,
+  /// worth trying again, such as a timeout or a busy server
+  TRANSIENT_ERROR = 1,
+  /// trying again will not help, such as an unknown analysis
+  PERMANENT_ERROR = 2
+};
+
+struct FetchResult
+{
+  FetchStatus status = FetchStatus::PERMANENT_ERROR;
+  /// analysis page, when status is OK
+  std::string page;
+  std::string error;
+};
+
+struct BatchImportOptions
+{
+  /// most analyses fetched at once
+  size_t parallelism = 4;
+  /// most fetches of one analysis, including the first
+  size_t max_attempts = 4;
+  /// longest wait before the first retry; later retries double it
+  std::chrono::milliseconds initial_backoff{250};
+  /// longest wait before any retry
+  std::chrono::milliseconds max_backoff{8000};
+  /// seed for the jitter of the waits
+  uint64_t seed = 0;
+};
+
+struct BatchImportResult
+{
+  bool imported = false;
+  /// number of fetches made
+  size_t attempts = 0;
+  /// reason the analysis was not imported
+  std::string error;
+  /// names of the entry's elements the analysis did not report, which are left alone
+  std::vector<std::string> missing;
+};
+
+/**
+ * @brief Import many ICP analyses at once
+ *
+ * Analyses are fetched and parsed on up to parallelism worker threads.
+ * Transient failures are retried after a randomized, exponentially growing
+ * wait ("full jitter"), so a struggling server is not hammered in lockstep.
+ * Once every fetch is done, the results are applied to each entry's elements
+ * on the calling thread, in the order of the entries, so entries may share
+ * elements.
+ *
+ * The fetcher is injected: the app fetches through Qt's network access
+ * manager (see ATIBatchImport), and the tests through a local stand-in for
+ * the lab.
+ */
+class BatchImporter
+{
+public:
+  /// fetch an analysis page; called concurrently from the worker threads
+  using Fetcher = std::function<FetchResult(const std::string & analysis_id)>;
+  /// extract the results from an analysis page; called concurrently
+  using Parser = std::function<bool(
+        const std::string & page, IcpResults & results, std::string & error)>;
+
+  explicit BatchImporter(Fetcher fetch, Parser parse, BatchImportOptions options = {});
+
+  /**
+   * @brief Fetch, parse and apply every entry
+   *
+   * Each element measured by an analysis has its concentration set as of the
+   * collection date. Elements missing from the analysis are left alone, and
+   * listed in the entry's result.
+   *
+   * @param entries Samples to import
+   *
+   * @return Outcome of each entry
+   */
+  std::vector<BatchImportResult> run(const std::vector<BatchImportEntry> & entries) const;
+
+  /**
+   * @brief Fetch and parse every entry, without applying the results
+   *
+   * The entries' elements are not touched, so this may run on a thread other
+   * than the one that owns them.
+   *
+   * @param entries Samples to fetch
+   * @param values Output, results of each entry that was imported
+   *
+   * @return Outcome of each entry, with no missing elements listed yet
+   */
+  std::vector<BatchImportResult> fetch(
+    const std::vector<BatchImportEntry> & entries,
+    std::vector<IcpResults> & values) const;
+
+  /**
+   * @brief Wait before a retry
+   *
+   * @param attempt Number of fetches made so far, at least 1
+   * @param rng Source of the jitter
+   *
+   * @return A uniformly random wait, up to initial_backoff * 2^(attempt - 1)
+   *         capped at max_backoff
+   */
+  std::chrono::milliseconds get_backoff(const size_t attempt, std::mt19937_64 & rng) const;
+
+  /**
+   * @brief Classify the response to a fetch
+   *
+   * Server errors, 408 and 429 responses, and connection failures are
+   * transient; other failed responses are permanent.
+   *
+   * @param status HTTP status code, 0 if the request never got a response
+   * @param body Body of the response
+   * @param error Reason the request failed, when status is 0
+   */
+  static FetchResult make_fetch_result(const int status, std::string body, std::string error);
+
+private:
+  Fetcher m_fetch;
+  Parser m_parse;
+  BatchImportOptions m_options;
+};
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__BATCH_IMPORTER_HPP_
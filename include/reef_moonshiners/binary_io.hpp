@@ -0,0 +1,234 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__BINARY_IO_HPP_
+#define REEF_MOONSHINERS__BINARY_IO_HPP_
+
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+/**
+ * Encoding of the values in save files
+ *
+ * Values are little-endian and as wide as their type, so write fixed-width
+ * types (uint64_t, not size_t). Dates are an int16_t year, then a uint8_t
+ * month and day; strings are a uint64_t length followed by their bytes. This
+ * matches what 64-bit little-endian builds wrote before the encoding was
+ * spelled out, so older save files read the same.
+ *
+ * Reads never allocate beyond the string being read into, and a failed or
+ * implausible read sets the stream's failbit.
+ */
+
+namespace reef_moonshiners
+{
+
+/// longest string binary_in accepts
+constexpr uint64_t max_binary_string_length = 4096;
+
+template<typename T>
+concept BinaryScalar = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+/**
+ * @brief Unsigned integer of the same width as T
+ */
+template<typename T>
+using binary_bits_t = std::conditional_t<
+  sizeof(T) == 1, uint8_t, std::conditional_t<
+    sizeof(T) == 2, uint16_t, std::conditional_t<
+      sizeof(T) == 4, uint32_t, uint64_t>>>;
+
+/**
+ * @brief Encode a value into sizeof(T) little-endian bytes
+ */
+template<BinaryScalar T>
+inline void store_little_endian(char * bytes, const T value)
+{
+  static_assert(sizeof(T) <= sizeof(uint64_t), "no encoding for wider types");
+  binary_bits_t<T> bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  if constexpr (std::endian::native == std::endian::little) {
+    std::memcpy(bytes, &bits, sizeof(bits));
+  } else {
+    for (size_t x = 0; x < sizeof(bits); ++x) {
+      bytes[x] = static_cast<char>((bits >> (8 * x)) & 0xff);
+    }
+  }
+}
+
+/**
+ * @brief Decode a value from sizeof(T) little-endian bytes
+ */
+template<BinaryScalar T>
+inline T load_little_endian(const char * bytes)
+{
+  binary_bits_t<T> bits{};
+  if constexpr (std::endian::native == std::endian::little) {
+    std::memcpy(&bits, bytes, sizeof(bits));
+  } else {
+    for (size_t x = 0; x < sizeof(bits); ++x) {
+      bits |= static_cast<binary_bits_t<T>>(static_cast<uint8_t>(bytes[x])) << (8 * x);
+    }
+  }
+  T value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+template<BinaryScalar T>
+inline void binary_out(std::ostream & stream, const T & obj)
+{
+  char bytes[sizeof(T)];
+  store_little_endian(bytes, obj);
+  stream.write(bytes, sizeof(bytes));
+}
+
+inline void binary_out(std::ostream & stream, const std::chrono::year_month_day & obj)
+{
+  char bytes[4];
+  store_little_endian(bytes, static_cast<int16_t>(static_cast<int>(obj.year())));
+  bytes[2] = static_cast<char>(static_cast<unsigned>(obj.month()));
+  bytes[3] = static_cast<char>(static_cast<unsigned>(obj.day()));
+  stream.write(bytes, sizeof(bytes));
+}
+
+inline void binary_out(std::ostream & stream, const std::string & obj)
+{
+  binary_out(stream, static_cast<uint64_t>(obj.size()));
+  stream.write(obj.data(), obj.size());
+}
+
+template<typename K, typename V>
+inline void binary_out(std::ostream & stream, const std::unordered_map<K, V> & obj)
+{
+  binary_out(stream, static_cast<uint64_t>(obj.size()));
+  for (const auto &[key, value] : obj) {
+    binary_out(stream, key);
+    binary_out(stream, value);
+  }
+}
+
+template<BinaryScalar T>
+inline void binary_in(std::istream & stream, T & obj)
+{
+  char bytes[sizeof(T)];
+  if (stream.read(bytes, sizeof(bytes))) {
+    obj = load_little_endian<T>(bytes);
+  }
+}
+
+inline void binary_in(std::istream & stream, std::chrono::year_month_day & obj)
+{
+  char bytes[4];
+  if (stream.read(bytes, sizeof(bytes))) {
+    obj = std::chrono::year_month_day{
+      std::chrono::year(load_little_endian<int16_t>(bytes)),
+      std::chrono::month(static_cast<uint8_t>(bytes[2])),
+      std::chrono::day(static_cast<uint8_t>(bytes[3]))};
+  }
+}
+
+/**
+ * Read a string into obj, reusing its storage
+ *
+ * Lengths over max_binary_string_length fail rather than allocate.
+ */
+inline void binary_in(std::istream & stream, std::string & obj)
+{
+  uint64_t len = 0;
+  binary_in(stream, len);
+  if (!stream || len > max_binary_string_length) {
+    stream.setstate(std::ios::failbit);
+    obj.clear();
+    return;
+  }
+  obj.resize(static_cast<size_t>(len));
+  if (!stream.read(obj.data(), obj.size())) {
+    obj.clear();
+  }
+}
+
+template<typename K, typename V>
+inline void binary_in(std::istream & stream, std::unordered_map<K, V> & obj)
+{
+  uint64_t len = 0;
+  binary_in(stream, len);
+
+  K key{};
+  V value{};
+  for (; len-- > 0 && stream; ) {
+    binary_in(stream, key);
+    binary_in(stream, value);
+    if (stream) {
+      obj[key] = value;
+    }
+  }
+}
+
+/**
+ * @brief Map signed integers to unsigned ones, small magnitudes first
+ */
+constexpr uint64_t zigzag_encode(const int64_t value)
+{
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+constexpr int64_t zigzag_decode(const uint64_t value)
+{
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+/// longest encoding of a uint64_t varint
+constexpr size_t max_varint_length = 10;
+
+/**
+ * @brief Write an unsigned integer seven bits per byte, low bits first
+ */
+inline void binary_out_varint(std::ostream & stream, uint64_t value)
+{
+  char bytes[max_varint_length];
+  size_t size = 0;
+  for (; value >= 0x80; value >>= 7) {
+    bytes[size++] = static_cast<char>((value & 0x7f) | 0x80);
+  }
+  bytes[size++] = static_cast<char>(value);
+  stream.write(bytes, size);
+}
+
+inline void binary_in_varint(std::istream & stream, uint64_t & value)
+{
+  value = 0;
+  for (size_t x = 0; x < max_varint_length; ++x) {
+    const auto byte = stream.get();
+    if (!stream) {
+      return;
+    }
+    value |= static_cast<uint64_t>(byte & 0x7f) << (7 * x);
+    if (0 == (byte & 0x80)) {
+      return;
+    }
+  }
+  stream.setstate(std::ios::failbit);
+}
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__BINARY_IO_HPP_
@@ -0,0 +1,127 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__CONCENTRATION_SIMULATOR_HPP_
+#define REEF_MOONSHINERS__CONCENTRATION_SIMULATOR_HPP_
+
+#include <reef_moonshiners/element_base.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace reef_moonshiners
+{
+
+struct SimulationParameters
+{
+  /// number of perturbed scenarios to run
+  size_t scenarios = 1000;
+  /// number of days to simulate
+  size_t days = 90;
+  /// relative error of the ICP measurement (0.1 is +/- 10%)
+  double measurement_error = 0.1;
+  /// fraction of each element consumed per day
+  double consumption_rate = 0.0;
+  /// relative error of the consumption rate
+  double consumption_error = 0.0;
+  /// percentiles to report, each in [0, 100]
+  std::vector<double> percentiles{5.0, 50.0, 95.0};
+  /// worker threads, 0 to use one per hardware thread
+  size_t threads = 0;
+  /// seed for the perturbations, results are reproducible for a given seed
+  uint64_t seed = 0;
+};
+
+/**
+ * @brief Percentile bands of simulated concentrations
+ */
+class ConcentrationBands
+{
+public:
+  ConcentrationBands() = default;
+
+  explicit ConcentrationBands(
+    const size_t elements, const size_t days,
+    std::vector<double> percentiles);
+
+  size_t get_element_count() const;
+
+  size_t get_day_count() const;
+
+  const std::vector<double> & get_percentiles() const;
+
+  /**
+   * @brief Access a band
+   *
+   * @param element Index of the element
+   * @param percentile Index into get_percentiles()
+   * @param day Days after the start of the simulation
+   *
+   * @return Concentration in micrograms per liter at the end of the day
+   */
+  double get(const size_t element, const size_t percentile, const size_t day) const;
+
+  void set(const size_t element, const size_t percentile, const size_t day, const double value);
+
+private:
+  size_t m_elements = 0;
+  size_t m_days = 0;
+  std::vector<double> m_percentiles;
+  /// m_values[(element * percentiles + percentile) * days + day]
+  std::vector<double> m_values;
+};
+
+/**
+ * @brief Monte Carlo forward simulation of element concentrations
+ *
+ * Each scenario perturbs the last measured concentration of every element
+ * (uniformly, within the measurement error) and optionally its daily
+ * consumption, then applies the element's scheduled doses. Elements are
+ * split across worker threads, and each element's scenarios are drawn in
+ * fixed blocks seeded from the element and block index, so results do not
+ * depend on the number of threads. Days are reduced to their percentiles as
+ * they are simulated, so memory grows with the scenarios, not the days.
+ *
+ * Dropper elements have no supplement concentration, so their drops do not
+ * change the simulated concentration.
+ */
+class ConcentrationSimulator
+{
+public:
+  /**
+   * @brief Construct a simulator
+   * @param elements Elements to simulate, which must outlive the simulator
+   */
+  explicit ConcentrationSimulator(std::vector<const ElementBase *> elements);
+
+  /**
+   * @brief Run the simulation
+   *
+   * @param start Date the measurement was taken, the first simulated day
+   * @param parameters Simulation parameters
+   *
+   * @return Concentration bands for each element
+   */
+  ConcentrationBands run(
+    const std::chrono::year_month_day & start,
+    const SimulationParameters & parameters) const;
+
+private:
+  std::vector<const ElementBase *> m_elements;
+};
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__CONCENTRATION_SIMULATOR_HPP_
@@ -15,8 +15,14 @@
 #ifndef REEF_MOONSHINERS__CORRECTION_ELEMENT_HPP_
 #define REEF_MOONSHINERS__CORRECTION_ELEMENT_HPP_
 
+#include <reef_moonshiners/dose_ledger.hpp>
 #include <reef_moonshiners/element_base.hpp>
 
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
 #include <unordered_map>
 
 namespace std
@@ -69,6 +75,10 @@ public:
 
   double get_dose(const std::chrono::year_month_day &) const override;
 
+  void fill_doses(
+    const std::chrono::year_month_day & start,
+    std::span<double> doses) const override;
+
   double get_current_concentration_estimate() const override;
 
   /**
@@ -79,6 +89,30 @@ public:
 
   void set_correction_start_date(const std::chrono::year_month_day & _correction_start_date);
 
+  /**
+   * @brief Daily dose while the correction runs
+   * @return Dosage in milliliters
+   */
+  double get_correction_dose() const;
+
+  /**
+   * @brief Number of days the correction runs for, starting at the correction start date
+   * @return Length of the correction, zero if there is nothing to correct
+   */
+  std::chrono::days get_correction_duration() const;
+
+  /**
+   * @brief Total dose needed to reach the target from the last measurement
+   * @return Dosage in milliliters, zero if there is nothing to correct
+   */
+  double get_correction_total() const;
+
+  /**
+   * @brief Largest dose allowed in one day by the maximum adjustment
+   * @return Dosage in milliliters, zero if there is nothing to correct
+   */
+  double get_max_daily_dose() const;
+
   /**
    * @brief Test function for future doses
    *
@@ -90,19 +124,97 @@ public:
    */
   double get_concentration_estimate(const std::chrono::year_month_day & date) const;
 
+  /**
+   * @brief Access the doses applied with apply_dose
+   * @return History of doses, by date
+   */
+  const DoseLedger & get_dose_history() const;
+
   void apply_dose(const double _dose, const std::chrono::year_month_day & _date) override;
 
+  /**
+   * @brief Forget every dose applied with apply_dose, including a deferred history
+   */
+  void clear_dose_history();
+
   void write_to(std::ostream & stream) const override;
 
   void read_from(std::istream & stream) override;
 
+  /**
+   * Serialize everything but the dose history
+   * @param stream Where to serialize
+   */
+  void write_settings_to(std::ostream & stream) const;
+
+  void read_settings_from(std::istream & stream);
+
+  /**
+   * Serialize the dose history
+   * @param stream Where to serialize
+   */
+  void write_ledger_to(std::ostream & stream) const;
+
+  void read_ledger_from(std::istream & stream);
+
+  /**
+   * @brief Defer reading the dose history until it is first needed
+   *
+   * @param bytes Dose history, as written by write_ledger_to
+   * @param version Version of the save file the history was written in
+   */
+  void defer_ledger(std::string bytes, const size_t version);
+
 private:
+  struct CorrectionPlan
+  {
+    /// mL to dose on each day of the correction
+    double daily_dose = 0.0;
+    /// number of days the correction runs for
+    std::chrono::days duration{0};
+    /// mL needed to reach the target
+    double total_dose = 0.0;
+    /// mL allowed per day by the maximum adjustment
+    double max_daily_dose = 0.0;
+  };
+
+  /**
+   * @brief Access the correction plan, rebuilding it if the element changed
+   *
+   * Safe to call from concurrent readers, provided nothing modifies the
+   * element or its tank meanwhile: the generation itself is not atomic.
+   *
+   * @return Plan for the current measurement, start date and tank size
+   */
+  CorrectionPlan _get_plan() const;
+
+  CorrectionPlan _make_plan() const;
+
+  /**
+   * @brief Access the dose history, reading it first if it was deferred
+   *
+   * Safe to call from concurrent readers.
+   */
+  const DoseLedger & _get_ledger() const;
+
   constexpr double _concentration_after_dose(const double dose_l);
 
   std::chrono::year_month_day m_correction_start_date;
 
-  /// map of date -> mL dosed
-  std::unordered_map<std::chrono::year_month_day, double> m_dosed_amounts;
+  /// cached plan, valid while m_plan_generation matches get_generation()
+  mutable CorrectionPlan m_plan;
+  mutable std::atomic<uint64_t> m_plan_generation{std::numeric_limits<uint64_t>::max()};
+  /// serializes plan rebuilds
+  mutable std::mutex m_plan_mutex;
+
+  /// date -> mL dosed, only valid once m_ledger_pending is false
+  mutable DoseLedger m_dosed_amounts;
+  /// serialized dose history handed to defer_ledger, not yet read
+  mutable std::string m_pending_ledger;
+  size_t m_pending_ledger_version = 0;
+  mutable std::atomic<bool> m_ledger_pending{false};
+  /// serializes reading the deferred dose history
+  mutable std::mutex m_ledger_mutex;
 };
 
 }  // namespace reef_moonshiners
@@ -0,0 +1,96 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__CORRECTION_OPTIMIZER_HPP_
+#define REEF_MOONSHINERS__CORRECTION_OPTIMIZER_HPP_
+
+#include <reef_moonshiners/correction_element.hpp>
+
+#include <vector>
+
+namespace reef_moonshiners
+{
+
+struct CorrectionConstraints
+{
+  /// mL the tank's pumps may deliver per day across all corrections, 0 for no limit
+  double daily_budget = 0.0;
+  /// number of corrections that may be dosed on the same day, 0 for no limit
+  size_t max_elements_per_day = 0;
+  /// days from one dose of an element to its next, 1 to dose daily
+  size_t min_interval = 1;
+  /// give up on corrections that have not completed after this many days
+  size_t horizon = 365;
+};
+
+struct CorrectionSolution
+{
+  /// days until every correction completes, or the horizon
+  size_t days = 0;
+  /// false if the horizon ran out before every correction completed
+  bool complete = true;
+  /// doses[day * elements + element], in mL
+  std::vector<double> doses;
+  /// days_to_target[element], days until the element's correction completes
+  std::vector<size_t> days_to_target;
+
+  /**
+   * @brief Access the dosage of an element on a day
+   *
+   * @param element Index of the element
+   * @param day Days after the start of the corrections
+   *
+   * @return Dosage in milliliters
+   */
+  double get_dose(const size_t element, const size_t day) const;
+};
+
+/**
+ * @brief Plans the corrections of a tank together
+ *
+ * Each correction is limited to its element's maximum daily adjustment. When
+ * the tank has a daily pump budget, or limits how many corrections may run on
+ * the same day, the corrections with the most days of work left go first and
+ * the budget is water-filled between them so they finish together, which
+ * keeps the number of days until every element is on target low.
+ */
+class CorrectionOptimizer
+{
+public:
+  /**
+   * @brief Construct an optimizer
+   * @param constraints Limits shared by the corrections of the tank
+   */
+  explicit CorrectionOptimizer(const CorrectionConstraints & constraints = {});
+
+  const CorrectionConstraints & get_constraints() const;
+
+  void set_constraints(const CorrectionConstraints & constraints);
+
+  /**
+   * @brief Plan the corrections from their last measurement
+   *
+   * @param elements Corrections of one tank
+   *
+   * @return Doses for each day, starting on the day corrections start
+   */
+  CorrectionSolution solve(const std::vector<const CorrectionElement *> & elements) const;
+
+private:
+  CorrectionConstraints m_constraints;
+};
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__CORRECTION_OPTIMIZER_HPP_
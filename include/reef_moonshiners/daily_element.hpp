@@ -31,12 +31,23 @@ public:
 
   double get_dose(const std::chrono::year_month_day &) const override;
 
+  void fill_doses(
+    const std::chrono::year_month_day & start,
+    std::span<double> doses) const override;
+
+  bool is_same_dose_every_day() const override;
+
   double get_nano_dose() const;
 
   void set_use_nano_dose(const bool _use_nano_dose);
 
   bool get_use_nano_dose() const;
 
+  /**
+   * @brief Concentration of the nano supplement if nano doses are enabled
+   */
+  double get_dose_concentration() const override;
+
   double get_current_concentration_estimate() const override;
 
   double get_multiplier() const;
@@ -49,7 +60,23 @@ public:
 
   void read_from(std::istream & stream) override;
 
+protected:
+  /**
+   * @brief Daily dose that holds the given target concentration
+   *
+   * Uses the nano concentration if nano doses are enabled.
+   *
+   * @param target_concentration Targeted concentration in micrograms per liter
+   *
+   * @return Dosage in milliliters
+   */
+  double _get_dose_for_target(const double target_concentration) const;
+
 private:
+  double _calculate_dose(
+    const double target_concentration,
+    const double supplement_concentration) const;
+
   double m_multiplier = 1.0;
   double m_nano_concentration = 0.0;
   bool m_use_nano_dose = false;
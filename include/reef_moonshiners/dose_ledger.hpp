@@ -0,0 +1,192 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__DOSE_LEDGER_HPP_
+#define REEF_MOONSHINERS__DOSE_LEDGER_HPP_
+
+#include <reef_moonshiners/binary_io.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace reef_moonshiners
+{
+
+/**
+ * @brief History of doses, indexed by the date they were dosed
+ *
+ * Doses are stored in flat, fixed-size chunks of consecutive days keyed by
+ * their offset from the epoch. Only chunks that contain a dose exist, so gaps
+ * between corrections cost nothing, and a running prefix sum over the chunks
+ * means the total dosed over any range of dates is two binary searches plus
+ * at most two partial chunk sums.
+ */
+class DoseLedger
+{
+public:
+  /**
+   * @brief Record the dose for a date, replacing any prior dose on that date
+   *
+   * @param date Date the dose occured
+   * @param dose_ml Amount dosed, in mL
+   */
+  void set(const std::chrono::year_month_day & date, const double dose_ml);
+
+  /**
+   * @brief Access the dose recorded for a date
+   *
+   * @param date Date to look up
+   *
+   * @return Amount dosed in mL, or 0.0 if nothing was dosed
+   */
+  double get(const std::chrono::year_month_day & date) const;
+
+  /**
+   * @brief Total amount dosed over a range of dates
+   *
+   * @param from First date of the range (inclusive)
+   * @param to Last date of the range (exclusive)
+   *
+   * @return Sum of the doses in [from, to), in mL
+   */
+  double total(
+    const std::chrono::year_month_day & from,
+    const std::chrono::year_month_day & to) const;
+
+  /**
+   * @brief Number of dates with a recorded dose
+   */
+  size_t size() const;
+
+  bool empty() const;
+
+  void clear();
+
+  /**
+   * @brief Visit every dose in date order
+   * @param visit Called with the date and the amount dosed in mL
+   */
+  template<typename Visitor>
+  void for_each(Visitor && visit) const
+  {
+    for (size_t x = 0; x < m_chunks.size(); ++x) {
+      const Chunk & chunk = m_chunks[x];
+      for (int32_t day = 0; day < chunk_days; ++day) {
+        if (chunk.present & (uint32_t{1} << day)) {
+          visit(
+            std::chrono::year_month_day{std::chrono::sys_days{
+                std::chrono::days{m_keys[x] * chunk_days + day}}},
+            chunk.doses[day]);
+        }
+      }
+    }
+  }
+
+  /**
+   * Serialize in the compact layout
+   *
+   * Layout:
+   *   uint64_t compact_magic
+   *   varint number of runs of consecutive days
+   *   per run: varint start, varint number of days, then one entry per day
+   *
+   * The first run's start is its zigzag day index since the epoch, later
+   * starts are the days since the end of the previous run. A dose entry is a
+   * varint whose low bit is clear for a dose that is a whole number of
+   * hundredths of a mL (the pump's resolution); the remaining bits are the
+   * zigzag difference in hundredths from the previous such dose. Any other
+   * dose sets the low bit and follows as a raw double, so every dose reads
+   * back exactly.
+   *
+   * @param stream Where to serialize
+   */
+  void write_to(std::ostream & stream) const;
+
+  /**
+   * Deserialize, accepting the (date, dose) pair layout of save files
+   * prior to version 4
+   * @param stream Where to deserialize from
+   */
+  void read_from(std::istream & stream);
+
+  /**
+   * Deserialize from a save file of the given version
+   * @param stream Where to deserialize from
+   * @param version Version of the save file the ledger was written in
+   */
+  void read_from(std::istream & stream, const size_t version);
+
+  /**
+   * @brief Dose in hundredths of a mL, if it round-trips through dequantize
+   */
+  static bool quantize(const double dose_ml, int64_t & hundredths);
+
+  /**
+   * @brief Inverse of quantize, computed as truncate_places<2> does
+   */
+  static double dequantize(const int64_t hundredths)
+  {
+    return static_cast<double>(hundredths) / 10 / 10;
+  }
+
+  /// number of consecutive days stored in one chunk
+  constexpr static int32_t chunk_days = 32;
+
+  /// first bytes of the compact layout, which no chunk count of the old layout can match
+  constexpr static uint64_t compact_magic = 0x0152474445444c52;
+
+private:
+  struct Chunk
+  {
+    /// bit i is set if a dose was recorded on day i of the chunk
+    uint32_t present = 0;
+    /// mL dosed on each day of the chunk, 0.0 if none
+    std::array<double, chunk_days> doses{};
+  };
+
+  static int32_t _to_day_index(const std::chrono::year_month_day & date);
+
+  /// index of the chunk holding the given day
+  static int32_t _chunk_key(const int32_t day_index);
+
+  /// sum of a chunk's doses on days [first, last)
+  static double _chunk_sum(const Chunk & chunk, const int32_t first, const int32_t last);
+
+  /// recompute m_prefix starting at the given chunk
+  void _update_prefix(const size_t first);
+
+  void _read_legacy(std::istream & stream);
+
+  /// read the chunked layout of versions 4 and 5, after its chunk count
+  void _read_chunks(std::istream & stream, uint64_t len);
+
+  void _read_compact(std::istream & stream);
+
+  /// chunk keys (day index / chunk_days), sorted ascending
+  std::vector<int32_t> m_keys;
+  /// chunk data for the corresponding entry of m_keys
+  std::vector<Chunk> m_chunks;
+  /// m_prefix[i] is the total dosed in m_chunks[0, i)
+  std::vector<double> m_prefix{0.0};
+  /// number of days with a recorded dose
+  size_t m_size = 0;
+};
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__DOSE_LEDGER_HPP_
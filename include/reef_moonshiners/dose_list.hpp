@@ -0,0 +1,156 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__DOSE_LIST_HPP_
+#define REEF_MOONSHINERS__DOSE_LIST_HPP_
+
+#include <reef_moonshiners/dose_schedule.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace reef_moonshiners
+{
+
+/**
+ * @brief An element with a dose on the listed day
+ */
+struct DoseRow
+{
+  /// index of the element in the schedule
+  size_t element = 0;
+  /// dosage in the element's dosing unit
+  double dose = 0.0;
+
+  bool operator==(const DoseRow &) const = default;
+};
+
+enum class DoseRowEditType : uint8_t
+{
+  INSERT = 0,
+  REMOVE = 1,
+  CHANGE = 2
+};
+
+/**
+ * @brief A run of rows inserted, removed or changed
+ */
+struct DoseRowEdit
+{
+  DoseRowEditType type = DoseRowEditType::CHANGE;
+  /// first row of the run, counting the edits before this one
+  size_t row = 0;
+  size_t count = 0;
+
+  bool operator==(const DoseRowEdit &) const = default;
+};
+
+/**
+ * @brief Rows of the elements dosed on a date, in schedule order
+ *
+ * @param schedule Schedule holding the date
+ * @param date Day to list
+ * @param rows Output, one row per element with a dose that day
+ */
+void get_dose_rows(
+  const DoseSchedule & schedule, const std::chrono::year_month_day & date,
+  std::vector<DoseRow> & rows);
+
+/**
+ * @brief Edits turning one list of rows into another
+ *
+ * Both lists must be in schedule order. The edits are in row order, in the
+ * fewest runs, and each one's row counts the edits before it, which is how
+ * Qt's item models signal changes. Apply them in turn with apply_dose_row_edit.
+ *
+ * @param from Rows before
+ * @param to Rows after
+ * @param edits Output, the edits
+ */
+void diff_dose_rows(
+  std::span<const DoseRow> from, std::span<const DoseRow> to, std::vector<DoseRowEdit> & edits);
+
+/**
+ * @brief Apply one edit of diff_dose_rows
+ *
+ * @param rows Rows the earlier edits were applied to
+ * @param edit Next edit
+ * @param to Rows the edits lead to, which inserted and changed rows come from
+ */
+void apply_dose_row_edit(
+  std::vector<DoseRow> & rows, const DoseRowEdit & edit, std::span<const DoseRow> to);
+
+/**
+ * @brief Doses of a set of elements on one day at a time, backed by a schedule
+ *
+ * The schedule spans days around the listed day, so moving the day within it
+ * recomputes nothing; only elements whose generation moved are recomputed.
+ * Moving the day outside it keeps the doses that are the same every day.
+ * Updates are reported as edits, so a view redraws only the rows that changed.
+ */
+class DoseList
+{
+public:
+  /// days the schedule covers before the listed day
+  constexpr static std::chrono::days days_before{7};
+  /// days the schedule covers from the listed day on
+  constexpr static std::chrono::days days_after{56};
+
+  /**
+   * @brief Construct an empty list
+   * @param elements Elements to list, in order, which must outlive the list
+   */
+  explicit DoseList(std::vector<const ElementBase *> elements);
+
+  /**
+   * @brief Compute the rows of a day, without applying them
+   *
+   * @param date Day to list
+   *
+   * @return Edits from the current rows to the day's, for apply
+   */
+  const std::vector<DoseRowEdit> & update(const std::chrono::year_month_day & date);
+
+  /**
+   * @brief Apply the next edit returned by update
+   */
+  void apply(const DoseRowEdit & edit);
+
+  std::span<const DoseRow> get_rows() const;
+
+  const std::chrono::year_month_day & get_date() const;
+
+  size_t get_element_count() const;
+
+  const ElementBase * get_element(const size_t element) const;
+
+  const DoseSchedule & get_schedule() const;
+
+private:
+  std::vector<const ElementBase *> m_elements;
+  DoseSchedule m_schedule;
+  /// generation of each element when its schedule was computed
+  std::vector<uint64_t> m_generations;
+  std::chrono::year_month_day m_date;
+  std::vector<DoseRow> m_rows;
+  /// rows update leads to, and the edits there
+  std::vector<DoseRow> m_next_rows;
+  std::vector<DoseRowEdit> m_edits;
+};
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__DOSE_LIST_HPP_
@@ -0,0 +1,118 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__DOSE_SCHEDULE_HPP_
+#define REEF_MOONSHINERS__DOSE_SCHEDULE_HPP_
+
+#include <reef_moonshiners/element_base.hpp>
+
+#include <chrono>
+#include <span>
+#include <vector>
+
+namespace reef_moonshiners
+{
+
+/**
+ * @brief Doses of a set of elements over a range of days
+ *
+ * The schedule is a dense element x day matrix, filled one element at a time
+ * through ElementBase::fill_doses.
+ */
+class DoseSchedule
+{
+public:
+  DoseSchedule() = default;
+
+  /**
+   * @brief Compute the schedule
+   *
+   * @param start First date of the schedule (inclusive)
+   * @param end Last date of the schedule (exclusive)
+   * @param elements Elements to schedule, which must outlive the schedule
+   */
+  explicit DoseSchedule(
+    const std::chrono::year_month_day & start,
+    const std::chrono::year_month_day & end,
+    std::vector<const ElementBase *> elements);
+
+  /**
+   * @brief Recompute the whole schedule
+   *
+   * Call after changing the elements or their tank.
+   */
+  void update();
+
+  /**
+   * @brief Recompute the schedule of one element
+   * @param element Index of the element
+   */
+  void update(const size_t element);
+
+  /**
+   * @brief Move the schedule to another range of days
+   *
+   * Elements that give the same dose every day keep theirs, so those doses
+   * must be current; the rest are recomputed.
+   *
+   * @param start First date of the schedule (inclusive)
+   * @param end Last date of the schedule (exclusive)
+   */
+  void move(const std::chrono::year_month_day & start, const std::chrono::year_month_day & end);
+
+  const std::chrono::year_month_day & get_start_date() const;
+
+  const std::chrono::year_month_day & get_end_date() const;
+
+  size_t get_day_count() const;
+
+  size_t get_element_count() const;
+
+  const ElementBase * get_element(const size_t element) const;
+
+  /**
+   * @brief Check if a date falls within the schedule
+   * @return true if get_start_date() <= date < get_end_date()
+   */
+  bool contains(const std::chrono::year_month_day & date) const;
+
+  /**
+   * @brief Access the dosage of an element on a date
+   *
+   * @param element Index of the element
+   * @param date Date of the dose, must be within the schedule
+   *
+   * @return Dosage in milliliters
+   */
+  double get_dose(const size_t element, const std::chrono::year_month_day & date) const;
+
+  /**
+   * @brief Access the dosage of an element for every day of the schedule
+   * @param element Index of the element
+   * @return Dosage in milliliters for each day from the start date
+   */
+  std::span<const double> get_doses(const size_t element) const;
+
+private:
+  std::chrono::year_month_day m_start_date;
+  std::chrono::year_month_day m_end_date;
+  size_t m_days = 0;
+  std::vector<const ElementBase *> m_elements;
+  /// m_doses[element * m_days + day]
+  std::vector<double> m_doses;
+};
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__DOSE_SCHEDULE_HPP_
@@ -40,13 +40,15 @@ public:
 
   void set_drops(const size_t _drops);
 
+  size_t get_drops() const;
+
   bool is_low() const;
 
   bool is_high() const;
 
 private:
   /// number of drops to dose
-  size_t m_drops;
+  size_t m_drops = 0;
   /// upper bound for concentration in micrograms per liter
   const double m_high_concentration;
 };
@@ -15,9 +15,15 @@
 #ifndef REEF_MOONSHINERS__ELEMENT_BASE_HPP_
 #define REEF_MOONSHINERS__ELEMENT_BASE_HPP_
 
+#include <reef_moonshiners/binary_io.hpp>
+#include <reef_moonshiners/icp_elements.hpp>
+#include <reef_moonshiners/tank.hpp>
+
 #include <string>
 #include <cmath>
 #include <chrono>
+#include <memory>
+#include <span>
 #include <unordered_map>
 #include <ostream>
 #include <istream>
@@ -65,67 +71,6 @@ inline double liters_to_gallons(const double liters)
   return liters / 3.78541;
 }
 
-template<typename T>
-inline void binary_out(std::ostream & stream, const T & obj)
-{
-  stream.write(
-    reinterpret_cast<const char *>(&obj),
-    sizeof(obj));
-}
-
-template<>
-inline void binary_out<std::string>(std::ostream & stream, const std::string & obj)
-{
-  const size_t len = obj.size();
-  stream.write(reinterpret_cast<const char *>(&len), sizeof(len));
-  stream.write(obj.c_str(), len);
-}
-
-template<typename K, typename V>
-inline void binary_out(std::ostream & stream, const std::unordered_map<K, V> & obj)
-{
-  const size_t len = obj.size();
-  stream.write(reinterpret_cast<const char *>(&len), sizeof(len));
-  for (const auto &[key, value] : obj) {
-    binary_out(stream, key);
-    binary_out(stream, value);
-  }
-}
-
-template<typename T>
-inline void binary_in(std::istream & stream, T & obj)
-{
-  stream.read(
-    reinterpret_cast<char *>(&obj),
-    sizeof(obj));
-}
-
-template<>
-inline void binary_in<std::string>(std::istream & stream, std::string & obj)
-{
-  size_t len;
-  stream.read(reinterpret_cast<char *>(&len), sizeof(len));
-  char * str_in = reinterpret_cast<char *>(calloc(len + 1, sizeof(*str_in)));
-  stream.read(str_in, len);
-  obj = std::string(str_in);
-  free(str_in);
-}
-
-template<typename K, typename V>
-inline void binary_in(std::istream & stream, std::unordered_map<K, V> & obj)
-{
-  size_t len;
-  binary_in(stream, len);
-
-  K key;
-  V value;
-  for (; len-- > 0; ) {
-    binary_in(stream, key);
-    binary_in(stream, value);
-    obj[key] = value;
-  }
-}
-
 enum class DosingUnit : uint8_t
 {
   ML = 0,
@@ -160,6 +105,12 @@ public:
    */
   void set_name(const std::string & _name);
 
+  /**
+   * @brief Identify the element in ICP results
+   * @return The element, or IcpElement::UNKNOWN if ICP analyses do not report it
+   */
+  IcpElement get_icp_element() const;
+
   /**
    * @brief Returns the assumed concentration
    * @return Assumed concentration of this element, in micrograms per liter
@@ -175,6 +126,27 @@ public:
    */
   virtual double get_dose(const std::chrono::year_month_day & day) const = 0;
 
+  /**
+   * @brief Get the dosage for consecutive days
+   *
+   * Equivalent to calling get_dose for each day. Elements override this to
+   * take advantage of the shape of their schedule.
+   *
+   * @param start Date of the first dose
+   * @param doses Output, dosage in milliliters for each day from start
+   */
+  virtual void fill_doses(
+    const std::chrono::year_month_day & start,
+    std::span<double> doses) const;
+
+  /**
+   * @brief Check if get_dose gives the same dose whatever the day
+   *
+   * Such doses only change with the element's generation, so they need not
+   * be recomputed when the day changes.
+   */
+  virtual bool is_same_dose_every_day() const;
+
   /**
    * @brief Mark a dose as done for for the given date in the given ammount
    *
@@ -199,8 +171,40 @@ public:
 
   void set_dosing_unit(const DosingUnit _dosing_unit);
 
+  /**
+   * @brief Volume of the default tank
+   *
+   * Kept for compatibility; prefer get_tank_volume.
+   *
+   * @return Default tank volume in liters
+   */
   static double get_tank_size();
 
+  /**
+   * @brief Volume of the tank this element doses
+   * @return Tank volume in liters
+   */
+  double get_tank_volume() const;
+
+  /**
+   * @brief Set the tank this element doses
+   * @param _tank Tank to dose
+   */
+  void set_tank(std::shared_ptr<Tank> _tank);
+
+  const std::shared_ptr<Tank> & get_tank() const;
+
+  /**
+   * @brief Counter that changes whenever anything affecting this element's
+   *        doses changes, including its tank
+   *
+   * The counters are plain integers, so this must not race with a setter of
+   * the element or its tank.
+   *
+   * @return Current generation of the element
+   */
+  uint64_t get_generation() const;
+
   double get_max_daily_dosage() const;
 
   double get_last_measured_concentration() const;
@@ -211,6 +215,21 @@ public:
 
   double get_element_concentration() const;
 
+  /**
+   * @brief Concentration of the supplement that get_dose measures
+   *
+   * Same units as get_element_concentration, which it defaults to.
+   */
+  virtual double get_dose_concentration() const;
+
+  /**
+   * @brief Set the volume of the default tank
+   *
+   * Kept for compatibility; this affects every element that was not given
+   * its own tank with set_tank.
+   *
+   * @param _tank_size Tank volume in liters
+   */
   static void set_tank_size(const double _tank_size);
 
   /**
@@ -238,6 +257,13 @@ public:
   static size_t m_load_version;
 
 protected:
+  /**
+   * @brief Mark this element as changed
+   *
+   * Call from any setter that affects the element's doses.
+   */
+  void _bump_generation();
+
   double _get_concentration_after_dose(
     const double _dose_ml,
     const double _prior_concentration) const;
@@ -251,14 +277,18 @@ protected:
 private:
   /// name of the element
   std::string m_name;
+  /// element m_name identifies, resolved once rather than on every import
+  IcpElement m_icp_element = IcpElement::UNKNOWN;
   /// concentration in micrograms per liter
   double m_estimated_concentration = 0.0;
   /// last measurement date
   std::chrono::year_month_day m_last_measurement;
   /// last measured concentration
   double m_last_measured_concentration = 0.0;
-  /// tank size (liters)
-  inline static double m_tank_size = 0.0;
+  /// tank this element doses
+  std::shared_ptr<Tank> m_p_tank = Tank::get_default();
+  /// element part of the generation, the tank's generation is added to it
+  uint64_t m_generation = 0;
   /// element concentration in micrograms per liter
   double m_element_concentration;
   /// target concentration in micrograms per liter
@@ -0,0 +1,232 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__FLEET_ARCHIVE_HPP_
+#define REEF_MOONSHINERS__FLEET_ARCHIVE_HPP_
+
+#include <reef_moonshiners/element_base.hpp>
+#include <reef_moonshiners/save_file.hpp>
+#include <reef_moonshiners/tank.hpp>
+
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace reef_moonshiners
+{
+
+/**
+ * @brief State of many tanks, one vector per field
+ *
+ * Elements are grouped by tank and doses by element, in the order they were
+ * added. Dates are days since the epoch.
+ */
+struct FleetColumns
+{
+  /// caller's identifier of each tank
+  std::vector<uint64_t> tank_id;
+  /// tank volume in liters
+  std::vector<double> tank_volume;
+
+  /// row of the tank each element doses
+  std::vector<uint32_t> element_tank;
+  /// index into names
+  std::vector<uint32_t> element_name;
+  std::vector<int32_t> element_measurement_date;
+  /// micrograms per liter
+  std::vector<double> element_measured_concentration;
+  std::vector<double> element_concentration;
+  std::vector<double> element_target_concentration;
+  std::vector<double> element_max_adjustment;
+  /// DosingUnit of each element
+  std::vector<uint8_t> element_dosing_unit;
+  /// daily multiplier, 1 for elements without one
+  std::vector<double> element_multiplier;
+  /// 1 if a daily element doses its nano supplement
+  std::vector<uint8_t> element_nano_dose;
+  /// drops dosed by a dropper element, 0 for others
+  std::vector<uint64_t> element_drops;
+  /// correction start date, or Rubidium's initial dose date, 0 for others
+  std::vector<int32_t> element_start_date;
+  /// Rubidium's RubidiumSelection, 0 for others
+  std::vector<uint8_t> element_frequency;
+
+  /// row of the element each dose was applied to
+  std::vector<uint32_t> dose_element;
+  std::vector<int32_t> dose_date;
+  /// amount dosed in mL
+  std::vector<double> dose_ml;
+
+  /// element names, indexed by element_name
+  std::vector<std::string> names;
+
+  void clear();
+};
+
+/**
+ * @brief Smallest and largest value in a block of a column
+ */
+struct BlockStats
+{
+  double min = 0.0;
+  double max = 0.0;
+};
+
+/**
+ * @brief Columnar archive of a fleet of tanks
+ *
+ * Each field of FleetColumns is stored as its own SaveFile section, named
+ * after the field ("tank/volume", "element/name", "dose/ml", ...), so a
+ * reader can decode one column without touching the rest. Columns are split
+ * into blocks of rows, and each column has an index section ("<column>/index")
+ * holding every block's offset and min/max, so readers can skip blocks that
+ * cannot match.
+ *
+ * Fixed-width columns are stored as their little-endian values. Date columns
+ * store each block's first date followed by the differences between
+ * consecutive dates, at the narrowest width (1, 2 or 4 bytes) that fits the
+ * block; daily dose histories take one byte per date. Element names are
+ * stored once in "element/name/dictionary" and referenced by index.
+ */
+class FleetArchive
+{
+public:
+  /**
+   * @brief Construct an empty archive
+   * @param block_rows Rows per block when writing
+   */
+  explicit FleetArchive(const uint32_t block_rows = default_block_rows);
+
+  /**
+   * @brief Append a tank and its elements
+   *
+   * Besides the measurement, each element's settings are kept: the
+   * correction start date, the daily multiplier and nano dose flag, dropper
+   * drop counts and Rubidium's frequency and initial dose date. Dose
+   * histories are taken from correction elements; other elements do not
+   * keep one.
+   *
+   * @param id Caller's identifier of the tank
+   * @param tank Tank to add
+   * @param elements Elements dosing the tank
+   */
+  void add_tank(
+    const uint64_t id, const Tank & tank,
+    std::span<const ElementBase * const> elements);
+
+  FleetColumns & get_columns();
+
+  const FleetColumns & get_columns() const;
+
+  /**
+   * Serialize the columns
+   * @param stream Where to serialize
+   */
+  void write_to(std::ostream & stream) const;
+
+  /**
+   * @brief Open an archive in memory, such as a MappedFile
+   *
+   * Only the section table and header are read. Use read_column to decode
+   * single columns or load to decode all of them.
+   *
+   * @param bytes Archive written by write_to, which must outlive this
+   *
+   * @return false if bytes is not an archive
+   */
+  bool read_from(std::string_view bytes);
+
+  /**
+   * @brief Decode every column of the archive that was read into get_columns()
+   * @return false if a column is missing or malformed
+   */
+  bool load();
+
+  /**
+   * @brief Decode blocks of a column of the archive that was read
+   *
+   * T must match the column's type in FleetColumns.
+   *
+   * @param name Name of the column
+   * @param values Output, the values of the blocks
+   * @param first_block First block to decode
+   * @param block_count Number of blocks to decode, clamped to the column
+   *
+   * @return false if there is no such column of type T or it is malformed
+   */
+  template<typename T>
+  bool read_column(
+    const std::string & name, std::vector<T> & values,
+    const size_t first_block = 0, const size_t block_count = SIZE_MAX) const;
+
+  /**
+   * @brief Access the block statistics of a column of the archive that was read
+   *
+   * @param name Name of the column
+   * @param stats Output, min and max of each block
+   *
+   * @return false if there is no such column
+   */
+  bool get_block_stats(const std::string & name, std::vector<BlockStats> & stats) const;
+
+  /**
+   * @brief Rows per block of the archive that was read, or to write
+   */
+  uint32_t get_block_rows() const;
+
+  /**
+   * @brief Restore a tank from the columns
+   *
+   * Sets the tank volume, then each element's last measurement, dosing unit,
+   * settings and dose history from the row of the same name. A correction
+   * element's dose history is replaced, not added to. Elements without a row
+   * are left alone, and archives of version 1 carry no settings to restore.
+   *
+   * @param tank_row Row of the tank in get_columns()
+   * @param tank Tank to restore
+   * @param elements Elements dosing the tank
+   *
+   * @return false if there is no such row
+   */
+  bool apply_to(
+    const size_t tank_row, Tank & tank,
+    std::span<ElementBase * const> elements) const;
+
+  /// version of the layout written by write_to
+  constexpr static uint32_t format_version = 2;
+
+  constexpr static uint32_t default_block_rows = 4096;
+
+private:
+  uint32_t _intern(const std::string & name);
+
+  /**
+   * @brief Restore the settings of an element from its row
+   */
+  void _apply_settings(const size_t row, ElementBase & element) const;
+
+  uint32_t m_block_rows;
+  /// version of the archive that was read
+  uint32_t m_version = format_version;
+  FleetColumns m_columns;
+  /// archive that was read
+  SaveFile m_file;
+};
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__FLEET_ARCHIVE_HPP_
@@ -0,0 +1,139 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__ICP_CACHE_HPP_
+#define REEF_MOONSHINERS__ICP_CACHE_HPP_
+
+#include <reef_moonshiners/ati_page.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace reef_moonshiners
+{
+
+/**
+ * @brief What the cache knows about one analysis
+ */
+struct IcpCacheEntry
+{
+  /// ETag of the page, empty if the server sent none
+  std::string etag;
+  /// Last-Modified of the page, empty if the server sent none
+  std::string last_modified;
+  /// when the server last confirmed the page
+  std::chrono::system_clock::time_point validated;
+  /// FNV-1a hash of the page, which names the file it is stored in
+  uint64_t page_hash = 0;
+  uint64_t page_size = 0;
+  /// results parsed from the page
+  IcpConcentrations values;
+};
+
+/**
+ * @brief On-disk cache of fetched ICP analyses
+ *
+ * Raw pages are stored by the hash of their contents, so identical pages are
+ * stored once, and each analysis ID has a record of its page, the validators
+ * the server sent with it and the results parsed from it. Records are written
+ * beside their file and renamed into place, so a crash leaves either the old
+ * record or the new one.
+ *
+ * Layout:
+ *   pages/<page hash>.html
+ *   analyses/<analysis ID>.dat, a SaveFile
+ *
+ * All functions may be called from any thread.
+ */
+class IcpCache
+{
+public:
+  /**
+   * @brief Open a cache, which creates its directories as it stores
+   *
+   * @param directory Where the cache lives
+   */
+  explicit IcpCache(std::filesystem::path directory);
+
+  /**
+   * @brief Look up the record of an analysis
+   *
+   * @param analysis_id Lab's identifier of the analysis
+   * @param entry Output, the record
+   *
+   * @return false if the analysis is not cached, or its record is unreadable
+   */
+  bool lookup(const std::string & analysis_id, IcpCacheEntry & entry) const;
+
+  /**
+   * @brief Read the raw page of a record, such as to parse it again
+   *
+   * @return false if the page is missing or does not match the record
+   */
+  bool load_page(const IcpCacheEntry & entry, std::string & page) const;
+
+  /**
+   * @brief Store a freshly fetched page and its results
+   *
+   * @param analysis_id Lab's identifier of the analysis
+   * @param page Raw page
+   * @param entry Validators, validation time and results; the page hash and
+   *              size are filled in from page
+   *
+   * @return false if the cache could not be written
+   */
+  bool store(const std::string & analysis_id, std::string_view page, IcpCacheEntry entry);
+
+  /**
+   * @brief Record that the server confirmed a cached page, such as with a 304
+   *
+   * @return false if the analysis is not cached or could not be updated
+   */
+  bool mark_validated(
+    const std::string & analysis_id,
+    const std::chrono::system_clock::time_point validated);
+
+  /**
+   * @brief IDs of every cached analysis
+   */
+  std::vector<std::string> get_analysis_ids() const;
+
+  /**
+   * @brief FNV-1a hash of a page
+   */
+  static uint64_t hash_page(std::string_view page);
+
+private:
+  /// path of the record of an analysis; IDs are escaped to be safe file names
+  std::filesystem::path _record_path(const std::string & analysis_id) const;
+
+  std::filesystem::path _page_path(const uint64_t page_hash) const;
+
+  bool _read_record(const std::string & analysis_id, IcpCacheEntry & entry) const;
+
+  bool _write_record(const std::string & analysis_id, const IcpCacheEntry & entry);
+
+  std::filesystem::path m_directory;
+  /// serializes access to the files of the cache
+  mutable std::mutex m_mutex;
+};
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__ICP_CACHE_HPP_
@@ -0,0 +1,256 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__ICP_ELEMENTS_HPP_
+#define REEF_MOONSHINERS__ICP_ELEMENTS_HPP_
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace reef_moonshiners
+{
+
+/// element name -> concentration in micrograms per liter
+using IcpConcentrations = std::unordered_map<std::string, double>;
+
+/**
+ * @brief Dense identifier of each element an ICP analysis reports
+ */
+enum class IcpElement : uint8_t
+{
+  LITHIUM, BERYLLIUM, BORON, FLUORINE, SODIUM, MAGNESIUM, ALUMINIUM, SILICON,
+  PHOSPHORUS, SULFUR, POTASSIUM, CALCIUM, SCANDIUM, TITANIUM, VANADIUM, CHROMIUM,
+  MANGANESE, IRON, COBALT, NICKEL, COPPER, ZINC, ARSENIC, SELENIUM,
+  BROMINE, RUBIDIUM, STRONTIUM, ZIRCONIUM, MOLYBDENUM, SILVER, CADMIUM, TIN,
+  ANTIMONY, IODINE, BARIUM, LANTHANUM, CERIUM, TUNGSTEN, PLATINUM, GOLD,
+  MERCURY, THALLIUM, LEAD, BISMUTH, URANIUM,
+  /// not an element, or not one an analysis reports
+  UNKNOWN
+};
+
+constexpr size_t icp_element_count = static_cast<size_t>(IcpElement::UNKNOWN);
+
+/// name of each element, as ElementBase::get_name spells it
+constexpr std::array<std::string_view, icp_element_count> icp_element_names{
+  "Lithium", "Beryllium", "Boron", "Fluorine", "Sodium", "Magnesium", "Aluminium", "Silicon",
+  "Phosphorus", "Sulfur", "Potassium", "Calcium", "Scandium", "Titanium", "Vanadium", "Chromium",
+  "Manganese", "Iron", "Cobalt", "Nickel", "Copper", "Zinc", "Arsenic", "Selenium",
+  "Bromine", "Rubidium", "Strontium", "Zirconium", "Molybdenum", "Silver", "Cadmium", "Tin",
+  "Antimony", "Iodine", "Barium", "Lanthanum", "Cerium", "Tungsten", "Platinum", "Gold",
+  "Mercury", "Thallium", "Lead", "Bismuth", "Uranium"};
+
+/// symbol of each element, which some labs report instead of its name
+constexpr std::array<std::string_view, icp_element_count> icp_element_symbols{
+  "Li", "Be", "B", "F", "Na", "Mg", "Al", "Si",
+  "P", "S", "K", "Ca", "Sc", "Ti", "V", "Cr",
+  "Mn", "Fe", "Co", "Ni", "Cu", "Zn", "As", "Se",
+  "Br", "Rb", "Sr", "Zr", "Mo", "Ag", "Cd", "Sn",
+  "Sb", "I", "Ba", "La", "Ce", "W", "Pt", "Au",
+  "Hg", "Tl", "Pb", "Bi", "U"};
+
+struct IcpElementAlias
+{
+  std::string_view name;
+  IcpElement element;
+};
+
+/// other spellings of element names in use by labs
+constexpr std::array<IcpElementAlias, 4> icp_element_spellings{{
+  {"Aluminum", IcpElement::ALUMINIUM},
+  {"Sulphur", IcpElement::SULFUR},
+  {"Wolfram", IcpElement::TUNGSTEN},
+  {"Phosphorous", IcpElement::PHOSPHORUS}}};
+
+/**
+ * @brief Every name an element is known by
+ */
+constexpr auto icp_element_aliases = []() {
+    std::array<IcpElementAlias, 2 * icp_element_count + icp_element_spellings.size()> aliases{};
+    size_t size = 0;
+    for (size_t x = 0; x < icp_element_count; ++x) {
+      aliases[size++] = {icp_element_names[x], static_cast<IcpElement>(x)};
+      aliases[size++] = {icp_element_symbols[x], static_cast<IcpElement>(x)};
+    }
+    for (const auto & spelling : icp_element_spellings) {
+      aliases[size++] = spelling;
+    }
+    return aliases;
+  }();
+
+constexpr char fold_icp_case(const char c)
+{
+  return ('A' <= c && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+/**
+ * @brief FNV-1a over the lower-cased name, then mixed so every bit counts
+ */
+constexpr uint32_t hash_icp_name(const std::string_view name, const uint32_t seed)
+{
+  uint32_t hash = 2166136261u ^ seed;
+  for (const char c : name) {
+    hash ^= static_cast<uint8_t>(fold_icp_case(c));
+    hash *= 16777619u;
+  }
+  hash ^= hash >> 16;
+  hash *= 0x7feb352du;
+  hash ^= hash >> 15;
+  return hash;
+}
+
+/**
+ * @brief Perfect hash table of icp_element_aliases, built at compile time
+ *
+ * Each alias hashes to its own slot under the seed, so a lookup is one hash
+ * and one comparison. A slot holds the index of its alias plus one, and 0
+ * when it is empty.
+ */
+struct IcpNameTable
+{
+  constexpr static size_t size = 4096;
+  uint32_t seed = 0;
+  bool valid = false;
+  std::array<uint8_t, size> slots{};
+};
+
+constexpr IcpNameTable icp_name_table = []() {
+    static_assert(icp_element_aliases.size() < 255, "slots must fit in a byte");
+    for (uint32_t seed = 0; seed < 1000; ++seed) {
+      IcpNameTable table;
+      table.seed = seed;
+      table.valid = true;
+      for (size_t x = 0; x < icp_element_aliases.size() && table.valid; ++x) {
+        auto & slot = table.slots[
+          hash_icp_name(icp_element_aliases[x].name, seed) % IcpNameTable::size];
+        table.valid = (0 == slot);
+        slot = static_cast<uint8_t>(x + 1);
+      }
+      if (table.valid) {
+        return table;
+      }
+    }
+    return IcpNameTable{};
+  }();
+static_assert(icp_name_table.valid, "no perfect hash of the element names was found");
+
+/**
+ * @brief Identify an element by any of its names, ignoring case
+ *
+ * @param name Name, symbol or other spelling of the element
+ *
+ * @return The element, or IcpElement::UNKNOWN
+ */
+constexpr IcpElement find_icp_element(const std::string_view name)
+{
+  const uint8_t slot =
+    icp_name_table.slots[hash_icp_name(name, icp_name_table.seed) % IcpNameTable::size];
+  if (0 == slot) {
+    return IcpElement::UNKNOWN;
+  }
+  const IcpElementAlias & alias = icp_element_aliases[slot - 1];
+  if (alias.name.size() != name.size()) {
+    return IcpElement::UNKNOWN;
+  }
+  for (size_t x = 0; x < name.size(); ++x) {
+    if (fold_icp_case(alias.name[x]) != fold_icp_case(name[x])) {
+      return IcpElement::UNKNOWN;
+    }
+  }
+  return alias.element;
+}
+
+constexpr std::string_view get_icp_element_name(const IcpElement element)
+{
+  return (IcpElement::UNKNOWN == element) ?
+         std::string_view{"Unknown"} : icp_element_names[static_cast<size_t>(element)];
+}
+
+/**
+ * @brief Results of an ICP analysis, one slot per element
+ */
+class IcpResults
+{
+public:
+  /**
+   * @brief Record a result, replacing any earlier one for the element
+   * @return false if the element is unknown
+   */
+  bool set(const IcpElement element, const double value)
+  {
+    if (IcpElement::UNKNOWN == element) {
+      return false;
+    }
+    m_values[static_cast<size_t>(element)] = value;
+    m_measured.set(static_cast<size_t>(element));
+    return true;
+  }
+
+  /**
+   * @brief Check if the analysis reported an element
+   */
+  bool contains(const IcpElement element) const
+  {
+    return IcpElement::UNKNOWN != element && m_measured.test(static_cast<size_t>(element));
+  }
+
+  /**
+   * @brief Result for an element in micrograms per liter, 0 if not reported
+   */
+  double get(const IcpElement element) const
+  {
+    return this->contains(element) ? m_values[static_cast<size_t>(element)] : 0.0;
+  }
+
+  /**
+   * @brief Number of elements reported
+   */
+  size_t size() const
+  {
+    return m_measured.count();
+  }
+
+  void clear()
+  {
+    m_measured.reset();
+  }
+
+private:
+  std::array<double, icp_element_count> m_values{};
+  std::bitset<icp_element_count> m_measured;
+};
+
+/**
+ * @brief Resolve results keyed by name
+ *
+ * @param values Results by name, symbol or other spelling
+ * @param results Output, the results of known elements
+ * @param unknown Output, names that are not known elements
+ */
+void resolve_icp_results(
+  const IcpConcentrations & values, IcpResults & results,
+  std::vector<std::string> & unknown);
+
+/**
+ * @brief Key results by the elements' names
+ */
+void get_icp_concentrations(const IcpResults & results, IcpConcentrations & values);
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__ICP_ELEMENTS_HPP_
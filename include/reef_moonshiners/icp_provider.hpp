@@ -0,0 +1,163 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__ICP_PROVIDER_HPP_
+#define REEF_MOONSHINERS__ICP_PROVIDER_HPP_
+
+#include <reef_moonshiners/icp_elements.hpp>
+
+#include <chrono>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace reef_moonshiners
+{
+
+/**
+ * @brief Everything read from one ICP report
+ */
+struct IcpReport
+{
+  IcpResults results;
+  /// date the sample was taken, if the report says
+  std::optional<std::chrono::year_month_day> collection_date;
+  /// names in the report that are not known elements, viewing the report
+  std::vector<std::string_view> unknown;
+
+  void clear();
+};
+
+/**
+ * @brief Parser of one lab's ICP reports
+ *
+ * Every provider produces the same IcpResults, in micrograms per liter, so
+ * the rest of the application does not care where a report came from.
+ * Parsing is stateless, so one provider may parse on many threads at once.
+ */
+class IcpProvider
+{
+public:
+  virtual ~IcpProvider() = default;
+
+  /**
+   * @brief Name of the report format, as shown to the user
+   */
+  virtual std::string_view get_name() const = 0;
+
+  /**
+   * @brief Check if the reports are local files, rather than fetched online
+   */
+  virtual bool is_file_based() const = 0;
+
+  /**
+   * @brief Parse a report
+   *
+   * @param text The whole report, which report.unknown views
+   * @param report Output, what the report holds
+   * @param error Output, reason the report could not be parsed
+   *
+   * @return false if the report is malformed or holds no results
+   */
+  virtual bool parse(std::string_view text, IcpReport & report, std::string & error) const = 0;
+};
+
+/**
+ * @brief ATI analysis pages, as fetched from the lab's site
+ */
+class AtiIcpProvider final : public IcpProvider
+{
+public:
+  std::string_view get_name() const override;
+  bool is_file_based() const override;
+  bool parse(std::string_view text, IcpReport & report, std::string & error) const override;
+};
+
+/**
+ * @brief CSV exports of results
+ *
+ * The delimiter is whichever of ',', ';' or tab the header uses most.
+ * Exports are either long, with a row per element:
+ *
+ *   Element,Value,Unit
+ *   Zinc,3.2,ug/L
+ *
+ * or wide, with a column per element and the unit in the header:
+ *
+ *   Date,Zinc (ug/L),Sodium [mg/L]
+ *   2022-09-14,3.2,10.9
+ *
+ * Elements may be named or given as symbols. A "Date" column in ISO form
+ * gives the collection date. Values may use a decimal comma, and values that
+ * are empty, "n/a", "nd" or below the detection limit ("<0.1") are skipped.
+ * Values without a unit are in micrograms per liter; "mg/L" and "ppm" are
+ * converted. Blank lines and lines starting with '#' are ignored.
+ */
+class CsvIcpProvider final : public IcpProvider
+{
+public:
+  std::string_view get_name() const override;
+  bool is_file_based() const override;
+  bool parse(std::string_view text, IcpReport & report, std::string & error) const override;
+};
+
+/**
+ * @brief JSON exports of results
+ *
+ * Either an object of results by element, or an array of results:
+ *
+ *   {"date": "2022-09-14", "Zinc": 3.2, "Na": {"value": 10.9, "unit": "mg/L"}}
+ *   [{"element": "Zinc", "value": 3.2, "unit": "ug/L"}]
+ *
+ * An object may also hold its results under "results". Values and units are
+ * read as for CsvIcpProvider, and null values are skipped.
+ */
+class JsonIcpProvider final : public IcpProvider
+{
+public:
+  std::string_view get_name() const override;
+  bool is_file_based() const override;
+  bool parse(std::string_view text, IcpReport & report, std::string & error) const override;
+};
+
+/**
+ * @brief Every provider, the online ones first
+ */
+std::span<const IcpProvider * const> get_icp_providers();
+
+/**
+ * @brief Convert a unit to micrograms per liter
+ *
+ * @param unit Such as "ug/L", "mg/L", "ppb" or "ppm", in any case; empty
+ *             means micrograms per liter
+ *
+ * @return Factor to multiply by, or 0 if the unit is not known
+ */
+double get_icp_unit_scale(std::string_view unit);
+
+/**
+ * @brief Parse a result with std::from_chars
+ *
+ * @param text Number, which may use a decimal comma
+ * @param value Output, the number
+ *
+ * @return false if text is not a number
+ */
+bool parse_icp_value(std::string_view text, double & value);
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__ICP_PROVIDER_HPP_
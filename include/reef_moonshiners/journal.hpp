@@ -0,0 +1,107 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__JOURNAL_HPP_
+#define REEF_MOONSHINERS__JOURNAL_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace reef_moonshiners
+{
+
+enum class JournalEntryType : uint8_t
+{
+  APPLY_DOSE = 0,
+  SET_CONCENTRATION,
+  SET_CORRECTION_START_DATE,
+  SET_SETTING,
+};
+
+struct JournalEntry
+{
+  JournalEntryType type = JournalEntryType::SET_SETTING;
+  /// element name, or setting name for SET_SETTING
+  std::string key;
+  std::chrono::year_month_day date;
+  double value = 0.0;
+};
+
+/**
+ * @brief Append-only log of changes made since the last save
+ *
+ * Each change costs one small write at the end of the file. Entries carry a
+ * checksum, so an entry torn by a crash is dropped when the journal is
+ * replayed, along with anything after it. Once the state has been saved in
+ * full the journal is cleared.
+ *
+ * Every entry sets a value rather than adjusting one, so replaying entries
+ * that were already saved is harmless.
+ */
+class Journal
+{
+public:
+  /**
+   * @brief Construct a journal
+   * @param path File to keep the journal in, created on the first append
+   */
+  explicit Journal(std::filesystem::path path);
+
+  const std::filesystem::path & get_path() const;
+
+  /**
+   * @brief Read the entries of the journal
+   *
+   * A torn or corrupt entry ends the journal, and is cut off so that later
+   * appends can be read back.
+   *
+   * @return Intact entries, oldest first
+   */
+  std::vector<JournalEntry> replay();
+
+  /**
+   * @brief Append an entry and flush it to the file
+   * @return false if the entry could not be written
+   */
+  bool append(const JournalEntry & entry);
+
+  /**
+   * @brief Number of entries since the journal was last cleared
+   */
+  size_t get_entry_count() const;
+
+  /**
+   * @brief Remove every entry, once they are part of a full save
+   * @return false if the journal could not be truncated
+   */
+  bool clear();
+
+  /// longest key accepted by replay
+  constexpr static size_t max_key_length = 256;
+
+private:
+  bool _open();
+
+  std::filesystem::path m_path;
+  std::ofstream m_stream;
+  size_t m_entries = 0;
+};
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__JOURNAL_HPP_
@@ -0,0 +1,190 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__JSON_SCANNER_HPP_
+#define REEF_MOONSHINERS__JSON_SCANNER_HPP_
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <string_view>
+#include <system_error>
+
+namespace reef_moonshiners
+{
+
+/**
+ * @brief Forward-only reader of JSON in memory
+ *
+ * Reads values in place without building a document. Strings are returned
+ * as views of the input with their escapes left in place, which is all that
+ * is needed to match keys and element names. Every read returns false on
+ * malformed or truncated input rather than reading past the end.
+ */
+class JsonScanner
+{
+public:
+  /// deepest nesting skip_value descends into
+  constexpr static size_t max_depth = 32;
+
+  JsonScanner(const char * begin, const char * end)
+  : m_pos(begin),
+    m_end(end)
+  {
+  }
+
+  bool peek(const char c)
+  {
+    this->_skip_space();
+    return m_pos != m_end && *m_pos == c;
+  }
+
+  /**
+   * @brief Check if only whitespace is left
+   */
+  bool at_end()
+  {
+    this->_skip_space();
+    return m_pos == m_end;
+  }
+
+  bool consume(const char c)
+  {
+    if (!this->peek(c)) {
+      return false;
+    }
+    ++m_pos;
+    return true;
+  }
+
+  bool consume_null()
+  {
+    this->_skip_space();
+    constexpr std::string_view null{"null"};
+    if (static_cast<size_t>(m_end - m_pos) < null.size() ||
+      std::string_view{m_pos, null.size()} != null)
+    {
+      return false;
+    }
+    m_pos += null.size();
+    return true;
+  }
+
+  /**
+   * @brief Read a string, without unescaping it
+   */
+  bool string(std::string_view & out)
+  {
+    if (!this->consume('"')) {
+      return false;
+    }
+    const char * start = m_pos;
+    for (; m_pos != m_end && *m_pos != '"'; ++m_pos) {
+      if (*m_pos == '\\' && ++m_pos == m_end) {
+        return false;
+      }
+    }
+    if (m_pos == m_end) {
+      return false;
+    }
+    out = std::string_view{start, static_cast<size_t>(m_pos - start)};
+    ++m_pos;
+    return true;
+  }
+
+  /// a number, or a number in a string
+  bool number(double & out)
+  {
+    if (this->peek('"')) {
+      std::string_view text;
+      if (!this->string(text)) {
+        return false;
+      }
+      const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+      return std::errc{} == ec && end == text.data() + text.size();
+    }
+    const auto [end, ec] = std::from_chars(m_pos, m_end, out);
+    if (std::errc{} != ec) {
+      return false;
+    }
+    m_pos = end;
+    return true;
+  }
+
+  /**
+   * @brief Skip over any value
+   * @param depth Nesting of the value, up to max_depth
+   */
+  bool skip_value(const size_t depth)
+  {
+    this->_skip_space();
+    if (depth > max_depth || m_pos == m_end) {
+      return false;
+    }
+    std::string_view text;
+    switch (*m_pos) {
+      case '"':
+        return this->string(text);
+      case '{':
+        ++m_pos;
+        if (this->consume('}')) {
+          return true;
+        }
+        do {
+          if (!this->string(text) || !this->consume(':') || !this->skip_value(depth + 1)) {
+            return false;
+          }
+        } while (this->consume(','));
+        return this->consume('}');
+      case '[':
+        ++m_pos;
+        if (this->consume(']')) {
+          return true;
+        }
+        do {
+          if (!this->skip_value(depth + 1)) {
+            return false;
+          }
+        } while (this->consume(','));
+        return this->consume(']');
+      default: {
+          /* number or literal */
+          const char * start = m_pos;
+          m_pos = std::find_if(
+            m_pos, m_end, [](const char c) {
+              return !(('a' <= c && c <= 'z') || ('0' <= c && c <= '9') ||
+              'E' == c || '+' == c || '-' == c || '.' == c);
+            });
+          return m_pos != start;
+        }
+    }
+  }
+
+private:
+  void _skip_space()
+  {
+    while (m_pos != m_end && (' ' == *m_pos || '\n' == *m_pos || '\r' == *m_pos ||
+      '\t' == *m_pos))
+    {
+      ++m_pos;
+    }
+  }
+
+  const char * m_pos;
+  const char * m_end;
+};
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__JSON_SCANNER_HPP_
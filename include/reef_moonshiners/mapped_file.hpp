@@ -0,0 +1,117 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__MAPPED_FILE_HPP_
+#define REEF_MOONSHINERS__MAPPED_FILE_HPP_
+
+#include <filesystem>
+#include <istream>
+#include <streambuf>
+#include <string_view>
+#include <vector>
+
+namespace reef_moonshiners
+{
+
+/**
+ * @brief Read-only view of a whole file
+ *
+ * The file is memory mapped where the platform supports it, so pages are only
+ * read as they are touched. Elsewhere the file is read into memory once.
+ */
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile & operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile && other) noexcept;
+  MappedFile & operator=(MappedFile && other) noexcept;
+
+  /**
+   * @brief Map a file, closing any file that was mapped before
+   * @return false if the file could not be opened
+   */
+  bool open(const std::filesystem::path & path);
+
+  void close();
+
+  bool is_open() const;
+
+  /**
+   * @brief Check if the file is mapped, rather than read into memory
+   */
+  bool is_mapped() const;
+
+  /**
+   * @brief Contents of the file, valid until it is closed
+   */
+  std::string_view get_data() const;
+
+private:
+  const char * m_data = nullptr;
+  size_t m_size = 0;
+  bool m_open = false;
+  bool m_mapped = false;
+  /// contents of the file, where it could not be mapped
+  std::vector<char> m_buffer;
+};
+
+/**
+ * @brief Stream buffer over memory owned by someone else
+ *
+ * Reads copy straight out of the memory, and seeking is supported, so the
+ * existing read_from functions can run over a MappedFile.
+ */
+class MemoryStreamBuffer : public std::streambuf
+{
+public:
+  explicit MemoryStreamBuffer(std::string_view data);
+
+protected:
+  pos_type seekoff(
+    off_type offset, std::ios_base::seekdir direction,
+    std::ios_base::openmode mode) override;
+
+  pos_type seekpos(pos_type position, std::ios_base::openmode mode) override;
+};
+
+/**
+ * @brief Input stream over memory owned by someone else
+ */
+class MemoryStream : public std::istream
+{
+public:
+  explicit MemoryStream(std::string_view data);
+
+private:
+  MemoryStreamBuffer m_buffer;
+};
+
+/**
+ * @brief Replace a file in one step, by writing beside it and renaming
+ *
+ * The parent directory is created if it does not exist. The new contents and
+ * the rename are synced to disk before returning, so a journal holding the
+ * same changes can be cleared once this returns true.
+ *
+ * @return false if the file could not be written, renamed or synced
+ */
+bool replace_file(const std::filesystem::path & path, std::string_view bytes);
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__MAPPED_FILE_HPP_
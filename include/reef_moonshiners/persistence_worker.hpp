@@ -0,0 +1,141 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__PERSISTENCE_WORKER_HPP_
+#define REEF_MOONSHINERS__PERSISTENCE_WORKER_HPP_
+
+#include <reef_moonshiners/journal.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace reef_moonshiners
+{
+
+/**
+ * @brief Writes journal entries and snapshots on a background thread
+ *
+ * Callers hand over entries and serialized snapshots, which the worker owns
+ * from then on, so nothing it writes is shared with the caller. Writes wait
+ * until nothing has been submitted for the debounce window. Within that window
+ * an entry replaces an earlier one for the same setting or date, and a
+ * snapshot replaces an earlier snapshot.
+ *
+ * Entries are appended to the journal before any later snapshot is written,
+ * and the journal is cleared once a snapshot is written, so a crash at any
+ * point leaves a snapshot and a journal that replay to the latest state.
+ * An entry that cannot be appended is only safe once a snapshot holding it
+ * is written, so the worker asks the caller for one.
+ */
+class PersistenceWorker
+{
+public:
+  /// writes a snapshot, returning false on failure
+  using SnapshotWriter = std::function<bool(const std::string & snapshot)>;
+  /// asks the caller to save() a snapshot of its full state
+  using SnapshotRequest = std::function<void()>;
+
+  /**
+   * @brief Start the worker
+   *
+   * @param journal Journal to append to, replayed by the caller beforehand
+   * @param writer Called on the worker thread to write each snapshot
+   * @param window Time without submissions to wait for before writing
+   * @param request Called on the worker thread when an entry could not be
+   *   journaled and no snapshot written after it holds it
+   */
+  explicit PersistenceWorker(
+    Journal journal, SnapshotWriter writer,
+    const std::chrono::milliseconds window,
+    SnapshotRequest request = {});
+
+  /**
+   * @brief Write whatever is still pending, then stop the worker
+   */
+  ~PersistenceWorker();
+
+  PersistenceWorker(const PersistenceWorker &) = delete;
+  PersistenceWorker & operator=(const PersistenceWorker &) = delete;
+
+  /**
+   * @brief Queue an entry for the journal
+   */
+  void append(JournalEntry entry);
+
+  /**
+   * @brief Queue a snapshot of the full state
+   * @param snapshot Serialized state, including every entry appended so far
+   */
+  void save(std::string snapshot);
+
+  /**
+   * @brief Write everything queued so far without waiting out the window
+   *
+   * Blocks until the writes are done.
+   */
+  void flush();
+
+  /**
+   * @brief Number of snapshots written
+   */
+  size_t get_snapshot_count() const;
+
+  /**
+   * @brief Number of entries that could not be appended to the journal
+   */
+  size_t get_append_failure_count() const;
+
+private:
+  struct Task
+  {
+    /// true for a snapshot, false for a journal entry
+    bool is_snapshot = false;
+    JournalEntry entry;
+    std::string snapshot;
+  };
+
+  void _run();
+
+  /// write a batch of tasks, called without m_mutex held
+  void _write(std::vector<Task> & tasks);
+
+  Journal m_journal;
+  SnapshotWriter m_writer;
+  SnapshotRequest m_request;
+  std::chrono::milliseconds m_window;
+
+  mutable std::mutex m_mutex;
+  /// signals the worker of new tasks, a flush or a stop
+  std::condition_variable m_wake;
+  /// signals flush() that the queue drained
+  std::condition_variable m_drained;
+  std::vector<Task> m_pending;
+  std::chrono::steady_clock::time_point m_last_submit;
+  bool m_writing = false;
+  size_t m_flushes = 0;
+  bool m_stopping = false;
+  size_t m_snapshots = 0;
+  size_t m_append_failures = 0;
+
+  std::thread m_thread;
+};
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__PERSISTENCE_WORKER_HPP_
@@ -2,6 +2,9 @@
 #define REEF_MOONSHINERS__RUBIDIUM_ELEMENT_HPP_
 #include <reef_moonshiners/daily_element.hpp>
 
+#include <optional>
+#include <vector>
+
 namespace reef_moonshiners
 {
 
@@ -29,6 +32,26 @@ public:
 
   double get_dose(const std::chrono::year_month_day & date) const final;
 
+  void fill_doses(
+    const std::chrono::year_month_day & start,
+    std::span<double> doses) const final;
+
+  bool is_same_dose_every_day() const final;
+
+  /**
+   * @brief Doses for a range of dates
+   *
+   * Equivalent to calling get_dose for each date, see fill_doses.
+   *
+   * @param start First date of the range (inclusive)
+   * @param end Last date of the range (exclusive)
+   *
+   * @return Dosage in milliliters for each date in [start, end)
+   */
+  std::vector<double> get_doses(
+    const std::chrono::year_month_day & start,
+    const std::chrono::year_month_day & end) const;
+
   RubidiumSelection get_dosing_frequency() const;
 
   void write_to(std::ostream & stream) const final;
@@ -36,12 +59,22 @@ public:
   void read_from(std::istream & stream) final;
 
 private:
+  double _get_target_concentration(const RubidiumSelection selection) const;
+
+  /**
+   * @brief Which dose falls on a date
+   * @return INITIAL on the initial dose date, the dosing frequency on
+   *         scheduled dose days, and nothing otherwise
+   */
+  std::optional<RubidiumSelection> _get_dose_selection(
+    const std::chrono::year_month_day & date) const;
+
   const double m_daily_concentration = 0.0011E3;
   const double m_monthly_concentration = 0.033E3;
   const double m_quarterly_concentration = 0.1E3;
   const double m_initial_concentration = 0.2E3;
 
-  mutable RubidiumSelection m_dosing_frequency = RubidiumSelection::DAILY;
+  RubidiumSelection m_dosing_frequency = RubidiumSelection::DAILY;
   std::chrono::year_month_day m_initial_rubidium_dose_date;
 };
 
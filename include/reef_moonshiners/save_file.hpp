@@ -0,0 +1,146 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__SAVE_FILE_HPP_
+#define REEF_MOONSHINERS__SAVE_FILE_HPP_
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace reef_moonshiners
+{
+
+/**
+ * @brief Save file made of named sections
+ *
+ * The file begins with a table of every section's name, offset and size,
+ * followed by the sections themselves in the order of their names. Writing
+ * the same sections always produces the same bytes, and a reader can seek to
+ * the sections it wants and skip those it does not know.
+ *
+ * Layout:
+ *   uint32_t section count
+ *   per section: uint64_t name length, name, uint64_t offset, uint64_t size
+ *   section data
+ *
+ * Offsets are from the start of the table.
+ */
+class SaveFile
+{
+public:
+  /**
+   * @brief Add a section, replacing any prior section of the same name
+   *
+   * @param name Name of the section
+   *
+   * @return Stream to serialize the section into, valid until the next call
+   */
+  std::ostream & add_section(const std::string & name);
+
+  /**
+   * Serialize the sections added with add_section
+   * @param stream Where to serialize
+   */
+  void write_to(std::ostream & stream) const;
+
+  /**
+   * @brief Read the section table, leaving the sections on the stream
+   *
+   * @param stream Where to read from, positioned at the start of the table
+   *
+   * @return false if the table is malformed or runs past the end of the stream
+   */
+  bool read_from(std::istream & stream);
+
+  /**
+   * @brief Read the section table from memory, such as a MappedFile
+   *
+   * @param bytes Save file starting at the table, which must outlive this
+   *
+   * @return false if the table is malformed or runs past the end of bytes
+   */
+  bool read_from(std::string_view bytes);
+
+  /**
+   * @brief View a section in place, after read_from(std::string_view)
+   * @return Bytes of the section, empty if there is no such section
+   */
+  std::string_view get_section(const std::string & name) const;
+
+  /**
+   * @brief Check if a section was read
+   */
+  bool contains(const std::string & name) const;
+
+  /**
+   * @brief Names of the sections that were read
+   */
+  std::vector<std::string> get_section_names() const;
+
+  /**
+   * @brief Size of a section that was read
+   * @return Size in bytes, 0 if there is no such section
+   */
+  uint64_t get_section_size(const std::string & name) const;
+
+  /**
+   * @brief Position a stream at the start of a section
+   *
+   * @param stream Stream passed to read_from
+   * @param name Name of the section
+   *
+   * @return false if there is no such section
+   */
+  bool seek(std::istream & stream, const std::string & name) const;
+
+  /**
+   * @brief Read a whole section
+   *
+   * @param stream Stream passed to read_from
+   * @param name Name of the section
+   * @param data Where to store the bytes of the section
+   *
+   * @return false if there is no such section or it could not be read
+   */
+  bool read_section(std::istream & stream, const std::string & name, std::string & data) const;
+
+  /// longest section name accepted by read_from
+  constexpr static uint64_t max_name_length = 256;
+
+private:
+  struct Section
+  {
+    uint64_t offset = 0;
+    uint64_t size = 0;
+  };
+
+  /// sections to write, by name
+  std::map<std::string, std::ostringstream> m_pending;
+  /// sections that were read, by name
+  std::map<std::string, Section> m_sections;
+  /// stream position of the start of the table that was read
+  std::streamoff m_base = 0;
+  /// save file that was read from memory
+  std::string_view m_bytes;
+};
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__SAVE_FILE_HPP_
@@ -0,0 +1,77 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__TANK_HPP_
+#define REEF_MOONSHINERS__TANK_HPP_
+
+#include <cstdint>
+#include <memory>
+
+namespace reef_moonshiners
+{
+
+/**
+ * @brief The system being dosed
+ *
+ * Elements hold a reference to the tank they dose, so elements of different
+ * tanks can be evaluated independently (and concurrently). A tank must not
+ * be modified while its elements are being read.
+ */
+class Tank
+{
+public:
+  /**
+   * @brief Construct a tank
+   * @param _volume Tank volume in liters
+   */
+  explicit Tank(const double _volume = 0.0);
+
+  /**
+   * @brief Access the tank volume
+   * @return Volume in liters
+   */
+  double get_volume() const;
+
+  /**
+   * @brief Set the tank volume
+   * @param _volume Volume in liters
+   */
+  void set_volume(const double _volume);
+
+  /**
+   * @brief Counter that changes whenever the tank changes
+   * @return Current generation of the tank
+   */
+  uint64_t get_generation() const;
+
+  /**
+   * @brief Tank shared by elements that were never assigned one
+   *
+   * This backs the static ElementBase::set_tank_size and
+   * ElementBase::get_tank_size.
+   *
+   * @return The default tank
+   */
+  static const std::shared_ptr<Tank> & get_default();
+
+private:
+  /// tank volume (liters)
+  double m_volume;
+  /// incremented on every change
+  uint64_t m_generation = 0;
+};
+
+}  // namespace reef_moonshiners
+
+#endif  // REEF_MOONSHINERS__TANK_HPP_
@@ -0,0 +1,83 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__UI__DOSE_LIST_MODEL_HPP_
+#define REEF_MOONSHINERS__UI__DOSE_LIST_MODEL_HPP_
+
+#include <QAbstractListModel>
+#include <QDate>
+#include <QModelIndex>
+#include <QObject>
+#include <QString>
+#include <QVariant>
+
+#include <reef_moonshiners/dose_list.hpp>
+
+#include <vector>
+
+namespace reef_moonshiners::ui
+{
+
+/**
+ * @brief Doses of the selected day, one row per element with a dose
+ *
+ * Rows come from a DoseList, so changing the day or an element recomputes
+ * only what changed, and the view is told exactly which rows were inserted,
+ * removed or changed. Painting reads the cached rows and never the dosing
+ * math. Each element's row can be checked off, which survives the row
+ * leaving and rejoining the list.
+ */
+class DoseListModel : public QAbstractListModel
+{
+  Q_OBJECT
+
+public:
+  /**
+   * @brief Construct an empty model, until set_date is called
+   *
+   * @param elements Elements to list, in order, which must outlive the model
+   * @param parent Owner of the model
+   */
+  explicit DoseListModel(
+    std::vector<const reef_moonshiners::ElementBase *> elements, QObject * parent = nullptr);
+  ~DoseListModel() override = default;
+
+  int rowCount(const QModelIndex & parent = QModelIndex{}) const override;
+
+  QVariant data(const QModelIndex & index, int role = Qt::DisplayRole) const override;
+
+  Qt::ItemFlags flags(const QModelIndex & index) const override;
+
+  /**
+   * @brief List the doses of a day
+   *
+   * Also picks up changes to the elements since the last call, so call it
+   * again with the same day after changing one.
+   */
+  void set_date(const QDate & date);
+
+  /**
+   * @brief Check or uncheck the element of a row
+   */
+  void toggle_checked(const QModelIndex & index);
+
+private:
+  reef_moonshiners::DoseList m_list;
+  /// checked state of each element, by its index in m_list
+  std::vector<bool> m_checked;
+};
+
+}  // namespace reef_moonshiners::ui
+
+#endif  // REEF_MOONSHINERS__UI__DOSE_LIST_MODEL_HPP_
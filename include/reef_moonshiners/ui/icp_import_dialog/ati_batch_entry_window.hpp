@@ -0,0 +1,77 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef REEF_MOONSHINERS__UI__ICP_IMPORT_DIALOG__ATI_BATCH_ENTRY_WINDOW_HPP_
+#define REEF_MOONSHINERS__UI__ICP_IMPORT_DIALOG__ATI_BATCH_ENTRY_WINDOW_HPP_
+
+#include <QDate>
+#include <QLabel>
+#include <QList>
+#include <QPlainTextEdit>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QString>
+#include <QStringList>
+#include <QVBoxLayout>
+#include <QWidget>
+
+namespace reef_moonshiners::ui::icp_import_dialog
+{
+
+/**
+ * @brief Entry of several ATI analyses to import at once
+ *
+ * Each line holds an analysis ID followed by its collection date, written
+ * as yyyy-MM-dd.
+ */
+class ATIBatchEntryWindow : public QWidget
+{
+  Q_OBJECT
+
+public:
+  explicit ATIBatchEntryWindow(QWidget * parent = nullptr);
+  ~ATIBatchEntryWindow() override = default;
+
+  QPushButton * get_back_button() const;
+
+  /// emitted with one collection date per analysis ID, once every line is valid
+  Q_SIGNAL void import_button_pressed(const QStringList &, const QList<QDate> &);
+
+  /**
+   * @brief Show why the import did not go through
+   * @param message Reason, or an empty string to hide it
+   */
+  void set_error_message(const QString & message);
+
+  /**
+   * @brief Show that an import is running, and block starting another
+   * @param importing True while the analyses are being imported
+   */
+  void set_importing(bool importing);
+
+private:
+  QVBoxLayout * m_p_main_layout = nullptr;
+  QHBoxLayout * m_p_button_layout = nullptr;
+  QLabel * m_p_entry_label = nullptr;
+  QLabel * m_p_error_label = nullptr;
+  QPlainTextEdit * m_p_entry = nullptr;
+  QProgressBar * m_p_progress_bar = nullptr;
+  QPushButton * m_p_import_button = nullptr;
+  QPushButton * m_p_back_button = nullptr;
+};
+
+}  // namespace reef_moonshiners::ui::icp_import_dialog
+
+#endif  // REEF_MOONSHINERS__UI__ICP_IMPORT_DIALOG__ATI_BATCH_ENTRY_WINDOW_HPP_
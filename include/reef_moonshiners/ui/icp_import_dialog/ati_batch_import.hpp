@@ -0,0 +1,144 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef REEF_MOONSHINERS__UI__ICP_IMPORT_DIALOG__ATI_BATCH_IMPORT_HPP_
+#define REEF_MOONSHINERS__UI__ICP_IMPORT_DIALOG__ATI_BATCH_IMPORT_HPP_
+
+#include <QDate>
+#include <QNetworkAccessManager>
+#include <QObject>
+#include <QString>
+
+#include <reef_moonshiners/batch_importer.hpp>
+#include <reef_moonshiners/icp_cache.hpp>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace reef_moonshiners::ui::icp_import_dialog
+{
+
+/**
+ * @brief Import of many ATI ICP analyses at once
+ *
+ * A BatchImporter fetches and parses the analyses on the global thread pool,
+ * with bounded parallelism and retries. Its fetches go through the network
+ * access manager, on the thread that owns it, so they share its keep-alive
+ * HTTPS connections to the lab. Results are signalled on the thread that
+ * owns the import, oldest sample first, so the latest sample wins.
+ *
+ * With a cache, analyses are served and revalidated as ATIImport does, and
+ * fresh pages are cached once they are known to parse.
+ */
+class ATIBatchImport : public QObject
+{
+  Q_OBJECT
+
+public:
+  struct Entry
+  {
+    QString analysis_id;
+    QDate collection_date;
+  };
+
+  /**
+   * @brief Construct an import, which does nothing until started
+   *
+   * @param manager Network access manager to fetch with, which must outlive the import
+   * @param entries Analyses to import
+   * @param parent Owner of the import
+   */
+  explicit ATIBatchImport(
+    QNetworkAccessManager * manager, std::vector<Entry> entries,
+    QObject * parent = nullptr);
+  ~ATIBatchImport() override;
+
+  /**
+   * @brief Serve analyses from a cache, and store what is fetched in it
+   *
+   * @param cache Cache shared by the imports, or nullptr for none
+   */
+  void set_cache(std::shared_ptr<IcpCache> cache);
+
+  /**
+   * @brief Start fetching the analyses
+   */
+  void start();
+
+  /**
+   * @brief Stop the import; fetches not yet made are skipped and no further
+   *        signals are emitted
+   */
+  void cancel();
+
+  bool is_running() const;
+
+  /// analyses fetched at once
+  constexpr static size_t parallelism = 4;
+
+  /// emitted for each analysis imported
+  Q_SIGNAL void succeeded(const QDate & collection_date, const IcpResults & results);
+  /// emitted for each analysis that could not be imported
+  Q_SIGNAL void failed(const QString & analysis_id, const QString & reason);
+  /// emitted once every analysis is done
+  Q_SIGNAL void finished(int imported, int total);
+
+private:
+  /// pages fetched anew, to be cached once they are known to parse
+  struct FreshPages
+  {
+    std::mutex mutex;
+    /// analysis ID -> (page, record without its results)
+    std::map<std::string, std::pair<std::string, IcpCacheEntry>> pages;
+  };
+
+  /**
+   * @brief Fetch analyses through a network access manager
+   *
+   * The fetcher blocks until the reply arrives, so it must not be called on
+   * the manager's thread, which has to keep running its event loop.
+   *
+   * @param manager Network access manager to fetch with
+   * @param cache Cache to serve and revalidate from, or nullptr for none
+   * @param fresh Output, pages fetched anew
+   * @param cancelled Once set, fetches fail without asking the lab
+   *
+   * @return Fetcher for BatchImporter
+   */
+  static BatchImporter::Fetcher _make_fetcher(
+    QNetworkAccessManager * manager,
+    std::shared_ptr<IcpCache> cache,
+    std::shared_ptr<FreshPages> fresh,
+    std::shared_ptr<std::atomic<bool>> cancelled);
+
+  void _finish(
+    const std::vector<BatchImportResult> & results,
+    const std::vector<IcpResults> & values);
+
+  QNetworkAccessManager * m_p_manager = nullptr;
+  std::shared_ptr<IcpCache> m_p_cache;
+  std::vector<Entry> m_entries;
+  bool m_running = false;
+  /// set by cancel, checked by the fetches on the thread pool
+  std::shared_ptr<std::atomic<bool>> m_p_cancelled = std::make_shared<std::atomic<bool>>(false);
+};
+
+}  // namespace reef_moonshiners::ui::icp_import_dialog
+
+#endif  // REEF_MOONSHINERS__UI__ICP_IMPORT_DIALOG__ATI_BATCH_IMPORT_HPP_
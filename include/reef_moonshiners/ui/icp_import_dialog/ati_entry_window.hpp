@@ -21,6 +21,7 @@
 #include <QPushButton>
 #include <QLineEdit>
 #include <QLabel>
+#include <QProgressBar>
 #include <QWidget>
 
 namespace reef_moonshiners::ui::icp_import_dialog
@@ -36,11 +37,24 @@ public:
 
   QPushButton * get_back_button() const;
 
+  /**
+   * @brief Button that switches to entering several analyses at once
+   */
+  QPushButton * get_batch_button() const;
+
   Q_SIGNAL void next_button_pressed(const QString &, const QDate &);
 
   void show_input_error_message();
   void hide_input_error_message();
 
+  /**
+   * @brief Show that an import is running, and block starting another
+   * @param importing True while the analysis is being imported
+   */
+  void set_importing(bool importing);
+
+  Q_SLOT void set_progress(qint64 received, qint64 total);
+
 private:
   QVBoxLayout * m_p_main_layout = nullptr;
   QHBoxLayout * m_p_button_layout = nullptr;
@@ -50,8 +64,10 @@ private:
   QLabel * m_p_verify_input_label = nullptr;
   QPushButton * m_p_next_button = nullptr;
   QPushButton * m_p_back_button = nullptr;
+  QPushButton * m_p_batch_button = nullptr;
   QLineEdit * m_p_ati_id_entry = nullptr;
   QCalendarWidget * m_p_calendar_widget = nullptr;
+  QProgressBar * m_p_progress_bar = nullptr;
   bool m_error_message_showing = false;
 };
 
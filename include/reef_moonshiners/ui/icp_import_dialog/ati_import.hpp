@@ -0,0 +1,156 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef REEF_MOONSHINERS__UI__ICP_IMPORT_DIALOG__ATI_IMPORT_HPP_
+#define REEF_MOONSHINERS__UI__ICP_IMPORT_DIALOG__ATI_IMPORT_HPP_
+
+#include <QByteArray>
+#include <QDate>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QUrl>
+
+#include <reef_moonshiners/ati_page.hpp>
+#include <reef_moonshiners/icp_cache.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace reef_moonshiners::ui::icp_import_dialog
+{
+
+/**
+ * @brief Import of one ATI ICP analysis
+ *
+ * The analysis page is fetched asynchronously on the event loop, then the
+ * results are extracted and parsed on the global thread pool, so the UI stays
+ * responsive throughout. Signals are emitted on the thread that owns the
+ * import. Any number of imports can run at once; they share the network
+ * access manager, and so its connections.
+ *
+ * With a cache, an analysis validated within cache_max_age is served without
+ * the network. An older one is revalidated with its ETag and Last-Modified,
+ * and served from the cache if it has not changed or the lab is unreachable.
+ */
+class ATIImport : public QObject
+{
+  Q_OBJECT
+
+public:
+  /**
+   * @brief Construct an import, which does nothing until started
+   *
+   * @param manager Network access manager to fetch with, which must outlive the import
+   * @param analysis_id ATI analysis ID
+   * @param collection_date Date the sample was taken
+   * @param parent Owner of the import
+   */
+  explicit ATIImport(
+    QNetworkAccessManager * manager, const QString & analysis_id,
+    const QDate & collection_date, QObject * parent = nullptr);
+  ~ATIImport() override;
+
+  /**
+   * @brief Cache fetched analyses, before starting
+   *
+   * @param cache Cache shared by the imports, or nullptr for none
+   */
+  void set_cache(std::shared_ptr<IcpCache> cache);
+
+  /**
+   * @brief Start fetching the analysis
+   */
+  void start();
+
+  /**
+   * @brief Stop the import; no further signals are emitted
+   */
+  void cancel();
+
+  bool is_running() const;
+
+  const QString & get_analysis_id() const;
+
+  const QDate & get_collection_date() const;
+
+  /**
+   * @brief Address of an analysis' public page
+   */
+  static QUrl make_url(const QString & analysis_id);
+
+  /**
+   * @brief Extract the results from an analysis page
+   *
+   * Safe to call from any thread.
+   *
+   * Names that are not known elements are reported on stderr and dropped.
+   *
+   * @param html Analysis page
+   * @param results Output, concentration of each element in the analysis
+   * @param error Output, reason the page could not be parsed
+   *
+   * @return false if the page has no results
+   */
+  static bool parse(const QByteArray & html, IcpResults & results, QString & error);
+
+  /// longest time a transfer may stall before it is abandoned
+  constexpr static int transfer_timeout_ms = 10000;
+
+  /// how long a cached analysis is served without asking the lab
+  constexpr static std::chrono::minutes cache_max_age{60};
+
+  Q_SIGNAL void progress(qint64 received, qint64 total);
+  Q_SIGNAL void succeeded(const QDate & collection_date, const IcpResults & results);
+  Q_SIGNAL void failed(const QString & reason);
+
+private:
+  /// outcome of parsing on the thread pool
+  struct ParseResult
+  {
+    bool parsed = false;
+    IcpResults results;
+    QString error;
+  };
+
+  Q_SLOT void _handle_reply_finished();
+
+  void _finish(const ParseResult & result);
+
+  /// finish with the cached results, once control returns to the event loop
+  void _finish_from_cache();
+
+  /// results of the cached record
+  ParseResult _get_cached_result() const;
+
+  QNetworkAccessManager * m_p_manager = nullptr;
+  QPointer<QNetworkReply> m_p_reply;
+  QString m_analysis_id;
+  QDate m_collection_date;
+  std::shared_ptr<IcpCache> m_p_cache;
+  /// cached record of the analysis, if m_cached
+  IcpCacheEntry m_cache_entry;
+  bool m_cached = false;
+  bool m_running = false;
+  /// set by cancel, checked by the parser on the thread pool
+  std::shared_ptr<std::atomic<bool>> m_p_cancelled = std::make_shared<std::atomic<bool>>(false);
+};
+
+}  // namespace reef_moonshiners::ui::icp_import_dialog
+
+#endif  // REEF_MOONSHINERS__UI__ICP_IMPORT_DIALOG__ATI_IMPORT_HPP_
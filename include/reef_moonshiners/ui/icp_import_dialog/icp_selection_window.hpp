@@ -24,9 +24,14 @@
 namespace reef_moonshiners::ui::icp_import_dialog
 {
 
+/**
+ * @brief Selected provider, by its index in get_icp_providers()
+ */
 enum class IcpSelection : uint8_t
 {
-  ATI_ICP_OES = 0
+  ATI_ICP_OES = 0,
+  CSV_EXPORT = 1,
+  JSON_EXPORT = 2
 };
 
 class IcpSelectionWindow : public QWidget
@@ -23,19 +23,31 @@
 #include <QDate>
 #include <QCalendarWidget>
 #include <QDockWidget>
-#include <QListWidget>
+#include <QListView>
+#include <QModelIndex>
 #include <QScrollArea>
 #include <QToolBar>
 #include <QStandardPaths>
+#include <QNetworkAccessManager>
+#include <QPointer>
 
 #include <reef_moonshiners/elements.hpp>
+#include <reef_moonshiners/icp_provider.hpp>
+#include <reef_moonshiners/journal.hpp>
+#include <reef_moonshiners/persistence_worker.hpp>
 
 #include <reef_moonshiners/ui/about_window.hpp>
-#include <reef_moonshiners/ui/element_display.hpp>
+#include <reef_moonshiners/ui/dose_list_model.hpp>
 #include <reef_moonshiners/ui/settings_window.hpp>
 #include <reef_moonshiners/ui/icp_import_dialog/icp_selection_window.hpp>
+#include <reef_moonshiners/ui/icp_import_dialog/ati_batch_entry_window.hpp>
+#include <reef_moonshiners/ui/icp_import_dialog/ati_batch_import.hpp>
 #include <reef_moonshiners/ui/icp_import_dialog/ati_entry_window.hpp>
 #include <reef_moonshiners/ui/icp_import_dialog/ati_correction_start_window.hpp>
+#include <reef_moonshiners/ui/icp_import_dialog/ati_import.hpp>
+
+#include <memory>
+#include <set>
 
 namespace reef_moonshiners::ui
 {
@@ -46,7 +58,7 @@ class MainWindow : public QMainWindow
 
 public:
   explicit MainWindow(QWidget * parent = nullptr);
-  ~MainWindow() override = default;
+  ~MainWindow() override;
 
 protected:
   using IcpSelection = reef_moonshiners::ui::icp_import_dialog::IcpSelection;
@@ -55,6 +67,11 @@ protected:
 
   Q_SLOT void _refresh_elements();
 
+  /**
+   * @brief Show the loaded settings in the settings window
+   */
+  void _update_settings_window();
+
   Q_SLOT void _activate_about_window();
   Q_SLOT void _activate_calendar_window();
   Q_SLOT void _activate_icp_import_dialog();
@@ -72,19 +89,76 @@ protected:
     reef_moonshiners::ui::icp_import_dialog::IcpSelection icp_selection);
   Q_SLOT void _handle_back_ati_entry_window();
   Q_SLOT void _handle_next_ati_entry_window(const QString & text, const QDate & date);
+  Q_SLOT void _handle_batch_ati_entry_window();
+  Q_SLOT void _handle_back_ati_batch_entry_window();
+  Q_SLOT void _handle_import_ati_batch_entry_window(
+    const QStringList & analysis_ids, const QList<QDate> & collection_dates);
   Q_SLOT void _handle_okay_ati_correction_start_window(const QDate & date);
+
+  /**
+   * @brief Set the concentrations measured by an ICP analysis
+   * @param date Date the sample was taken
+   * @param results Concentration of each element in the analysis; elements it
+   *                lacks are reported and keep their last measurement
+   */
+  void _apply_icp_results(const QDate & date, const IcpResults & results);
+
+  /**
+   * @brief Import an analysis from a file the user picks
+   *
+   * The sample is dated by the report, or else by the selected day.
+   *
+   * @return false if no file was picked, or it could not be parsed
+   */
+  bool _import_icp_file(const reef_moonshiners::IcpProvider & provider);
+
+  /**
+   * @brief Move on from the entry window once its import is applied
+   */
+  void _handle_ati_import_succeeded();
   Q_SLOT void _handle_back_ati_correction_start_window();
   Q_SLOT void _handle_increase_iodine();
   Q_SLOT void _handle_decrease_iodine();
   Q_SLOT void _handle_increase_vanadium();
   Q_SLOT void _handle_decrease_vanadium();
-  Q_SLOT void _handle_item_clicked(QListWidgetItem * p_item);
+  Q_SLOT void _handle_item_clicked(const QModelIndex & index);
 
   Q_SLOT void _save();
   bool _load();
 
+  /**
+   * @brief Load a save file older than version 5, which is a sequence of elements
+   */
+  void _load_sequential(std::istream & file, const size_t save_file_version);
+
+  /**
+   * @brief Load a sectioned save file, deferring the dose histories
+   * @return false if the section table is malformed
+   */
+  bool _load_sections(std::istream & file, const size_t save_file_version);
+
+  reef_moonshiners::ElementBase * _find_element(const std::string & name);
+
+  /**
+   * @brief Apply a change and queue it for the journal
+   *
+   * The journal is folded into a full save once it grows long enough.
+   */
+  void _record(const reef_moonshiners::JournalEntry & entry);
+
+  /**
+   * @brief Apply a change, without journaling it
+   */
+  void _apply(const reef_moonshiners::JournalEntry & entry);
+
+  void _apply_setting(const reef_moonshiners::JournalEntry & entry);
+
 private:
-  constexpr static size_t m_save_file_version = 3;  /* increment when changes happen to the format */
+  constexpr static size_t m_save_file_version = 6;  /* increment when changes happen to the format */
+  /* journal entries after which we save in full */
+  constexpr static size_t m_journal_compaction_threshold = 256;
+  /* quiet time before changes are written out */
+  constexpr static std::chrono::milliseconds m_persistence_window{500};
   int m_refugium_state = Qt::Unchecked;
   int m_nano_dose_state = Qt::Unchecked;
 
@@ -104,23 +178,45 @@ private:
   AboutWindow * m_p_about_window = nullptr;
   icp_import_dialog::IcpSelectionWindow * m_p_icp_selection_window = nullptr;
   icp_import_dialog::ATIEntryWindow * m_p_ati_entry_window = nullptr;
+  icp_import_dialog::ATIBatchEntryWindow * m_p_ati_batch_entry_window = nullptr;
   icp_import_dialog::ATICorrectionStartWindow * m_p_ati_correction_start_window = nullptr;
 
   QWidget * m_p_active_window = nullptr;
   QWidget * m_p_active_icp_selection_window = nullptr;
+  /// window the analysis being corrected was imported from, to go back to
+  QWidget * m_p_icp_import_origin = nullptr;
   QAction * m_p_active_action = nullptr;
 
-  QListWidget * m_p_list_widget = nullptr;
-
-  std::map<std::unique_ptr<reef_moonshiners::DailyElement>, ElementDisplay *> m_elements;
-  std::map<std::unique_ptr<reef_moonshiners::DropperElement>,
-    ElementDisplay *> m_dropper_elements;
+  QListView * m_p_list_view = nullptr;
+  /// doses of the selected day, one row per dosed element
+  DoseListModel * m_p_dose_model = nullptr;
+
+  /// shared by every import, so connections to the lab are reused
+  QNetworkAccessManager * m_p_network = nullptr;
+  /// import started from the entry window, if one is running
+  QPointer<icp_import_dialog::ATIImport> m_p_ati_import;
+  /// import started from the batch entry window, if one is running
+  QPointer<icp_import_dialog::ATIBatchImport> m_p_ati_batch_import;
+  /// analyses fetched so far, so repeat imports need no network
+  std::shared_ptr<reef_moonshiners::IcpCache> m_p_icp_cache;
+
+  /// writes the journal and save file off of the UI thread
+  std::unique_ptr<reef_moonshiners::PersistenceWorker> m_p_persistence;
+  /// changes journaled since the last save
+  size_t m_journaled = 0;
+
+  std::shared_ptr<reef_moonshiners::Tank> m_p_tank =
+    std::make_shared<reef_moonshiners::Tank>(reef_moonshiners::gallons_to_liters(75));
+  /**
+   * elements, ordered by address as the maps they replaced were; files prior
+   * to version 5 are written in this order, so it must not change
+   */
+  std::set<std::unique_ptr<reef_moonshiners::DailyElement>> m_elements;
+  std::set<std::unique_ptr<reef_moonshiners::DropperElement>> m_dropper_elements;
   reef_moonshiners::Iodine * m_p_iodine_element = nullptr;
   reef_moonshiners::Vanadium * m_p_vanadium_element = nullptr;
   std::unique_ptr<reef_moonshiners::Rubidium> m_p_rubidium_element = nullptr;
-  ElementDisplay * m_p_rubidium_display = nullptr;
-  std::map<std::unique_ptr<reef_moonshiners::CorrectionElement>,
-    ElementDisplay *> m_correction_elements;
+  std::set<std::unique_ptr<reef_moonshiners::CorrectionElement>> m_correction_elements;
 };
 
 }  // namespace reef_moonshiners::ui
@@ -0,0 +1,185 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/ati_page.hpp>
+#include <reef_moonshiners/json_scanner.hpp>
+
+#include <algorithm>
+
+namespace
+{
+
+using reef_moonshiners::JsonScanner;
+
+/// units_id of results in milligrams per liter
+constexpr double milligrams_units_id = 2.0;
+
+bool is_entry_key(const std::string_view key)
+{
+  return !key.empty() && std::all_of(
+    key.begin(), key.end(), [](const char c) {return '0' <= c && c <= '9';});
+}
+
+/// read the "element" object of an entry
+bool scan_element(JsonScanner & scanner, std::string_view & name, double & units_id)
+{
+  if (!scanner.consume('{')) {
+    return false;
+  }
+  if (scanner.consume('}')) {
+    return true;
+  }
+  do {
+    std::string_view key;
+    if (!scanner.string(key) || !scanner.consume(':')) {
+      return false;
+    }
+    bool read = false;
+    if ("description_en" == key) {
+      read = scanner.string(name);
+    } else if ("units_id" == key) {
+      read = scanner.number(units_id);
+    } else {
+      read = scanner.skip_value(2);
+    }
+    if (!read) {
+      return false;
+    }
+  } while (scanner.consume(','));
+  return scanner.consume('}');
+}
+
+/// read one entry, setting found if it holds a named result
+bool scan_entry(JsonScanner & scanner, reef_moonshiners::AtiMeasurement & measurement, bool & found)
+{
+  if (!scanner.consume('{')) {
+    return false;
+  }
+  found = false;
+  if (scanner.consume('}')) {
+    return true;
+  }
+  double units_id = 0.0;
+  bool has_value = false;
+  do {
+    std::string_view key;
+    if (!scanner.string(key) || !scanner.consume(':')) {
+      return false;
+    }
+    bool read = false;
+    if ("element" == key) {
+      read = scan_element(scanner, measurement.name, units_id);
+    } else if ("elements_value" == key) {
+      read = scanner.consume_null() || (has_value = scanner.number(measurement.value));
+    } else {
+      read = scanner.skip_value(1);
+    }
+    if (!read) {
+      return false;
+    }
+  } while (scanner.consume(','));
+  if (milligrams_units_id == units_id) {
+    measurement.value *= 1E3;  /* mg / L -> ug / L */
+  }
+  found = has_value && !measurement.name.empty();
+  return scanner.consume('}');
+}
+
+}  // namespace
+
+namespace reef_moonshiners
+{
+
+bool AtiPage::scan(const std::string_view page, std::string & error)
+{
+  m_size = 0;
+  const auto table = page.find("var dataTable");
+  if (table == std::string_view::npos) {
+    error = "data table not found";
+    return false;
+  }
+  const auto first = page.find("\"0\":", table);
+  if (first == std::string_view::npos) {
+    error = "zero section not found";
+    return false;
+  }
+  JsonScanner scanner{page.data() + first, page.data() + page.size()};
+  /* entries run until the table's other keys, such as "tank:" */
+  do {
+    std::string_view key;
+    if (!scanner.at_end() && !scanner.peek('"')) {
+      break;
+    }
+    if (!scanner.string(key) || !scanner.consume(':')) {
+      error = "malformed data table";
+      return false;
+    }
+    if (!is_entry_key(key)) {
+      break;
+    }
+    AtiMeasurement measurement;
+    bool found = false;
+    if (!scan_entry(scanner, measurement, found)) {
+      error = "malformed entry \"" + std::string{key} + "\"";
+      return false;
+    }
+    if (!found) {
+      continue;
+    }
+    if (m_size == max_measurements) {
+      error = "too many results";
+      return false;
+    }
+    m_measurements[m_size++] = measurement;
+  } while (scanner.consume(','));
+  /* the table goes on past its entries, so a page cut short ends here */
+  if (scanner.at_end()) {
+    error = "malformed data table";
+    return false;
+  }
+  if (0 == m_size) {
+    error = "no results found";
+    return false;
+  }
+  return true;
+}
+
+std::span<const AtiMeasurement> AtiPage::get_measurements() const
+{
+  return std::span<const AtiMeasurement>{m_measurements.data(), m_size};
+}
+
+void AtiPage::get_results(IcpResults & results, std::vector<std::string_view> & unknown) const
+{
+  results.clear();
+  unknown.clear();
+  for (const auto & measurement : this->get_measurements()) {
+    if (!results.set(find_icp_element(measurement.name), measurement.value)) {
+      unknown.push_back(measurement.name);
+    }
+  }
+}
+
+bool parse_ati_page(const std::string & page, IcpResults & results, std::string & error)
+{
+  AtiPage scanned;
+  if (!scanned.scan(page, error)) {
+    return false;
+  }
+  std::vector<std::string_view> unknown;
+  scanned.get_results(results, unknown);
+  return true;
+}
+
+}  // namespace reef_moonshiners
@@ -0,0 +1,246 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/batch_dose_engine.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+
+int32_t to_day_index(const std::chrono::year_month_day & date)
+{
+  return static_cast<int32_t>(std::chrono::sys_days{date}.time_since_epoch().count());
+}
+
+/* Adding and subtracting 1.5 * 2^52 rounds to a whole number, so these
+ * match round_places<2>, truncate_places<2> and std::ceil for finite
+ * |d| < 2^51. Unlike std::ceil they also vectorize without SSE4.1. */
+constexpr double ROUNDING_BIAS = 0x1.8p52;
+
+inline double ceil_places_2(const double d)
+{
+  const double x = d * 10 * 10;
+  const double r = (x + ROUNDING_BIAS) - ROUNDING_BIAS;
+  return ((r < x) ? r + 1.0 : r) / 10 / 10;
+}
+
+inline double floor_places_2(const double d)
+{
+  const double x = d * 10 * 10;
+  const double r = (x + ROUNDING_BIAS) - ROUNDING_BIAS;
+  return ((r > x) ? r - 1.0 : r) / 10 / 10;
+}
+
+inline double ceil_whole(const double d)
+{
+  const double r = (d + ROUNDING_BIAS) - ROUNDING_BIAS;
+  return (r < d) ? r + 1.0 : r;
+}
+
+/* The kernels only vectorize once their selects are if-converted, which
+ * GCC will not do under its default -ftrapping-math, so CMakeLists.txt
+ * builds this file with -fno-trapping-math. Check with -fopt-info-vec. */
+
+/* same math as DailyElement::get_dose, across tanks */
+void daily_kernel(
+  const size_t tanks, const double element_concentration,
+  const double * __restrict tank_sizes, const double * __restrict concentrations,
+  const double * __restrict targets, const double * __restrict multipliers,
+  double * __restrict doses)
+{
+  for (size_t t = 0; t < tanks; ++t) {
+    const double dose_in_liters =
+      (targets[t] * tank_sizes[t]) / (element_concentration - targets[t]);
+    const double dose = ceil_places_2(dose_in_liters * 1E3) * multipliers[t];
+    doses[t] = (concentrations[t] >= targets[t]) ? 0.0 : dose;
+  }
+}
+
+/* same math as CorrectionElement::get_dose, across tanks */
+void correction_kernel(
+  const size_t tanks, const double element_concentration, const double max_adjustment,
+  const double * __restrict tank_sizes, const double * __restrict concentrations,
+  const double * __restrict targets, double * __restrict doses,
+  double * __restrict day_counts)
+{
+  for (size_t t = 0; t < tanks; ++t) {
+    const double maximum_dose = (max_adjustment * tank_sizes[t]) /
+      (element_concentration - concentrations[t] - max_adjustment);
+    const double total_dose_l = (tank_sizes[t] / element_concentration) *
+      (targets[t] - concentrations[t]);
+    const double correction_days = ceil_whole(total_dose_l / maximum_dose);
+    const double dose = floor_places_2((total_dose_l / correction_days) * 1E3);
+    /* nothing to correct if we are at (or above) target */
+    const bool active = correction_days > 0.0;
+    doses[t] = active ? dose : 0.0;
+    day_counts[t] = active ? correction_days : 0.0;
+  }
+}
+
+}  // namespace
+
+namespace reef_moonshiners
+{
+
+BatchDoseEngine::BatchDoseEngine(const size_t tanks)
+: m_tanks(tanks),
+  m_tank_sizes(tanks, 0.0)
+{
+}
+
+size_t BatchDoseEngine::add_element(
+  const BatchElementKind kind, const double element_concentration,
+  const double target_concentration, const double max_adjustment)
+{
+  m_kinds.push_back(kind);
+  m_element_concentrations.push_back(element_concentration);
+  m_max_adjustments.push_back(max_adjustment);
+  m_concentrations.resize(m_concentrations.size() + m_tanks, 0.0);
+  m_target_concentrations.resize(m_target_concentrations.size() + m_tanks, target_concentration);
+  m_multipliers.resize(m_multipliers.size() + m_tanks, 1.0);
+  m_start_days.resize(m_start_days.size() + m_tanks, 0);
+  return m_kinds.size() - 1;
+}
+
+size_t BatchDoseEngine::add_element(const DailyElement & element)
+{
+  return add_element(
+    BatchElementKind::DAILY, element.get_element_concentration(),
+    element.get_target_concentration(), element.get_max_daily_dosage());
+}
+
+size_t BatchDoseEngine::add_element(const CorrectionElement & element)
+{
+  return add_element(
+    BatchElementKind::CORRECTION, element.get_element_concentration(),
+    element.get_target_concentration(), element.get_max_daily_dosage());
+}
+
+size_t BatchDoseEngine::get_tank_count() const
+{
+  return m_tanks;
+}
+
+size_t BatchDoseEngine::get_element_count() const
+{
+  return m_kinds.size();
+}
+
+size_t BatchDoseEngine::_index(const size_t tank, const size_t element) const
+{
+  return element * m_tanks + tank;
+}
+
+void BatchDoseEngine::set_tank_size(const size_t tank, const double tank_size)
+{
+  m_tank_sizes[tank] = tank_size;
+}
+
+double BatchDoseEngine::get_tank_size(const size_t tank) const
+{
+  return m_tank_sizes[tank];
+}
+
+void BatchDoseEngine::load(const size_t tank, const size_t element, const DailyElement & source)
+{
+  const size_t idx = _index(tank, element);
+  m_concentrations[idx] = source.get_current_concentration_estimate();
+  m_target_concentrations[idx] = source.get_target_concentration();
+  m_multipliers[idx] = source.get_multiplier();
+}
+
+void BatchDoseEngine::load(
+  const size_t tank, const size_t element,
+  const CorrectionElement & source)
+{
+  const size_t idx = _index(tank, element);
+  m_concentrations[idx] = source.get_last_measured_concentration();
+  /* Barium's target depends on the measurement, so it is stored per tank */
+  m_target_concentrations[idx] = source.get_target_concentration();
+  m_start_days[idx] = to_day_index(source.get_correction_start_date());
+}
+
+void BatchDoseEngine::set_concentration(
+  const size_t tank, const size_t element,
+  const double concentration)
+{
+  m_concentrations[_index(tank, element)] = concentration;
+}
+
+void BatchDoseEngine::set_target_concentration(
+  const size_t tank, const size_t element, const double target_concentration)
+{
+  m_target_concentrations[_index(tank, element)] = target_concentration;
+}
+
+void BatchDoseEngine::set_multiplier(
+  const size_t tank, const size_t element,
+  const double multiplier)
+{
+  m_multipliers[_index(tank, element)] = multiplier;
+}
+
+void BatchDoseEngine::set_correction_start_date(
+  const size_t tank, const size_t element, const std::chrono::year_month_day & date)
+{
+  m_start_days[_index(tank, element)] = to_day_index(date);
+}
+
+void BatchDoseEngine::compute(
+  const std::chrono::year_month_day & start, const size_t days,
+  std::vector<double> & doses) const
+{
+  const size_t elements = m_kinds.size();
+  doses.assign(m_tanks * elements * days, 0.0);
+  if (0 == days) {
+    return;
+  }
+  const int64_t first_day = to_day_index(start);
+  std::vector<double> element_doses(m_tanks);
+  std::vector<double> day_counts(m_tanks);
+  for (size_t e = 0; e < elements; ++e) {
+    const size_t column = e * m_tanks;
+    if (BatchElementKind::DAILY == m_kinds[e]) {
+      daily_kernel(
+        m_tanks, m_element_concentrations[e], m_tank_sizes.data(),
+        m_concentrations.data() + column, m_target_concentrations.data() + column,
+        m_multipliers.data() + column, element_doses.data());
+      for (size_t t = 0; t < m_tanks; ++t) {
+        double * row = doses.data() + (t * elements + e) * days;
+        std::fill(row, row + days, element_doses[t]);
+      }
+      continue;
+    }
+    correction_kernel(
+      m_tanks, m_element_concentrations[e], m_max_adjustments[e], m_tank_sizes.data(),
+      m_concentrations.data() + column, m_target_concentrations.data() + column,
+      element_doses.data(), day_counts.data());
+    for (size_t t = 0; t < m_tanks; ++t) {
+      /* clip the correction window to the requested range */
+      const int64_t window_begin = m_start_days[column + t] - first_day;
+      /* day counts past the int32_t day range cannot be reached by any date */
+      const int64_t duration = static_cast<int64_t>(
+        std::min(day_counts[t], static_cast<double>(std::numeric_limits<int32_t>::max())));
+      const int64_t window_end = window_begin + duration;
+      const int64_t begin = std::clamp<int64_t>(window_begin, 0, static_cast<int64_t>(days));
+      const int64_t end = std::clamp<int64_t>(window_end, 0, static_cast<int64_t>(days));
+      double * row = doses.data() + (t * elements + e) * days;
+      std::fill(row + begin, row + end, element_doses[t]);
+    }
+  }
+}
+
+}  // namespace reef_moonshiners
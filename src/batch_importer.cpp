@@ -0,0 +1,130 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/batch_importer.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <utility>
+
+namespace reef_moonshiners
+{
+
+BatchImporter::BatchImporter(Fetcher fetch, Parser parse, BatchImportOptions options)
+: m_fetch(std::move(fetch)),
+  m_parse(std::move(parse)),
+  m_options(std::move(options))
+{
+}
+
+std::chrono::milliseconds BatchImporter::get_backoff(
+  const size_t attempt,
+  std::mt19937_64 & rng) const
+{
+  using std::chrono::milliseconds;
+  milliseconds ceiling = m_options.initial_backoff;
+  for (size_t x = 1; x < attempt && ceiling < m_options.max_backoff; ++x) {
+    ceiling *= 2;
+  }
+  ceiling = std::min(ceiling, m_options.max_backoff);
+  if (ceiling.count() <= 0) {
+    return milliseconds{0};
+  }
+  std::uniform_int_distribution<milliseconds::rep> wait{0, ceiling.count()};
+  return milliseconds{wait(rng)};
+}
+
+std::vector<BatchImportResult> BatchImporter::run(
+  const std::vector<BatchImportEntry> & entries) const
+{
+  std::vector<IcpResults> values;
+  std::vector<BatchImportResult> results = this->fetch(entries, values);
+
+  /* apply in order, so a later sample of the same tank wins */
+  for (size_t x = 0; x < entries.size(); ++x) {
+    if (!results[x].imported) {
+      continue;
+    }
+    for (ElementBase * element : entries[x].elements) {
+      const IcpElement id = element->get_icp_element();
+      if (values[x].contains(id)) {
+        element->set_concentration(values[x].get(id), entries[x].collection_date);
+      } else {
+        results[x].missing.push_back(element->get_name());
+      }
+    }
+  }
+  return results;
+}
+
+std::vector<BatchImportResult> BatchImporter::fetch(
+  const std::vector<BatchImportEntry> & entries,
+  std::vector<IcpResults> & values) const
+{
+  std::vector<BatchImportResult> results(entries.size());
+  values.assign(entries.size(), IcpResults{});
+  const size_t max_attempts = std::max<size_t>(1, m_options.max_attempts);
+  std::atomic<size_t> next{0};
+  const auto work = [&](const size_t worker) {
+      std::mt19937_64 rng{m_options.seed + worker};
+      for (size_t job = next.fetch_add(1); job < entries.size(); job = next.fetch_add(1)) {
+        BatchImportResult & result = results[job];
+        for (;;) {
+          ++result.attempts;
+          const FetchResult fetched = m_fetch(entries[job].analysis_id);
+          if (FetchStatus::OK == fetched.status) {
+            result.imported = m_parse(fetched.page, values[job], result.error);
+            break;
+          }
+          result.error = fetched.error;
+          if (FetchStatus::TRANSIENT_ERROR != fetched.status || result.attempts >= max_attempts) {
+            break;
+          }
+          std::this_thread::sleep_for(this->get_backoff(result.attempts, rng));
+        }
+        if (result.imported) {
+          result.error.clear();
+        }
+      }
+    };
+  const size_t workers = std::min(std::max<size_t>(1, m_options.parallelism), entries.size());
+  std::vector<std::thread> pool;
+  pool.reserve(workers);
+  for (size_t x = 0; x < workers; ++x) {
+    pool.emplace_back(work, x);
+  }
+  for (auto & worker : pool) {
+    worker.join();
+  }
+  return results;
+}
+
+FetchResult BatchImporter::make_fetch_result(
+  const int status, std::string body,
+  std::string error)
+{
+  FetchResult result;
+  if (200 <= status && status < 300) {
+    result.status = FetchStatus::OK;
+    result.page = std::move(body);
+    return result;
+  }
+  const bool transient = 0 == status || 408 == status || 429 == status || 500 <= status;
+  result.status = transient ? FetchStatus::TRANSIENT_ERROR : FetchStatus::PERMANENT_ERROR;
+  result.error = (0 == status) ? std::move(error) : "HTTP status " + std::to_string(status);
+  return result;
+}
+
+}  // namespace reef_moonshiners
@@ -0,0 +1,183 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/concentration_simulator.hpp>
+#include <reef_moonshiners/dose_schedule.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <utility>
+
+namespace
+{
+
+/// scenarios drawn from one seed
+constexpr size_t block_size = 256;
+
+/**
+ * Call fn(i) for i in [0, count), spread across worker threads
+ */
+template<typename Function>
+void parallel_for(const size_t count, const size_t threads, Function && fn)
+{
+  const size_t workers = std::min(threads, count);
+  if (workers <= 1) {
+    for (size_t x = 0; x < count; ++x) {
+      fn(x);
+    }
+    return;
+  }
+  std::atomic<size_t> next{0};
+  std::vector<std::thread> pool;
+  pool.reserve(workers);
+  for (size_t x = 0; x < workers; ++x) {
+    pool.emplace_back(
+      [&]() {
+        for (size_t job = next.fetch_add(1); job < count; job = next.fetch_add(1)) {
+          fn(job);
+        }
+      });
+  }
+  for (auto & worker : pool) {
+    worker.join();
+  }
+}
+
+}  // namespace
+
+namespace reef_moonshiners
+{
+
+ConcentrationBands::ConcentrationBands(
+  const size_t elements, const size_t days,
+  std::vector<double> percentiles)
+: m_elements(elements),
+  m_days(days),
+  m_percentiles(std::move(percentiles)),
+  m_values(elements * m_percentiles.size() * days, 0.0)
+{
+}
+
+size_t ConcentrationBands::get_element_count() const
+{
+  return m_elements;
+}
+
+size_t ConcentrationBands::get_day_count() const
+{
+  return m_days;
+}
+
+const std::vector<double> & ConcentrationBands::get_percentiles() const
+{
+  return m_percentiles;
+}
+
+double ConcentrationBands::get(
+  const size_t element, const size_t percentile,
+  const size_t day) const
+{
+  return m_values[(element * m_percentiles.size() + percentile) * m_days + day];
+}
+
+void ConcentrationBands::set(
+  const size_t element, const size_t percentile, const size_t day,
+  const double value)
+{
+  m_values[(element * m_percentiles.size() + percentile) * m_days + day] = value;
+}
+
+ConcentrationSimulator::ConcentrationSimulator(std::vector<const ElementBase *> elements)
+: m_elements(std::move(elements))
+{
+}
+
+ConcentrationBands ConcentrationSimulator::run(
+  const std::chrono::year_month_day & start,
+  const SimulationParameters & parameters) const
+{
+  const size_t elements = m_elements.size();
+  const size_t days = parameters.days;
+  const size_t scenarios = parameters.scenarios;
+  ConcentrationBands bands{elements, days, parameters.percentiles};
+  if (0 == elements || 0 == days || 0 == scenarios) {
+    return bands;
+  }
+  const size_t threads = (0 != parameters.threads) ? parameters.threads :
+    std::max<size_t>(1, std::thread::hardware_concurrency());
+
+  /* the doses are the same in every scenario, so convert them once */
+  const DoseSchedule schedule{
+    start, std::chrono::year_month_day{std::chrono::sys_days{start} + std::chrono::days(days)},
+    m_elements};
+  std::vector<double> added(elements * days, 0.0);
+  std::vector<double> measured(elements);
+  for (size_t e = 0; e < elements; ++e) {
+    const ElementBase * element = m_elements[e];
+    measured[e] = element->get_last_measured_concentration();
+    const double tank_volume = element->get_tank_volume();
+    if (tank_volume <= 0.0) {
+      continue;
+    }
+    /* micrograms per liter added by one mL of the supplement the dose was computed for */
+    const double per_ml = (1E-3 * element->get_dose_concentration()) / tank_volume;
+    const auto doses = schedule.get_doses(e);
+    for (size_t d = 0; d < days; ++d) {
+      added[e * days + d] = doses[d] * per_ml;
+    }
+  }
+
+  /* each worker steps every scenario of one element a day at a time, and
+   * reduces the day to its percentiles before stepping to the next */
+  const std::vector<double> & percentiles = bands.get_percentiles();
+  parallel_for(
+    elements, threads, [&](const size_t e) {
+      std::vector<double> concentration(scenarios);
+      std::vector<double> retained(scenarios);
+      std::vector<double> scratch(scenarios);
+      for (size_t first = 0; first < scenarios; first += block_size) {
+        std::seed_seq seed{
+          static_cast<uint32_t>(parameters.seed), static_cast<uint32_t>(parameters.seed >> 32),
+          static_cast<uint32_t>(e), static_cast<uint32_t>(first / block_size)};
+        std::mt19937_64 rng{seed};
+        std::uniform_real_distribution<double> unit{-1.0, 1.0};
+        const size_t last = std::min(first + block_size, scenarios);
+        for (size_t s = first; s < last; ++s) {
+          concentration[s] = measured[e] * (1.0 + parameters.measurement_error * unit(rng));
+          retained[s] = 1.0 - parameters.consumption_rate *
+          (1.0 + parameters.consumption_error * unit(rng));
+        }
+      }
+      for (size_t d = 0; d < days; ++d) {
+        const double dose = added[e * days + d];
+        for (size_t s = 0; s < scenarios; ++s) {
+          concentration[s] = concentration[s] * retained[s] + dose;
+          scratch[s] = concentration[s];
+        }
+        for (size_t p = 0; p < percentiles.size(); ++p) {
+          const double rank = std::clamp(percentiles[p], 0.0, 100.0) / 100.0 *
+          static_cast<double>(scenarios - 1);
+          const auto nth = scratch.begin() + static_cast<ptrdiff_t>(std::round(rank));
+          std::nth_element(scratch.begin(), nth, scratch.end());
+          bands.set(e, p, d, *nth);
+        }
+      }
+    });
+  return bands;
+}
+
+}  // namespace reef_moonshiners
@@ -14,6 +14,10 @@
 
 #include <cstdio>
 #include <reef_moonshiners/correction_element.hpp>
+#include <reef_moonshiners/mapped_file.hpp>
+
+#include <algorithm>
+#include <utility>
 
 namespace reef_moonshiners
 {
@@ -36,14 +40,8 @@ double CorrectionElement::get_current_concentration_estimate() const
 
 double CorrectionElement::get_concentration_estimate(const std::chrono::year_month_day & date) const
 {
-  double cummulative_dose_ml = 0.0;
-  for (auto iter = this->get_last_measurement_date(); iter < date;
-    iter = iter + std::chrono::days(1))
-  {
-    if (auto dose_iter = m_dosed_amounts.find(iter); dose_iter != m_dosed_amounts.end()) {
-      cummulative_dose_ml += dose_iter->second;
-    }
-  }
+  const double cummulative_dose_ml =
+    _get_ledger().total(this->get_last_measurement_date(), date);
   return round_places<0>(
     this->_get_concentration_after_dose(
       cummulative_dose_ml,
@@ -52,13 +50,27 @@ double CorrectionElement::get_concentration_estimate(const std::chrono::year_mon
 
 void CorrectionElement::apply_dose(const double _dose, const std::chrono::year_month_day & _date)
 {
-  m_dosed_amounts[_date] = _dose;
+  _get_ledger();
+  m_dosed_amounts.set(_date, _dose);
+}
+
+void CorrectionElement::clear_dose_history()
+{
+  m_pending_ledger.clear();
+  m_ledger_pending.store(false, std::memory_order_release);
+  m_dosed_amounts.clear();
+}
+
+const DoseLedger & CorrectionElement::get_dose_history() const
+{
+  return _get_ledger();
 }
 
 void CorrectionElement::set_correction_start_date(
   const std::chrono::year_month_day & _correction_start_date)
 {
   m_correction_start_date = _correction_start_date;
+  _bump_generation();
 }
 
 const std::chrono::year_month_day & CorrectionElement::get_correction_start_date() const
@@ -66,34 +78,139 @@ const std::chrono::year_month_day & CorrectionElement::get_correction_start_date
   return m_correction_start_date;
 }
 
-double CorrectionElement::get_dose(const std::chrono::year_month_day & day) const
+CorrectionElement::CorrectionPlan CorrectionElement::_make_plan() const
 {
+  CorrectionPlan plan;
   const double maximum_dose = this->_max_daily_dosage_l(this->get_last_measured_concentration());
-  const double total_dose_l = (this->get_tank_size() / this->get_element_concentration()) *
+  const double total_dose_l = (this->get_tank_volume() / this->get_element_concentration()) *
     (this->get_target_concentration() - this->get_last_measured_concentration());
-  const double correction_dose_daily =
-    truncate_places<2>((total_dose_l / std::ceil(total_dose_l / maximum_dose)) * 1E3);
-  if (day >= m_correction_start_date &&
-    (day - m_correction_start_date <
-    std::chrono::days((uint64_t)std::ceil(total_dose_l / maximum_dose))))
-  {
-    return correction_dose_daily;
+  const double correction_days = std::ceil(total_dose_l / maximum_dose);
+  if (!(correction_days > 0.0)) {
+    /* at (or above) target, nothing to correct */
+    return plan;
+  }
+  plan.daily_dose = truncate_places<2>((total_dose_l / correction_days) * 1E3);
+  plan.total_dose = total_dose_l * 1E3;
+  plan.max_daily_dose = maximum_dose * 1E3;
+  plan.duration = std::chrono::days(
+    static_cast<std::chrono::days::rep>(
+      std::min(correction_days, static_cast<double>(std::numeric_limits<int32_t>::max()))));
+  return plan;
+}
+
+CorrectionElement::CorrectionPlan CorrectionElement::_get_plan() const
+{
+  const uint64_t generation = this->get_generation();
+  if (m_plan_generation.load(std::memory_order_acquire) != generation) {
+    std::lock_guard<std::mutex> lock{m_plan_mutex};
+    if (m_plan_generation.load(std::memory_order_relaxed) != generation) {
+      m_plan = _make_plan();
+      m_plan_generation.store(generation, std::memory_order_release);
+    }
+  }
+  return m_plan;
+}
+
+double CorrectionElement::get_correction_dose() const
+{
+  return _get_plan().daily_dose;
+}
+
+std::chrono::days CorrectionElement::get_correction_duration() const
+{
+  return _get_plan().duration;
+}
+
+double CorrectionElement::get_correction_total() const
+{
+  return _get_plan().total_dose;
+}
+
+double CorrectionElement::get_max_daily_dose() const
+{
+  return _get_plan().max_daily_dose;
+}
+
+double CorrectionElement::get_dose(const std::chrono::year_month_day & day) const
+{
+  const CorrectionPlan plan = _get_plan();
+  if (day >= m_correction_start_date && (day - m_correction_start_date < plan.duration)) {
+    return plan.daily_dose;
   }
   return 0.0;
 }
 
+void CorrectionElement::fill_doses(
+  const std::chrono::year_month_day & start,
+  std::span<double> doses) const
+{
+  std::fill(doses.begin(), doses.end(), 0.0);
+  const CorrectionPlan plan = _get_plan();
+  /* clip the correction window to the requested days */
+  const int64_t size = static_cast<int64_t>(doses.size());
+  const int64_t window_begin = (m_correction_start_date - start).count();
+  const int64_t window_end = window_begin + plan.duration.count();
+  const int64_t begin = std::clamp<int64_t>(window_begin, 0, size);
+  const int64_t end = std::clamp<int64_t>(window_end, 0, size);
+  std::fill(doses.begin() + begin, doses.begin() + end, plan.daily_dose);
+}
+
 void CorrectionElement::write_to(std::ostream & stream) const
+{
+  this->write_settings_to(stream);
+  this->write_ledger_to(stream);
+}
+
+void CorrectionElement::read_from(std::istream & stream)
+{
+  this->read_settings_from(stream);
+  this->read_ledger_from(stream);
+}
+
+void CorrectionElement::write_settings_to(std::ostream & stream) const
 {
   this->ElementBase::write_to(stream);
   binary_out(stream, m_correction_start_date);
-  binary_out(stream, m_dosed_amounts);
 }
 
-void CorrectionElement::read_from(std::istream & stream)
+void CorrectionElement::read_settings_from(std::istream & stream)
 {
   this->ElementBase::read_from(stream);
   binary_in(stream, m_correction_start_date);
-  binary_in(stream, m_dosed_amounts);
+}
+
+void CorrectionElement::write_ledger_to(std::ostream & stream) const
+{
+  _get_ledger().write_to(stream);
+}
+
+void CorrectionElement::read_ledger_from(std::istream & stream)
+{
+  m_pending_ledger.clear();
+  m_ledger_pending.store(false, std::memory_order_release);
+  m_dosed_amounts.read_from(stream);
+}
+
+void CorrectionElement::defer_ledger(std::string bytes, const size_t version)
+{
+  m_pending_ledger = std::move(bytes);
+  m_pending_ledger_version = version;
+  m_dosed_amounts.clear();
+  m_ledger_pending.store(true, std::memory_order_release);
+}
+
+const DoseLedger & CorrectionElement::_get_ledger() const
+{
+  if (m_ledger_pending.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock{m_ledger_mutex};
+    if (m_ledger_pending.load(std::memory_order_relaxed)) {
+      MemoryStream stream{m_pending_ledger};
+      m_dosed_amounts.read_from(stream, m_pending_ledger_version);
+      m_pending_ledger.clear();
+      m_ledger_pending.store(false, std::memory_order_release);
+    }
+  }
+  return m_dosed_amounts;
 }
 
 /* stream operators */
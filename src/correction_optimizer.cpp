@@ -0,0 +1,158 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/correction_optimizer.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+
+/// remaining doses smaller than this can not be measured out
+constexpr double min_dose_ml = 0.01;
+
+}  // namespace
+
+namespace reef_moonshiners
+{
+
+double CorrectionSolution::get_dose(const size_t element, const size_t day) const
+{
+  return doses[day * days_to_target.size() + element];
+}
+
+CorrectionOptimizer::CorrectionOptimizer(const CorrectionConstraints & constraints)
+: m_constraints(constraints)
+{
+}
+
+const CorrectionConstraints & CorrectionOptimizer::get_constraints() const
+{
+  return m_constraints;
+}
+
+void CorrectionOptimizer::set_constraints(const CorrectionConstraints & constraints)
+{
+  m_constraints = constraints;
+}
+
+CorrectionSolution CorrectionOptimizer::solve(
+  const std::vector<const CorrectionElement *> & elements) const
+{
+  const size_t count = elements.size();
+  const size_t interval = std::max<size_t>(1, m_constraints.min_interval);
+  CorrectionSolution solution;
+  solution.days_to_target.assign(count, 0);
+
+  std::vector<double> remaining(count);
+  std::vector<double> max_dose(count);
+  /* first day each element may be dosed again */
+  std::vector<size_t> next_day(count, 0);
+  for (size_t e = 0; e < count; ++e) {
+    max_dose[e] = elements[e]->get_max_daily_dose();
+    remaining[e] = (max_dose[e] > 0.0) ? elements[e]->get_correction_total() : 0.0;
+  }
+
+  std::vector<size_t> active;
+  std::vector<double> today(count);
+  for (size_t day = 0; ; ++day) {
+    /* corrections that are not done, by most days of work left */
+    active.clear();
+    bool pending = false;
+    for (size_t e = 0; e < count; ++e) {
+      if (remaining[e] < min_dose_ml) {
+        continue;
+      }
+      pending = true;
+      if (next_day[e] <= day) {
+        active.push_back(e);
+      }
+    }
+    if (!pending) {
+      break;
+    }
+    if (day == m_constraints.horizon) {
+      solution.complete = false;
+      break;
+    }
+    std::stable_sort(
+      active.begin(), active.end(), [&](const size_t lhs, const size_t rhs) {
+        return remaining[lhs] / max_dose[lhs] > remaining[rhs] / max_dose[rhs];
+      });
+    if (0 != m_constraints.max_elements_per_day &&
+      active.size() > m_constraints.max_elements_per_day)
+    {
+      active.resize(m_constraints.max_elements_per_day);
+    }
+
+    std::fill(today.begin(), today.end(), 0.0);
+    double wanted = 0.0;
+    for (const size_t e : active) {
+      today[e] = std::min(max_dose[e], remaining[e]);
+      wanted += today[e];
+    }
+    if (0.0 < m_constraints.daily_budget && m_constraints.daily_budget < wanted) {
+      /**
+       * Water-fill the budget: find the level, in days of work left, down to
+       * which the budget can bring every correction.
+       */
+      double low = 0.0;
+      double high = 0.0;
+      for (const size_t e : active) {
+        high = std::max(high, remaining[e] / max_dose[e]);
+      }
+      const auto fill = [&](const double level) {
+          double total = 0.0;
+          for (const size_t e : active) {
+            today[e] = std::clamp(
+              remaining[e] - level * max_dose[e], 0.0, std::min(max_dose[e], remaining[e]));
+            total += today[e];
+          }
+          return total;
+        };
+      for (int iteration = 0; iteration < 64; ++iteration) {
+        const double level = 0.5 * (low + high);
+        if (fill(level) > m_constraints.daily_budget) {
+          low = level;
+        } else {
+          high = level;
+        }
+      }
+      fill(high);
+    }
+
+    for (const size_t e : active) {
+      const double dose = truncate_places<2>(today[e]);
+      today[e] = dose;
+      if (dose <= 0.0) {
+        continue;
+      }
+      remaining[e] -= dose;
+      next_day[e] = day + interval;
+      solution.days_to_target[e] = day + 1;
+    }
+    solution.doses.insert(solution.doses.end(), today.begin(), today.end());
+    solution.days = day + 1;
+  }
+  /* trailing days on which nothing could be dosed */
+  solution.days = std::accumulate(
+    solution.days_to_target.begin(), solution.days_to_target.end(),
+    solution.complete ? size_t{0} : solution.days,
+    [](const size_t lhs, const size_t rhs) {return std::max(lhs, rhs);});
+  solution.doses.resize(solution.days * count);
+  return solution;
+}
+
+}  // namespace reef_moonshiners
@@ -14,6 +14,7 @@
 
 #include <reef_moonshiners/daily_element.hpp>
 
+#include <algorithm>
 #include <cmath>
 
 namespace reef_moonshiners
@@ -30,28 +31,51 @@ DailyElement::DailyElement(
 
 double DailyElement::get_dose(const std::chrono::year_month_day &) const
 {
-  if (m_use_nano_dose) {
-    return get_nano_dose();
-  }
-  if (this->get_current_concentration_estimate() >= this->get_target_concentration()) {
-    /* no need to supplement this, we should not be detecting these elements */
-    return 0.0;
+  return _get_dose_for_target(this->get_target_concentration());
+}
+
+void DailyElement::fill_doses(
+  const std::chrono::year_month_day & start,
+  std::span<double> doses) const
+{
+  if (doses.empty()) {
+    return;
   }
-  const double dose_in_liters =
-    ((this->get_target_concentration() * this->get_tank_size()) /
-    (this->get_element_concentration() - this->get_target_concentration()));
-  return round_places<2>(dose_in_liters * 1E3) * m_multiplier;
+  /* dailies (and droppers) dose the same amount every day */
+  std::fill(doses.begin(), doses.end(), this->get_dose(start));
+}
+
+bool DailyElement::is_same_dose_every_day() const
+{
+  return true;
 }
 
 double DailyElement::get_nano_dose() const
 {
-  if (this->get_current_concentration_estimate() >= this->get_target_concentration()) {
+  return _calculate_dose(this->get_target_concentration(), m_nano_concentration);
+}
+
+double DailyElement::_get_dose_for_target(const double target_concentration) const
+{
+  return _calculate_dose(target_concentration, this->get_dose_concentration());
+}
+
+double DailyElement::get_dose_concentration() const
+{
+  return m_use_nano_dose ? m_nano_concentration : this->get_element_concentration();
+}
+
+double DailyElement::_calculate_dose(
+  const double target_concentration,
+  const double supplement_concentration) const
+{
+  if (this->get_current_concentration_estimate() >= target_concentration) {
     /* no need to supplement this, we should not be detecting these elements */
     return 0.0;
   }
   const double dose_in_liters =
-    ((this->get_target_concentration() * this->get_tank_size()) /
-    (m_nano_concentration - this->get_target_concentration()));
+    ((target_concentration * this->get_tank_volume()) /
+    (supplement_concentration - target_concentration));
   return round_places<2>(dose_in_liters * 1E3) * m_multiplier;
 }
 
@@ -75,6 +99,7 @@ double DailyElement::get_multiplier() const
 void DailyElement::set_multiplier(const double _multiplier)
 {
   m_multiplier = _multiplier;
+  _bump_generation();
 }
 
 bool DailyElement::get_use_nano_dose() const
@@ -85,14 +110,14 @@ bool DailyElement::get_use_nano_dose() const
 void DailyElement::set_use_nano_dose(const bool _use_nano_dose)
 {
   m_use_nano_dose = _use_nano_dose;
+  _bump_generation();
 }
 
 void DailyElement::write_to(std::ostream & stream) const
 {
   this->ElementBase::write_to(stream);
   binary_out(stream, m_multiplier);
-  int as_int = m_use_nano_dose;
-  binary_out(stream, (int)as_int);
+  binary_out(stream, static_cast<int32_t>(m_use_nano_dose));
 }
 
 void DailyElement::read_from(std::istream & stream)
@@ -100,7 +125,7 @@ void DailyElement::read_from(std::istream & stream)
   this->ElementBase::read_from(stream);
   binary_in(stream, m_multiplier);
   if (reef_moonshiners::ElementBase::m_load_version >= 3) {
-    int nano_dose;
+    int32_t nano_dose = 0;
     binary_in(stream, nano_dose);
     m_use_nano_dose = nano_dose;
   }
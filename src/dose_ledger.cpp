@@ -0,0 +1,323 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/dose_ledger.hpp>
+#include <reef_moonshiners/element_base.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace reef_moonshiners
+{
+
+int32_t DoseLedger::_to_day_index(const std::chrono::year_month_day & date)
+{
+  return static_cast<int32_t>(std::chrono::sys_days{date}.time_since_epoch().count());
+}
+
+int32_t DoseLedger::_chunk_key(const int32_t day_index)
+{
+  /* round toward negative infinity so dates before the epoch chunk correctly */
+  return (day_index >= 0) ? (day_index / chunk_days) : ((day_index + 1) / chunk_days - 1);
+}
+
+double DoseLedger::_chunk_sum(const Chunk & chunk, const int32_t first, const int32_t last)
+{
+  double sum = 0.0;
+  for (int32_t x = first; x < last; ++x) {
+    sum += chunk.doses[x];
+  }
+  return sum;
+}
+
+void DoseLedger::set(const std::chrono::year_month_day & date, const double dose_ml)
+{
+  const int32_t day = _to_day_index(date);
+  const int32_t key = _chunk_key(day);
+  size_t idx = m_keys.size();
+  /* doses are almost always recorded in order, so check the back first */
+  if (m_keys.empty() || m_keys.back() < key) {
+    m_keys.push_back(key);
+    m_chunks.emplace_back();
+    m_prefix.push_back(m_prefix.back());
+    idx = m_keys.size() - 1;
+  } else {
+    const auto iter = std::lower_bound(m_keys.begin(), m_keys.end(), key);
+    idx = static_cast<size_t>(iter - m_keys.begin());
+    if (*iter != key) {
+      m_keys.insert(iter, key);
+      m_chunks.emplace(m_chunks.begin() + idx);
+      m_prefix.push_back(0.0);
+    }
+  }
+  Chunk & chunk = m_chunks[idx];
+  const int32_t offset = day - key * chunk_days;
+  const uint32_t bit = uint32_t{1} << offset;
+  if (0 == (chunk.present & bit)) {
+    chunk.present |= bit;
+    ++m_size;
+  }
+  chunk.doses[offset] = dose_ml;
+  _update_prefix(idx);
+}
+
+double DoseLedger::get(const std::chrono::year_month_day & date) const
+{
+  const int32_t day = _to_day_index(date);
+  const int32_t key = _chunk_key(day);
+  const auto iter = std::lower_bound(m_keys.begin(), m_keys.end(), key);
+  if (iter == m_keys.end() || *iter != key) {
+    return 0.0;
+  }
+  return m_chunks[iter - m_keys.begin()].doses[day - key * chunk_days];
+}
+
+double DoseLedger::total(
+  const std::chrono::year_month_day & from,
+  const std::chrono::year_month_day & to) const
+{
+  const int32_t first = _to_day_index(from);
+  const int32_t last = _to_day_index(to);
+  if (last <= first) {
+    return 0.0;
+  }
+  const int32_t first_key = _chunk_key(first);
+  const int32_t last_key = _chunk_key(last);
+  const auto lo = std::lower_bound(m_keys.begin(), m_keys.end(), first_key);
+  const auto hi = std::lower_bound(lo, m_keys.end(), last_key);
+  size_t full_begin = static_cast<size_t>(lo - m_keys.begin());
+  const size_t full_end = static_cast<size_t>(hi - m_keys.begin());
+  const bool has_last = (hi != m_keys.end() && *hi == last_key);
+  if (first_key == last_key) {
+    /* range lies within one chunk */
+    if (!has_last) {
+      return 0.0;
+    }
+    return _chunk_sum(
+      m_chunks[full_end], first - first_key * chunk_days, last - last_key * chunk_days);
+  }
+  double sum = 0.0;
+  if (lo != m_keys.end() && *lo == first_key) {
+    sum += _chunk_sum(m_chunks[full_begin], first - first_key * chunk_days, chunk_days);
+    ++full_begin;
+  }
+  if (full_end > full_begin) {
+    sum += m_prefix[full_end] - m_prefix[full_begin];
+  }
+  if (has_last) {
+    sum += _chunk_sum(m_chunks[full_end], 0, last - last_key * chunk_days);
+  }
+  return sum;
+}
+
+size_t DoseLedger::size() const
+{
+  return m_size;
+}
+
+bool DoseLedger::empty() const
+{
+  return 0 == m_size;
+}
+
+void DoseLedger::clear()
+{
+  m_keys.clear();
+  m_chunks.clear();
+  m_prefix.assign(1, 0.0);
+  m_size = 0;
+}
+
+void DoseLedger::_update_prefix(const size_t first)
+{
+  for (size_t x = first; x < m_chunks.size(); ++x) {
+    m_prefix[x + 1] = m_prefix[x] + _chunk_sum(m_chunks[x], 0, chunk_days);
+  }
+}
+
+bool DoseLedger::quantize(const double dose_ml, int64_t & hundredths)
+{
+  /* beyond this, hundredths of a mL no longer fit in a double exactly */
+  if (!(std::abs(dose_ml) < 1E13)) {
+    return false;
+  }
+  hundredths = std::llround(dose_ml * 100);
+  /* equal doubles are identical, except for the sign of zero */
+  return dequantize(hundredths) == dose_ml && !(0.0 == dose_ml && std::signbit(dose_ml));
+}
+
+void DoseLedger::write_to(std::ostream & stream) const
+{
+  /* runs need their length up front, so find them first */
+  std::vector<uint64_t> runs;
+  int64_t end = 0;
+  this->for_each(
+    [&](const std::chrono::year_month_day & date, const double) {
+      const int64_t day = _to_day_index(date);
+      if (runs.empty() || day != end) {
+        runs.push_back(0);
+      }
+      ++runs.back();
+      end = day + 1;
+    });
+  binary_out(stream, compact_magic);
+  binary_out_varint(stream, runs.size());
+  size_t run = 0;
+  size_t remaining = 0;
+  int64_t hundredths = 0;
+  this->for_each(
+    [&](const std::chrono::year_month_day & date, const double dose_ml) {
+      const int64_t day = _to_day_index(date);
+      if (0 == remaining) {
+        binary_out_varint(
+          stream, (0 == run) ? zigzag_encode(day) : static_cast<uint64_t>(day - end));
+        remaining = runs[run++];
+        binary_out_varint(stream, remaining);
+      }
+      --remaining;
+      end = day + 1;
+      int64_t quantized = 0;
+      if (quantize(dose_ml, quantized)) {
+        binary_out_varint(stream, zigzag_encode(quantized - hundredths) << 1);
+        hundredths = quantized;
+      } else {
+        binary_out_varint(stream, 1);
+        binary_out(stream, dose_ml);
+      }
+    });
+}
+
+void DoseLedger::read_from(std::istream & stream)
+{
+  this->read_from(stream, ElementBase::get_load_version());
+}
+
+void DoseLedger::read_from(std::istream & stream, const size_t version)
+{
+  this->clear();
+  if (version < 4) {
+    _read_legacy(stream);
+    return;
+  }
+  /* versions 4 and 5 began with a chunk count, which never matches the magic */
+  uint64_t first = 0;
+  binary_in(stream, first);
+  if (compact_magic == first) {
+    _read_compact(stream);
+  } else {
+    _read_chunks(stream, first);
+  }
+}
+
+void DoseLedger::_read_compact(std::istream & stream)
+{
+  /* keep days within what _to_day_index can represent */
+  constexpr int64_t max_day = std::numeric_limits<int32_t>::max();
+  constexpr int64_t min_day = std::numeric_limits<int32_t>::min();
+  uint64_t runs = 0;
+  binary_in_varint(stream, runs);
+  int64_t day = 0;
+  int64_t hundredths = 0;
+  for (uint64_t run = 0; run < runs && stream; ++run) {
+    uint64_t start = 0;
+    uint64_t length = 0;
+    binary_in_varint(stream, start);
+    binary_in_varint(stream, length);
+    if (0 == run) {
+      day = zigzag_decode(start);
+    } else if (start > static_cast<uint64_t>(max_day - day)) {
+      length = 0;
+    } else {
+      day += static_cast<int64_t>(start);
+    }
+    if (0 == length) {
+      stream.setstate(std::ios::failbit);
+      return;
+    }
+    for (uint64_t x = 0; x < length && stream; ++x, ++day) {
+      if (day < min_day || day > max_day) {
+        stream.setstate(std::ios::failbit);
+        return;
+      }
+      uint64_t entry = 0;
+      double dose_ml = 0.0;
+      binary_in_varint(stream, entry);
+      if (entry & 1) {
+        binary_in(stream, dose_ml);
+      } else {
+        /* wrap rather than overflow on a corrupt difference */
+        hundredths = static_cast<int64_t>(
+          static_cast<uint64_t>(hundredths) + static_cast<uint64_t>(zigzag_decode(entry >> 1)));
+        dose_ml = dequantize(hundredths);
+      }
+      if (stream) {
+        this->set(
+          std::chrono::year_month_day{std::chrono::sys_days{std::chrono::days{day}}}, dose_ml);
+      }
+    }
+  }
+}
+
+void DoseLedger::_read_chunks(std::istream & stream, uint64_t len)
+{
+  /* chunks were written in order, so they are appended as-is */
+  for (; len-- > 0 && stream; ) {
+    int32_t key = 0;
+    binary_in(stream, key);
+    if (!m_keys.empty() && key <= m_keys.back()) {
+      /* lookups rely on the keys strictly increasing */
+      stream.setstate(std::ios::failbit);
+      return;
+    }
+    m_keys.push_back(key);
+    Chunk & chunk = m_chunks.emplace_back();
+    binary_in(stream, chunk.present);
+    for (int32_t day = 0; day < chunk_days; ++day) {
+      if (chunk.present & (uint32_t{1} << day)) {
+        binary_in(stream, chunk.doses[day]);
+        ++m_size;
+      }
+    }
+    m_prefix.push_back(m_prefix.back() + _chunk_sum(chunk, 0, chunk_days));
+  }
+}
+
+void DoseLedger::_read_legacy(std::istream & stream)
+{
+  /* versions prior to 4 stored a std::unordered_map of date -> dose */
+  uint64_t len = 0;
+  binary_in(stream, len);
+
+  /* the map was written in hash order, so sort before appending */
+  std::vector<std::pair<std::chrono::year_month_day, double>> doses;
+  std::chrono::year_month_day date;
+  double dose_ml = 0.0;
+  for (; len-- > 0 && stream; ) {
+    binary_in(stream, date);
+    binary_in(stream, dose_ml);
+    if (stream) {
+      doses.emplace_back(date, dose_ml);
+    }
+  }
+  std::sort(
+    doses.begin(), doses.end(),
+    [](const auto & lhs, const auto & rhs) {return lhs.first < rhs.first;});
+  for (const auto & [day, dose] : doses) {
+    this->set(day, dose);
+  }
+}
+
+}  // namespace reef_moonshiners
@@ -0,0 +1,177 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/dose_list.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+
+/**
+ * @brief Add an edit, extending the last one if it continues its run
+ */
+void add_edit(
+  std::vector<reef_moonshiners::DoseRowEdit> & edits,
+  const reef_moonshiners::DoseRowEditType type, const size_t row)
+{
+  if (!edits.empty() && edits.back().type == type) {
+    auto & last = edits.back();
+    /* removed rows close up, so a run of removals stays on one row */
+    const size_t next = (reef_moonshiners::DoseRowEditType::REMOVE == type) ?
+      last.row : last.row + last.count;
+    if (next == row) {
+      ++last.count;
+      return;
+    }
+  }
+  edits.push_back(reef_moonshiners::DoseRowEdit{type, row, 1});
+}
+
+}  // namespace
+
+namespace reef_moonshiners
+{
+
+void get_dose_rows(
+  const DoseSchedule & schedule, const std::chrono::year_month_day & date,
+  std::vector<DoseRow> & rows)
+{
+  rows.clear();
+  if (!schedule.contains(date)) {
+    return;
+  }
+  for (size_t element = 0; element < schedule.get_element_count(); ++element) {
+    const double dose = schedule.get_dose(element, date);
+    if (0.0 != dose) {
+      rows.push_back(DoseRow{element, dose});
+    }
+  }
+}
+
+void diff_dose_rows(
+  std::span<const DoseRow> from, std::span<const DoseRow> to, std::vector<DoseRowEdit> & edits)
+{
+  edits.clear();
+  size_t x = 0, y = 0, row = 0;
+  while (x < from.size() || y < to.size()) {
+    if (x < from.size() && y < to.size() && from[x].element == to[y].element) {
+      if (from[x].dose != to[y].dose) {
+        add_edit(edits, DoseRowEditType::CHANGE, row);
+      }
+      ++x;
+      ++y;
+      ++row;
+    } else if (y == to.size() || (x < from.size() && from[x].element < to[y].element)) {
+      add_edit(edits, DoseRowEditType::REMOVE, row);
+      ++x;
+    } else {
+      add_edit(edits, DoseRowEditType::INSERT, row);
+      ++y;
+      ++row;
+    }
+  }
+}
+
+void apply_dose_row_edit(
+  std::vector<DoseRow> & rows, const DoseRowEdit & edit, std::span<const DoseRow> to)
+{
+  /* the rows before the edit already match, so its rows in to line up with it */
+  const auto first = rows.begin() + static_cast<std::ptrdiff_t>(edit.row);
+  const auto source = to.begin() + static_cast<std::ptrdiff_t>(edit.row);
+  const auto count = static_cast<std::ptrdiff_t>(edit.count);
+  switch (edit.type) {
+    case DoseRowEditType::INSERT:
+      rows.insert(first, source, source + count);
+      break;
+    case DoseRowEditType::REMOVE:
+      rows.erase(first, first + count);
+      break;
+    case DoseRowEditType::CHANGE:
+      std::copy(source, source + count, first);
+      break;
+  }
+}
+
+DoseList::DoseList(std::vector<const ElementBase *> elements)
+: m_elements(std::move(elements)),
+  m_generations(m_elements.size())
+{
+}
+
+const std::vector<DoseRowEdit> & DoseList::update(const std::chrono::year_month_day & date)
+{
+  const bool moving = !m_schedule.contains(date);
+  const std::chrono::sys_days day{date};
+  const std::chrono::year_month_day start{day - days_before};
+  const std::chrono::year_month_day end{day + days_after};
+  if (moving && 0 == m_schedule.get_day_count()) {
+    for (size_t element = 0; element < m_elements.size(); ++element) {
+      m_generations[element] = m_elements[element]->get_generation();
+    }
+    m_schedule = DoseSchedule{start, end, m_elements};
+  } else {
+    if (moving) {
+      /* center the schedule on the new day, keeping the doses that are the same every day */
+      m_schedule.move(start, end);
+    }
+    for (size_t element = 0; element < m_elements.size(); ++element) {
+      const uint64_t generation = m_elements[element]->get_generation();
+      /* moving recomputed the rest already */
+      if (generation != m_generations[element] &&
+        (!moving || m_elements[element]->is_same_dose_every_day()))
+      {
+        m_schedule.update(element);
+      }
+      m_generations[element] = generation;
+    }
+  }
+  m_date = date;
+  get_dose_rows(m_schedule, date, m_next_rows);
+  diff_dose_rows(m_rows, m_next_rows, m_edits);
+  return m_edits;
+}
+
+void DoseList::apply(const DoseRowEdit & edit)
+{
+  apply_dose_row_edit(m_rows, edit, m_next_rows);
+}
+
+std::span<const DoseRow> DoseList::get_rows() const
+{
+  return m_rows;
+}
+
+const std::chrono::year_month_day & DoseList::get_date() const
+{
+  return m_date;
+}
+
+size_t DoseList::get_element_count() const
+{
+  return m_elements.size();
+}
+
+const ElementBase * DoseList::get_element(const size_t element) const
+{
+  return m_elements[element];
+}
+
+const DoseSchedule & DoseList::get_schedule() const
+{
+  return m_schedule;
+}
+
+}  // namespace reef_moonshiners
@@ -0,0 +1,103 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/ui/dose_list_model.hpp>
+
+#include <utility>
+
+namespace reef_moonshiners::ui
+{
+
+DoseListModel::DoseListModel(
+  std::vector<const reef_moonshiners::ElementBase *> elements, QObject * parent)
+: QAbstractListModel(parent),
+  m_list(std::move(elements))
+{
+  m_checked.resize(m_list.get_element_count(), false);
+}
+
+int DoseListModel::rowCount(const QModelIndex & parent) const
+{
+  /* a list has no children */
+  return parent.isValid() ? 0 : static_cast<int>(m_list.get_rows().size());
+}
+
+QVariant DoseListModel::data(const QModelIndex & index, int role) const
+{
+  if (!index.isValid() || index.row() >= this->rowCount()) {
+    return QVariant{};
+  }
+  const auto & row = m_list.get_rows()[static_cast<size_t>(index.row())];
+  switch (role) {
+    case Qt::DisplayRole:
+      {
+        const auto * element = m_list.get_element(row.element);
+        return QString::fromStdString(element->get_name()) + QString("\t") +
+               QString::number(row.dose) + QString(" ") +
+               QString::fromStdString(element->get_dosing_unit_str());
+      }
+    case Qt::CheckStateRole:
+      return m_checked[row.element] ? Qt::Checked : Qt::Unchecked;
+  }
+  return QVariant{};
+}
+
+Qt::ItemFlags DoseListModel::flags(const QModelIndex & index) const
+{
+  if (!index.isValid()) {
+    return Qt::NoItemFlags;
+  }
+  /* not user checkable, as MainWindow toggles the row on any click */
+  return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+void DoseListModel::set_date(const QDate & date)
+{
+  int year, month, day;
+  date.getDate(&year, &month, &day);
+  const std::chrono::year_month_day selected{
+    std::chrono::year(year), std::chrono::month(month), std::chrono::day(day)};
+  for (const auto & edit : m_list.update(selected)) {
+    const int first = static_cast<int>(edit.row);
+    const int last = static_cast<int>(edit.row + edit.count) - 1;
+    switch (edit.type) {
+      case reef_moonshiners::DoseRowEditType::INSERT:
+        this->beginInsertRows(QModelIndex{}, first, last);
+        m_list.apply(edit);
+        this->endInsertRows();
+        break;
+      case reef_moonshiners::DoseRowEditType::REMOVE:
+        this->beginRemoveRows(QModelIndex{}, first, last);
+        m_list.apply(edit);
+        this->endRemoveRows();
+        break;
+      case reef_moonshiners::DoseRowEditType::CHANGE:
+        m_list.apply(edit);
+        Q_EMIT (dataChanged(this->index(first), this->index(last), {Qt::DisplayRole}));
+        break;
+    }
+  }
+}
+
+void DoseListModel::toggle_checked(const QModelIndex & index)
+{
+  if (!index.isValid() || index.row() >= this->rowCount()) {
+    return;
+  }
+  const auto & row = m_list.get_rows()[static_cast<size_t>(index.row())];
+  m_checked[row.element] = !m_checked[row.element];
+  Q_EMIT (dataChanged(index, index, {Qt::CheckStateRole}));
+}
+
+}  // namespace reef_moonshiners::ui
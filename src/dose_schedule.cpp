@@ -0,0 +1,131 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/dose_schedule.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+
+size_t get_days_between(
+  const std::chrono::year_month_day & start,
+  const std::chrono::year_month_day & end)
+{
+  const auto days = std::chrono::sys_days{end} - std::chrono::sys_days{start};
+  return (days.count() > 0) ? static_cast<size_t>(days.count()) : 0;
+}
+
+}  // namespace
+
+namespace reef_moonshiners
+{
+
+DoseSchedule::DoseSchedule(
+  const std::chrono::year_month_day & start,
+  const std::chrono::year_month_day & end,
+  std::vector<const ElementBase *> elements)
+: m_start_date(start),
+  m_end_date(end),
+  m_elements(std::move(elements))
+{
+  m_days = get_days_between(start, end);
+  m_doses.resize(m_elements.size() * m_days);
+  this->update();
+}
+
+void DoseSchedule::update()
+{
+  for (size_t element = 0; element < m_elements.size(); ++element) {
+    this->update(element);
+  }
+}
+
+void DoseSchedule::update(const size_t element)
+{
+  m_elements[element]->fill_doses(
+    m_start_date, std::span<double>(m_doses.data() + element * m_days, m_days));
+}
+
+void DoseSchedule::move(
+  const std::chrono::year_month_day & start,
+  const std::chrono::year_month_day & end)
+{
+  const size_t days = get_days_between(start, end);
+  /* only doses computed before can be kept */
+  const bool keep = m_days > 0;
+  if (days != m_days) {
+    std::vector<double> doses(m_elements.size() * days);
+    for (size_t element = 0; keep && element < m_elements.size(); ++element) {
+      if (m_elements[element]->is_same_dose_every_day()) {
+        std::fill_n(
+          doses.begin() + static_cast<std::ptrdiff_t>(element * days), days,
+          m_doses[element * m_days]);
+      }
+    }
+    m_doses = std::move(doses);
+  }
+  m_start_date = start;
+  m_end_date = end;
+  m_days = days;
+  for (size_t element = 0; element < m_elements.size(); ++element) {
+    if (!keep || !m_elements[element]->is_same_dose_every_day()) {
+      this->update(element);
+    }
+  }
+}
+
+const std::chrono::year_month_day & DoseSchedule::get_start_date() const
+{
+  return m_start_date;
+}
+
+const std::chrono::year_month_day & DoseSchedule::get_end_date() const
+{
+  return m_end_date;
+}
+
+size_t DoseSchedule::get_day_count() const
+{
+  return m_days;
+}
+
+size_t DoseSchedule::get_element_count() const
+{
+  return m_elements.size();
+}
+
+const ElementBase * DoseSchedule::get_element(const size_t element) const
+{
+  return m_elements[element];
+}
+
+bool DoseSchedule::contains(const std::chrono::year_month_day & date) const
+{
+  return m_days > 0 && m_start_date <= date && date < m_end_date;
+}
+
+double DoseSchedule::get_dose(const size_t element, const std::chrono::year_month_day & date) const
+{
+  const auto day = std::chrono::sys_days{date} - std::chrono::sys_days{m_start_date};
+  return m_doses[element * m_days + static_cast<size_t>(day.count())];
+}
+
+std::span<const double> DoseSchedule::get_doses(const size_t element) const
+{
+  return std::span<const double>(m_doses.data() + element * m_days, m_days);
+}
+
+}  // namespace reef_moonshiners
@@ -35,6 +35,12 @@ void DropperElement::set_multiplier(const double)
 void DropperElement::set_drops(const size_t _drops)
 {
   m_drops = _drops;
+  _bump_generation();
+}
+
+size_t DropperElement::get_drops() const
+{
+  return m_drops;
 }
 
 double DropperElement::get_dose(const std::chrono::year_month_day &) const
@@ -55,13 +61,15 @@ bool DropperElement::is_high() const
 void DropperElement::write_to(std::ostream & stream) const
 {
   this->ElementBase::write_to(stream);
-  binary_out(stream, m_drops);
+  binary_out(stream, static_cast<uint64_t>(m_drops));
 }
 
 void DropperElement::read_from(std::istream & stream)
 {
   this->ElementBase::read_from(stream);
-  binary_in(stream, m_drops);
+  uint64_t drops = 0;
+  binary_in(stream, drops);
+  m_drops = static_cast<size_t>(drops);
 }
 
 }  // namespace reef_moonshiners
@@ -27,6 +27,7 @@ ElementBase::ElementBase(
   const std::string & _name, const double _element_concentration,
   const double _target_concentration, const double _max_adjustment)
 : m_name(_name),
+  m_icp_element(find_icp_element(_name)),
   m_element_concentration(_element_concentration),
   m_target_concentration(_target_concentration),
   m_max_adjustment(_max_adjustment)
@@ -40,16 +41,52 @@ const std::string & ElementBase::get_name() const
 void ElementBase::set_name(const std::string & _name)
 {
   m_name = _name;
+  m_icp_element = find_icp_element(_name);
+  _bump_generation();
+}
+
+IcpElement ElementBase::get_icp_element() const
+{
+  return m_icp_element;
 }
 
 void ElementBase::set_tank_size(const double _tank_size)
 {
-  m_tank_size = _tank_size;
+  Tank::get_default()->set_volume(_tank_size);
 }
 
 double ElementBase::get_tank_size()
 {
-  return m_tank_size;
+  return Tank::get_default()->get_volume();
+}
+
+double ElementBase::get_tank_volume() const
+{
+  return m_p_tank->get_volume();
+}
+
+void ElementBase::set_tank(std::shared_ptr<Tank> _tank)
+{
+  const uint64_t generation = this->get_generation();
+  m_p_tank = std::move(_tank);
+  /* keep counting up from where we were, even if the new tank is "younger" */
+  m_generation = generation + 1 - m_p_tank->get_generation();
+}
+
+const std::shared_ptr<Tank> & ElementBase::get_tank() const
+{
+  return m_p_tank;
+}
+
+uint64_t ElementBase::get_generation() const
+{
+  /* unsigned, so this wraps consistently with set_tank */
+  return m_generation + m_p_tank->get_generation();
+}
+
+void ElementBase::_bump_generation()
+{
+  ++m_generation;
 }
 
 double ElementBase::get_max_daily_dosage() const
@@ -72,9 +109,31 @@ double ElementBase::get_element_concentration() const
   return m_element_concentration;
 }
 
+double ElementBase::get_dose_concentration() const
+{
+  return m_element_concentration;
+}
+
+void ElementBase::fill_doses(
+  const std::chrono::year_month_day & start,
+  std::span<double> doses) const
+{
+  std::chrono::sys_days day{start};
+  for (double & dose : doses) {
+    dose = this->get_dose(std::chrono::year_month_day{day});
+    day += std::chrono::days(1);
+  }
+}
+
+bool ElementBase::is_same_dose_every_day() const
+{
+  return false;
+}
+
 void ElementBase::set_dosing_unit(DosingUnit _dosing_unit)
 {
   m_dosing_unit = _dosing_unit;
+  _bump_generation();
 }
 
 DosingUnit ElementBase::get_dosing_unit() const
@@ -103,6 +162,7 @@ void ElementBase::set_concentration(
 {
   m_last_measured_concentration = _concentration;
   m_last_measurement = _date;
+  _bump_generation();
 }
 
 double ElementBase::_get_concentration_after_dose(
@@ -112,16 +172,17 @@ double ElementBase::_get_concentration_after_dose(
   /* added amount of element in micrograms */
   const double added_micrograms_of_element = (_dose_ml * 1E-3) * m_element_concentration;
   /* current amount of element in micrograms */
-  const double current_micrograms_of_element = _prior_concentration * m_tank_size;
+  const double tank_volume = m_p_tank->get_volume();
+  const double current_micrograms_of_element = _prior_concentration * tank_volume;
   const double total_micrograms = added_micrograms_of_element + current_micrograms_of_element;
   /* assuming negligible added water due to evaporation, we use the tank volume */
-  return total_micrograms / m_tank_size;
+  return total_micrograms / tank_volume;
 }
 
 double ElementBase::_max_daily_dosage_l(const double concentration) const
 {
   /* max adjustment is in ug / (L * day) */
-  return (m_max_adjustment * m_tank_size) /
+  return (m_max_adjustment * m_p_tank->get_volume()) /
          (m_element_concentration - concentration - m_max_adjustment);
 }
 
@@ -140,6 +201,7 @@ void ElementBase::write_to(std::ostream & stream) const
 void ElementBase::read_from(std::istream & stream)
 {
   binary_in(stream, m_name);
+  m_icp_element = find_icp_element(m_name);
   binary_in(stream, m_estimated_concentration);
   binary_in(stream, m_last_measurement);
   binary_in(stream, m_last_measured_concentration);
@@ -149,6 +211,7 @@ void ElementBase::read_from(std::istream & stream)
   if (m_load_version >= 1) {
     binary_in(stream, m_dosing_unit);
   }
+  _bump_generation();
 }
 
 /* stream operators */
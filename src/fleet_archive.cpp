@@ -0,0 +1,614 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/binary_io.hpp>
+#include <reef_moonshiners/correction_element.hpp>
+#include <reef_moonshiners/dropper_element.hpp>
+#include <reef_moonshiners/fleet_archive.hpp>
+#include <reef_moonshiners/mapped_file.hpp>
+#include <reef_moonshiners/rubidium_element.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace
+{
+
+using reef_moonshiners::BlockStats;
+using reef_moonshiners::SaveFile;
+
+enum class Encoding : uint8_t
+{
+  /// little-endian values
+  PLAIN = 0,
+  /// first value, then the differences between consecutive values
+  DELTA = 1
+};
+
+/**
+ * Contents of a "<column>/index" section
+ *
+ * Layout:
+ *   uint8_t encoding, uint8_t value width, uint64_t rows, uint32_t block rows
+ *   per block: double min, double max, uint64_t offset into the column
+ */
+struct ColumnIndex
+{
+  Encoding encoding = Encoding::PLAIN;
+  uint8_t width = 0;
+  uint64_t rows = 0;
+  uint32_t block_rows = 0;
+  std::vector<BlockStats> stats;
+  std::vector<uint64_t> offsets;
+};
+
+/// bytes of a delta block before its differences: first value and width
+constexpr size_t delta_header = sizeof(int32_t) + sizeof(uint8_t);
+
+int32_t to_day(const std::chrono::year_month_day & date)
+{
+  return static_cast<int32_t>(std::chrono::sys_days{date}.time_since_epoch().count());
+}
+
+std::chrono::year_month_day from_day(const int32_t day)
+{
+  return std::chrono::year_month_day{std::chrono::sys_days{std::chrono::days{day}}};
+}
+
+std::string index_name(const std::string & column)
+{
+  return column + "/index";
+}
+
+void write_index(std::ostream & stream, const ColumnIndex & index)
+{
+  reef_moonshiners::binary_out(stream, index.encoding);
+  reef_moonshiners::binary_out(stream, index.width);
+  reef_moonshiners::binary_out(stream, index.rows);
+  reef_moonshiners::binary_out(stream, index.block_rows);
+  for (size_t x = 0; x < index.offsets.size(); ++x) {
+    reef_moonshiners::binary_out(stream, index.stats[x].min);
+    reef_moonshiners::binary_out(stream, index.stats[x].max);
+    reef_moonshiners::binary_out(stream, index.offsets[x]);
+  }
+}
+
+bool read_index(const SaveFile & file, const std::string & column, ColumnIndex & index)
+{
+  if (!file.contains(column) || !file.contains(index_name(column))) {
+    return false;
+  }
+  reef_moonshiners::MemoryStream stream{file.get_section(index_name(column))};
+  reef_moonshiners::binary_in(stream, index.encoding);
+  reef_moonshiners::binary_in(stream, index.width);
+  reef_moonshiners::binary_in(stream, index.rows);
+  reef_moonshiners::binary_in(stream, index.block_rows);
+  if (!stream || 0 == index.width || (index.rows > 0 && 0 == index.block_rows)) {
+    return false;
+  }
+  /* the rows must fit the column's bytes before anything is sized from them */
+  const uint64_t column_size = file.get_section_size(column);
+  if (Encoding::PLAIN == index.encoding) {
+    if (index.rows > column_size / index.width || index.rows * index.width != column_size) {
+      return false;
+    }
+  } else if (Encoding::DELTA != index.encoding || index.rows > column_size) {
+    return false;
+  }
+  const uint64_t blocks = (0 == index.rows) ? 0 :
+    (index.rows + index.block_rows - 1) / index.block_rows;
+  /* each block takes 24 bytes of the index, so a corrupt row count cannot over-allocate */
+  constexpr uint64_t entry_size = 2 * sizeof(double) + sizeof(uint64_t);
+  if (blocks > file.get_section_size(index_name(column)) / entry_size) {
+    return false;
+  }
+  index.stats.resize(blocks);
+  index.offsets.resize(blocks);
+  for (uint64_t x = 0; x < blocks; ++x) {
+    reef_moonshiners::binary_in(stream, index.stats[x].min);
+    reef_moonshiners::binary_in(stream, index.stats[x].max);
+    reef_moonshiners::binary_in(stream, index.offsets[x]);
+    const uint64_t previous = (0 == x) ? 0 : index.offsets[x - 1];
+    if (index.offsets[x] < previous || index.offsets[x] > column_size) {
+      return false;
+    }
+  }
+  return static_cast<bool>(stream);
+}
+
+template<typename T>
+BlockStats block_stats(const T * values, const size_t count)
+{
+  const auto [min, max] = std::minmax_element(values, values + count);
+  return BlockStats{static_cast<double>(*min), static_cast<double>(*max)};
+}
+
+template<typename T>
+void write_plain(std::ostream & stream, const T * values, const size_t count)
+{
+  if constexpr (std::endian::native == std::endian::little) {
+    stream.write(reinterpret_cast<const char *>(values), count * sizeof(T));
+  } else {
+    for (size_t x = 0; x < count; ++x) {
+      reef_moonshiners::binary_out(stream, values[x]);
+    }
+  }
+}
+
+template<typename T>
+void read_plain(const char * bytes, T * values, const size_t count)
+{
+  if constexpr (std::endian::native == std::endian::little) {
+    std::memcpy(values, bytes, count * sizeof(T));
+  } else {
+    for (size_t x = 0; x < count; ++x) {
+      values[x] = reef_moonshiners::load_little_endian<T>(bytes + x * sizeof(T));
+    }
+  }
+}
+
+/**
+ * Write a block of dates as its first date and the differences between them
+ *
+ * Differences wrap as uint32_t, so any sequence of int32_t round-trips.
+ */
+void write_delta(std::ostream & stream, const int32_t * values, const size_t count)
+{
+  const auto delta = [values](const size_t x) {
+      return static_cast<int32_t>(
+        static_cast<uint32_t>(values[x]) - static_cast<uint32_t>(values[x - 1]));
+    };
+  int32_t widest = 0;
+  for (size_t x = 1; x < count; ++x) {
+    const int32_t step = delta(x);
+    widest = std::max(widest, (step < 0) ? ~step : step);
+  }
+  const uint8_t width = (widest <= std::numeric_limits<int8_t>::max()) ? 1 :
+    (widest <= std::numeric_limits<int16_t>::max()) ? 2 : 4;
+  reef_moonshiners::binary_out(stream, values[0]);
+  reef_moonshiners::binary_out(stream, width);
+  for (size_t x = 1; x < count; ++x) {
+    switch (width) {
+      case 1:
+        reef_moonshiners::binary_out(stream, static_cast<int8_t>(delta(x)));
+        break;
+      case 2:
+        reef_moonshiners::binary_out(stream, static_cast<int16_t>(delta(x)));
+        break;
+      default:
+        reef_moonshiners::binary_out(stream, delta(x));
+    }
+  }
+}
+
+bool read_delta(const std::string_view block, int32_t * values, const size_t count)
+{
+  if (block.size() < delta_header) {
+    return false;
+  }
+  const uint8_t width = static_cast<uint8_t>(block[sizeof(int32_t)]);
+  if ((1 != width && 2 != width && 4 != width) ||
+    block.size() != delta_header + (count - 1) * width)
+  {
+    return false;
+  }
+  uint32_t value = reef_moonshiners::load_little_endian<uint32_t>(block.data());
+  values[0] = static_cast<int32_t>(value);
+  const char * delta = block.data() + delta_header;
+  for (size_t x = 1; x < count; ++x, delta += width) {
+    int32_t step;
+    switch (width) {
+      case 1:
+        step = static_cast<int8_t>(*delta);
+        break;
+      case 2:
+        step = reef_moonshiners::load_little_endian<int16_t>(delta);
+        break;
+      default:
+        step = reef_moonshiners::load_little_endian<int32_t>(delta);
+    }
+    value += static_cast<uint32_t>(step);
+    values[x] = static_cast<int32_t>(value);
+  }
+  return true;
+}
+
+template<typename T>
+void write_column(
+  SaveFile & file, const std::string & name, const std::vector<T> & values,
+  const uint32_t block_rows, const Encoding encoding)
+{
+  ColumnIndex index;
+  index.encoding = encoding;
+  index.width = sizeof(T);
+  index.rows = values.size();
+  index.block_rows = block_rows;
+  std::ostream & data = file.add_section(name);
+  uint64_t offset = 0;
+  for (size_t first = 0; first < values.size(); first += block_rows) {
+    const size_t count = std::min<size_t>(block_rows, values.size() - first);
+    index.stats.push_back(block_stats(values.data() + first, count));
+    index.offsets.push_back(offset);
+    if constexpr (std::is_same_v<T, int32_t>) {
+      if (Encoding::DELTA == encoding) {
+        write_delta(data, values.data() + first, count);
+        offset = static_cast<uint64_t>(data.tellp());
+        continue;
+      }
+    }
+    write_plain(data, values.data() + first, count);
+    offset += count * sizeof(T);
+  }
+  write_index(file.add_section(index_name(name)), index);
+}
+
+}  // namespace
+
+namespace reef_moonshiners
+{
+
+void FleetColumns::clear()
+{
+  *this = FleetColumns{};
+}
+
+FleetArchive::FleetArchive(const uint32_t block_rows)
+: m_block_rows(std::max<uint32_t>(1, block_rows))
+{
+}
+
+uint32_t FleetArchive::_intern(const std::string & name)
+{
+  /* a fleet doses a handful of distinct elements, so a linear search is fastest */
+  auto & names = m_columns.names;
+  const auto iter = std::find(names.begin(), names.end(), name);
+  if (iter != names.end()) {
+    return static_cast<uint32_t>(iter - names.begin());
+  }
+  names.push_back(name);
+  return static_cast<uint32_t>(names.size() - 1);
+}
+
+void FleetArchive::add_tank(
+  const uint64_t id, const Tank & tank,
+  std::span<const ElementBase * const> elements)
+{
+  const uint32_t tank_row = static_cast<uint32_t>(m_columns.tank_id.size());
+  m_columns.tank_id.push_back(id);
+  m_columns.tank_volume.push_back(tank.get_volume());
+  for (const ElementBase * element : elements) {
+    if (nullptr == element) {
+      continue;
+    }
+    const uint32_t element_row = static_cast<uint32_t>(m_columns.element_tank.size());
+    m_columns.element_tank.push_back(tank_row);
+    m_columns.element_name.push_back(_intern(element->get_name()));
+    m_columns.element_measurement_date.push_back(to_day(element->get_last_measurement_date()));
+    m_columns.element_measured_concentration.push_back(
+      element->get_last_measured_concentration());
+    m_columns.element_concentration.push_back(element->get_element_concentration());
+    m_columns.element_target_concentration.push_back(element->get_target_concentration());
+    m_columns.element_max_adjustment.push_back(element->get_max_daily_dosage());
+    m_columns.element_dosing_unit.push_back(static_cast<uint8_t>(element->get_dosing_unit()));
+    const auto * daily = dynamic_cast<const DailyElement *>(element);
+    const auto * dropper = dynamic_cast<const DropperElement *>(element);
+    const auto * rubidium = dynamic_cast<const Rubidium *>(element);
+    const auto * correction = dynamic_cast<const CorrectionElement *>(element);
+    m_columns.element_multiplier.push_back((nullptr != daily) ? daily->get_multiplier() : 1.0);
+    m_columns.element_nano_dose.push_back((nullptr != daily) && daily->get_use_nano_dose());
+    m_columns.element_drops.push_back((nullptr != dropper) ? dropper->get_drops() : 0);
+    m_columns.element_start_date.push_back(
+      (nullptr != correction) ? to_day(correction->get_correction_start_date()) :
+      (nullptr != rubidium) ? to_day(rubidium->get_initial_dose_date()) : 0);
+    m_columns.element_frequency.push_back(
+      (nullptr != rubidium) ? static_cast<uint8_t>(rubidium->get_dosing_frequency()) : 0);
+    if (nullptr == correction) {
+      continue;
+    }
+    correction->get_dose_history().for_each(
+      [&](const std::chrono::year_month_day & date, const double dose) {
+        m_columns.dose_element.push_back(element_row);
+        m_columns.dose_date.push_back(to_day(date));
+        m_columns.dose_ml.push_back(dose);
+      });
+  }
+}
+
+FleetColumns & FleetArchive::get_columns()
+{
+  return m_columns;
+}
+
+const FleetColumns & FleetArchive::get_columns() const
+{
+  return m_columns;
+}
+
+uint32_t FleetArchive::get_block_rows() const
+{
+  return m_block_rows;
+}
+
+void FleetArchive::write_to(std::ostream & stream) const
+{
+  const FleetColumns & c = m_columns;
+  SaveFile file;
+  std::ostream & header = file.add_section("fleet");
+  binary_out(header, format_version);
+  binary_out(header, m_block_rows);
+
+  std::ostream & dictionary = file.add_section("element/name/dictionary");
+  binary_out(dictionary, static_cast<uint32_t>(c.names.size()));
+  for (const auto & name : c.names) {
+    binary_out(dictionary, name);
+  }
+
+  const uint32_t rows = m_block_rows;
+  write_column(file, "tank/id", c.tank_id, rows, Encoding::PLAIN);
+  write_column(file, "tank/volume", c.tank_volume, rows, Encoding::PLAIN);
+  write_column(file, "element/tank", c.element_tank, rows, Encoding::PLAIN);
+  write_column(file, "element/name", c.element_name, rows, Encoding::PLAIN);
+  write_column(
+    file, "element/measurement_date", c.element_measurement_date, rows, Encoding::DELTA);
+  write_column(
+    file, "element/measured_concentration", c.element_measured_concentration, rows,
+    Encoding::PLAIN);
+  write_column(file, "element/concentration", c.element_concentration, rows, Encoding::PLAIN);
+  write_column(
+    file, "element/target_concentration", c.element_target_concentration, rows,
+    Encoding::PLAIN);
+  write_column(file, "element/max_adjustment", c.element_max_adjustment, rows, Encoding::PLAIN);
+  write_column(file, "element/dosing_unit", c.element_dosing_unit, rows, Encoding::PLAIN);
+  write_column(file, "element/multiplier", c.element_multiplier, rows, Encoding::PLAIN);
+  write_column(file, "element/nano_dose", c.element_nano_dose, rows, Encoding::PLAIN);
+  write_column(file, "element/drops", c.element_drops, rows, Encoding::PLAIN);
+  write_column(file, "element/start_date", c.element_start_date, rows, Encoding::DELTA);
+  write_column(file, "element/frequency", c.element_frequency, rows, Encoding::PLAIN);
+  write_column(file, "dose/element", c.dose_element, rows, Encoding::PLAIN);
+  write_column(file, "dose/date", c.dose_date, rows, Encoding::DELTA);
+  write_column(file, "dose/ml", c.dose_ml, rows, Encoding::PLAIN);
+  file.write_to(stream);
+}
+
+bool FleetArchive::read_from(std::string_view bytes)
+{
+  m_columns.clear();
+  if (!m_file.read_from(bytes) || !m_file.contains("fleet")) {
+    return false;
+  }
+  MemoryStream header{m_file.get_section("fleet")};
+  uint32_t version = 0;
+  uint32_t block_rows = 0;
+  binary_in(header, version);
+  binary_in(header, block_rows);
+  if (!header || version > format_version || 0 == block_rows) {
+    fprintf(stderr, "Error: unsupported fleet archive (version %u)\n", version);
+    return false;
+  }
+  m_block_rows = block_rows;
+  m_version = version;
+  return true;
+}
+
+template<typename T>
+bool FleetArchive::read_column(
+  const std::string & name, std::vector<T> & values,
+  const size_t first_block, const size_t block_count) const
+{
+  values.clear();
+  ColumnIndex index;
+  if (!read_index(m_file, name, index) || sizeof(T) != index.width) {
+    return false;
+  }
+  if (Encoding::DELTA == index.encoding && !std::is_same_v<T, int32_t>) {
+    return false;
+  }
+  const std::string_view data = m_file.get_section(name);
+  const size_t blocks = index.offsets.size();
+  const size_t first = std::min(first_block, blocks);
+  const size_t last = first + std::min(block_count, blocks - first);
+  const uint64_t first_row = first * uint64_t{index.block_rows};
+  const uint64_t last_row = std::min<uint64_t>(last * uint64_t{index.block_rows}, index.rows);
+  values.resize((last_row > first_row) ? last_row - first_row : 0);
+  T * out = values.data();
+  for (size_t block = first; block < last; ++block) {
+    const uint64_t begin = index.offsets[block];
+    const uint64_t end = (block + 1 < blocks) ? index.offsets[block + 1] : data.size();
+    const size_t count = std::min<uint64_t>(
+      index.block_rows, index.rows - block * uint64_t{index.block_rows});
+    const std::string_view bytes = data.substr(begin, end - begin);
+    if constexpr (std::is_same_v<T, int32_t>) {
+      if (Encoding::DELTA == index.encoding) {
+        if (!read_delta(bytes, out, count)) {
+          values.clear();
+          return false;
+        }
+        out += count;
+        continue;
+      }
+    }
+    if (Encoding::PLAIN != index.encoding || bytes.size() != count * sizeof(T)) {
+      values.clear();
+      return false;
+    }
+    read_plain(bytes.data(), out, count);
+    out += count;
+  }
+  return true;
+}
+
+template bool FleetArchive::read_column(
+  const std::string &, std::vector<double> &, const size_t, const size_t) const;
+template bool FleetArchive::read_column(
+  const std::string &, std::vector<uint64_t> &, const size_t, const size_t) const;
+template bool FleetArchive::read_column(
+  const std::string &, std::vector<uint32_t> &, const size_t, const size_t) const;
+template bool FleetArchive::read_column(
+  const std::string &, std::vector<int32_t> &, const size_t, const size_t) const;
+template bool FleetArchive::read_column(
+  const std::string &, std::vector<uint8_t> &, const size_t, const size_t) const;
+
+bool FleetArchive::get_block_stats(
+  const std::string & name,
+  std::vector<BlockStats> & stats) const
+{
+  ColumnIndex index;
+  if (!read_index(m_file, name, index)) {
+    stats.clear();
+    return false;
+  }
+  stats = std::move(index.stats);
+  return true;
+}
+
+bool FleetArchive::load()
+{
+  FleetColumns & c = m_columns;
+  c.clear();
+  MemoryStream dictionary{m_file.get_section("element/name/dictionary")};
+  uint32_t name_count = 0;
+  binary_in(dictionary, name_count);
+  for (uint32_t x = 0; x < name_count && dictionary; ++x) {
+    binary_in(dictionary, c.names.emplace_back());
+  }
+  bool loaded = static_cast<bool>(dictionary);
+  loaded = loaded && read_column("tank/id", c.tank_id);
+  loaded = loaded && read_column("tank/volume", c.tank_volume);
+  loaded = loaded && read_column("element/tank", c.element_tank);
+  loaded = loaded && read_column("element/name", c.element_name);
+  loaded = loaded && read_column("element/measurement_date", c.element_measurement_date);
+  loaded = loaded && read_column(
+    "element/measured_concentration", c.element_measured_concentration);
+  loaded = loaded && read_column("element/concentration", c.element_concentration);
+  loaded = loaded && read_column(
+    "element/target_concentration", c.element_target_concentration);
+  loaded = loaded && read_column("element/max_adjustment", c.element_max_adjustment);
+  loaded = loaded && read_column("element/dosing_unit", c.element_dosing_unit);
+  /* version 1 archives have no settings columns */
+  const bool settings = m_version >= 2;
+  if (settings) {
+    loaded = loaded && read_column("element/multiplier", c.element_multiplier);
+    loaded = loaded && read_column("element/nano_dose", c.element_nano_dose);
+    loaded = loaded && read_column("element/drops", c.element_drops);
+    loaded = loaded && read_column("element/start_date", c.element_start_date);
+    loaded = loaded && read_column("element/frequency", c.element_frequency);
+  }
+  loaded = loaded && read_column("dose/element", c.dose_element);
+  loaded = loaded && read_column("dose/date", c.dose_date);
+  loaded = loaded && read_column("dose/ml", c.dose_ml);
+
+  /* apply_to relies on the rows being consistent, so check them once here */
+  const size_t tanks = c.tank_id.size();
+  const size_t elements = c.element_tank.size();
+  const size_t doses = c.dose_element.size();
+  loaded = loaded && c.tank_volume.size() == tanks;
+  loaded = loaded && c.element_name.size() == elements &&
+    c.element_measurement_date.size() == elements &&
+    c.element_measured_concentration.size() == elements &&
+    c.element_concentration.size() == elements &&
+    c.element_target_concentration.size() == elements &&
+    c.element_max_adjustment.size() == elements &&
+    c.element_dosing_unit.size() == elements;
+  loaded = loaded && (!settings || (c.element_multiplier.size() == elements &&
+    c.element_nano_dose.size() == elements &&
+    c.element_drops.size() == elements &&
+    c.element_start_date.size() == elements &&
+    c.element_frequency.size() == elements));
+  loaded = loaded && std::all_of(
+    c.element_frequency.begin(), c.element_frequency.end(),
+    [](const uint8_t frequency) {
+      return frequency <= static_cast<uint8_t>(RubidiumSelection::INITIAL);
+    });
+  loaded = loaded && c.dose_date.size() == doses && c.dose_ml.size() == doses;
+  loaded = loaded && std::is_sorted(c.element_tank.begin(), c.element_tank.end()) &&
+    (0 == elements || c.element_tank.back() < tanks);
+  loaded = loaded && std::is_sorted(c.dose_element.begin(), c.dose_element.end()) &&
+    (0 == doses || c.dose_element.back() < elements);
+  loaded = loaded && std::all_of(
+    c.element_name.begin(), c.element_name.end(),
+    [&](const uint32_t name) {return name < c.names.size();});
+  if (!loaded) {
+    fprintf(stderr, "Error: malformed fleet archive\n");
+    c.clear();
+  }
+  return loaded;
+}
+
+void FleetArchive::_apply_settings(const size_t row, ElementBase & element) const
+{
+  const FleetColumns & c = m_columns;
+  if (auto * daily = dynamic_cast<DailyElement *>(&element)) {
+    daily->set_multiplier(c.element_multiplier[row]);
+    daily->set_use_nano_dose(0 != c.element_nano_dose[row]);
+  }
+  if (auto * dropper = dynamic_cast<DropperElement *>(&element)) {
+    dropper->set_drops(static_cast<size_t>(c.element_drops[row]));
+  }
+  if (auto * rubidium = dynamic_cast<Rubidium *>(&element)) {
+    rubidium->set_dosing_frequency(static_cast<RubidiumSelection>(c.element_frequency[row]));
+    rubidium->set_initial_dose_date(from_day(c.element_start_date[row]));
+  }
+  if (auto * correction = dynamic_cast<CorrectionElement *>(&element)) {
+    correction->set_correction_start_date(from_day(c.element_start_date[row]));
+  }
+}
+
+bool FleetArchive::apply_to(
+  const size_t tank_row, Tank & tank,
+  std::span<ElementBase * const> elements) const
+{
+  const FleetColumns & c = m_columns;
+  if (tank_row >= c.tank_id.size()) {
+    return false;
+  }
+  tank.set_volume(c.tank_volume[tank_row]);
+  const auto [first, last] = std::equal_range(
+    c.element_tank.begin(), c.element_tank.end(), static_cast<uint32_t>(tank_row));
+  for (auto iter = first; iter != last; ++iter) {
+    const uint32_t row = static_cast<uint32_t>(iter - c.element_tank.begin());
+    const std::string & name = c.names[c.element_name[row]];
+    const auto match = std::find_if(
+      elements.begin(), elements.end(), [&](const ElementBase * element) {
+        return nullptr != element && element->get_name() == name;
+      });
+    if (match == elements.end()) {
+      continue;
+    }
+    ElementBase * element = *match;
+    element->set_concentration(
+      c.element_measured_concentration[row], from_day(c.element_measurement_date[row]));
+    element->set_dosing_unit(static_cast<DosingUnit>(c.element_dosing_unit[row]));
+    auto * correction = dynamic_cast<CorrectionElement *>(element);
+    if (row < c.element_multiplier.size()) {
+      _apply_settings(row, *element);
+    }
+    /* replace the history, so importing twice does not double it */
+    if (nullptr != correction) {
+      correction->clear_dose_history();
+    }
+    const auto [dose_first, dose_last] = std::equal_range(
+      c.dose_element.begin(), c.dose_element.end(), row);
+    for (auto dose = dose_first; dose != dose_last; ++dose) {
+      const size_t x = static_cast<size_t>(dose - c.dose_element.begin());
+      element->apply_dose(c.dose_ml[x], from_day(c.dose_date[x]));
+    }
+  }
+  return true;
+}
+
+}  // namespace reef_moonshiners
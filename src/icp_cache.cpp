@@ -0,0 +1,250 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/icp_cache.hpp>
+#include <reef_moonshiners/binary_io.hpp>
+#include <reef_moonshiners/mapped_file.hpp>
+#include <reef_moonshiners/save_file.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+/// version of the record format
+constexpr uint32_t record_version = 1;
+constexpr std::string_view record_extension = ".dat";
+constexpr char hex_digits[] = "0123456789abcdef";
+/// longest escaped analysis ID, to stay clear of file name limits
+constexpr size_t max_escaped_id_length = 200;
+
+bool is_plain(const char c)
+{
+  return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9') ||
+         '-' == c || '_' == c;
+}
+
+/// escape everything but letters, digits, '-' and '_' as "%xx"
+std::string escape_id(const std::string & analysis_id)
+{
+  std::string escaped;
+  escaped.reserve(analysis_id.size());
+  for (const char c : analysis_id) {
+    if (is_plain(c)) {
+      escaped += c;
+    } else {
+      const auto byte = static_cast<uint8_t>(c);
+      escaped += '%';
+      escaped += hex_digits[byte >> 4];
+      escaped += hex_digits[byte & 0xf];
+    }
+  }
+  return escaped;
+}
+
+int hex_value(const char c)
+{
+  if ('0' <= c && c <= '9') {
+    return c - '0';
+  } else if ('a' <= c && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+bool unescape_id(const std::string & escaped, std::string & analysis_id)
+{
+  analysis_id.clear();
+  for (size_t x = 0; x < escaped.size(); ++x) {
+    if (is_plain(escaped[x])) {
+      analysis_id += escaped[x];
+      continue;
+    }
+    if ('%' != escaped[x] || x + 2 >= escaped.size() ||
+      hex_value(escaped[x + 1]) < 0 || hex_value(escaped[x + 2]) < 0)
+    {
+      return false;
+    }
+    analysis_id += static_cast<char>(hex_value(escaped[x + 1]) * 16 + hex_value(escaped[x + 2]));
+    x += 2;
+  }
+  return !analysis_id.empty();
+}
+
+}  // namespace
+
+namespace reef_moonshiners
+{
+
+IcpCache::IcpCache(std::filesystem::path directory)
+: m_directory(std::move(directory))
+{
+}
+
+bool IcpCache::lookup(const std::string & analysis_id, IcpCacheEntry & entry) const
+{
+  std::lock_guard<std::mutex> lock{m_mutex};
+  return this->_read_record(analysis_id, entry);
+}
+
+bool IcpCache::load_page(const IcpCacheEntry & entry, std::string & page) const
+{
+  std::lock_guard<std::mutex> lock{m_mutex};
+  MappedFile file;
+  if (!file.open(this->_page_path(entry.page_hash))) {
+    return false;
+  }
+  const std::string_view bytes = file.get_data();
+  /* a page that does not match was damaged, or belongs to a colliding hash */
+  if (bytes.size() != entry.page_size || hash_page(bytes) != entry.page_hash) {
+    return false;
+  }
+  page.assign(bytes);
+  return true;
+}
+
+bool IcpCache::store(const std::string & analysis_id, std::string_view page, IcpCacheEntry entry)
+{
+  if (analysis_id.empty() || escape_id(analysis_id).size() > max_escaped_id_length ||
+    entry.etag.size() > max_binary_string_length ||
+    entry.last_modified.size() > max_binary_string_length)
+  {
+    return false;
+  }
+  entry.page_hash = hash_page(page);
+  entry.page_size = page.size();
+  std::lock_guard<std::mutex> lock{m_mutex};
+  const fs::path page_path = this->_page_path(entry.page_hash);
+  std::error_code error;
+  /* pages are named by their contents, so an existing page of the same size is this page */
+  if (!fs::exists(page_path, error) || fs::file_size(page_path, error) != page.size()) {
+    if (!replace_file(page_path, page)) {
+      return false;
+    }
+  }
+  return this->_write_record(analysis_id, entry);
+}
+
+bool IcpCache::mark_validated(
+  const std::string & analysis_id,
+  const std::chrono::system_clock::time_point validated)
+{
+  std::lock_guard<std::mutex> lock{m_mutex};
+  IcpCacheEntry entry;
+  if (!this->_read_record(analysis_id, entry)) {
+    return false;
+  }
+  entry.validated = validated;
+  return this->_write_record(analysis_id, entry);
+}
+
+std::vector<std::string> IcpCache::get_analysis_ids() const
+{
+  std::lock_guard<std::mutex> lock{m_mutex};
+  std::vector<std::string> ids;
+  std::error_code error;
+  for (const auto & file : fs::directory_iterator{m_directory / "analyses", error}) {
+    const fs::path & path = file.path();
+    std::string analysis_id;
+    if (path.extension() == record_extension &&
+      unescape_id(path.stem().string(), analysis_id))
+    {
+      ids.emplace_back(std::move(analysis_id));
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+uint64_t IcpCache::hash_page(std::string_view page)
+{
+  uint64_t hash = 14695981039346656037ull;
+  for (const char c : page) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+std::filesystem::path IcpCache::_record_path(const std::string & analysis_id) const
+{
+  fs::path path = m_directory / "analyses" / escape_id(analysis_id);
+  path += record_extension;
+  return path;
+}
+
+std::filesystem::path IcpCache::_page_path(const uint64_t page_hash) const
+{
+  std::string name(16, '0');
+  for (size_t x = 0; x < name.size(); ++x) {
+    name[name.size() - 1 - x] = hex_digits[(page_hash >> (4 * x)) & 0xf];
+  }
+  return m_directory / "pages" / (name + ".html");
+}
+
+bool IcpCache::_read_record(const std::string & analysis_id, IcpCacheEntry & entry) const
+{
+  MappedFile file;
+  SaveFile record;
+  if (analysis_id.empty() || !file.open(this->_record_path(analysis_id)) ||
+    !record.read_from(file.get_data()) || !record.contains("analysis"))
+  {
+    return false;
+  }
+  MemoryStream analysis{record.get_section("analysis")};
+  uint32_t version = 0;
+  std::string stored_id;
+  int64_t validated = 0;
+  binary_in(analysis, version);
+  binary_in(analysis, stored_id);
+  binary_in(analysis, entry.etag);
+  binary_in(analysis, entry.last_modified);
+  binary_in(analysis, validated);
+  binary_in(analysis, entry.page_hash);
+  binary_in(analysis, entry.page_size);
+  if (!analysis || record_version != version || stored_id != analysis_id) {
+    return false;
+  }
+  entry.validated = std::chrono::system_clock::time_point{std::chrono::seconds{validated}};
+  MemoryStream results{record.get_section("results")};
+  entry.values.clear();
+  binary_in(results, entry.values);
+  return !!results;
+}
+
+bool IcpCache::_write_record(const std::string & analysis_id, const IcpCacheEntry & entry)
+{
+  SaveFile record;
+  std::ostream & analysis = record.add_section("analysis");
+  binary_out(analysis, record_version);
+  binary_out(analysis, analysis_id);
+  binary_out(analysis, entry.etag);
+  binary_out(analysis, entry.last_modified);
+  binary_out(
+    analysis, static_cast<int64_t>(
+      std::chrono::duration_cast<std::chrono::seconds>(
+        entry.validated.time_since_epoch()).count()));
+  binary_out(analysis, entry.page_hash);
+  binary_out(analysis, entry.page_size);
+  binary_out(record.add_section("results"), entry.values);
+  std::ostringstream bytes;
+  record.write_to(bytes);
+  return replace_file(this->_record_path(analysis_id), bytes.str());
+}
+
+}  // namespace reef_moonshiners
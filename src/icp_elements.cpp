@@ -0,0 +1,45 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/icp_elements.hpp>
+
+namespace reef_moonshiners
+{
+
+void resolve_icp_results(
+  const IcpConcentrations & values, IcpResults & results,
+  std::vector<std::string> & unknown)
+{
+  results.clear();
+  unknown.clear();
+  for (const auto &[name, value] : values) {
+    if (!results.set(find_icp_element(name), value)) {
+      unknown.push_back(name);
+    }
+  }
+}
+
+void get_icp_concentrations(const IcpResults & results, IcpConcentrations & values)
+{
+  values.clear();
+  values.reserve(results.size());
+  for (size_t x = 0; x < icp_element_count; ++x) {
+    const auto element = static_cast<IcpElement>(x);
+    if (results.contains(element)) {
+      values.emplace(icp_element_names[x], results.get(element));
+    }
+  }
+}
+
+}  // namespace reef_moonshiners
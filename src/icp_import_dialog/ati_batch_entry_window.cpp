@@ -0,0 +1,100 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <reef_moonshiners/ui/icp_import_dialog/ati_batch_entry_window.hpp>
+
+#include <QRegularExpression>
+
+namespace reef_moonshiners::ui::icp_import_dialog
+{
+
+ATIBatchEntryWindow::ATIBatchEntryWindow(QWidget * parent)
+: QWidget(parent)
+{
+  m_p_entry_label = new QLabel(
+    tr("One analysis per line: the analysis ID, then the collection date (yyyy-MM-dd)."));
+  m_p_entry_label->setWordWrap(true);
+  m_p_entry = new QPlainTextEdit();
+  m_p_entry->setPlaceholderText(tr("12345 2022-11-12"));
+  m_p_error_label = new QLabel();
+  m_p_error_label->setWordWrap(true);
+  m_p_error_label->setVisible(false);
+  m_p_progress_bar = new QProgressBar();
+  m_p_progress_bar->setRange(0, 0);
+  m_p_progress_bar->setVisible(false);
+  m_p_import_button = new QPushButton(tr("&Import"));
+  m_p_back_button = new QPushButton(tr("&Back"));
+
+  m_p_button_layout = new QHBoxLayout();
+  m_p_button_layout->addWidget(m_p_back_button);
+  m_p_button_layout->addWidget(m_p_import_button);
+
+  m_p_main_layout = new QVBoxLayout(this);
+  m_p_main_layout->addWidget(m_p_entry_label);
+  m_p_main_layout->addWidget(m_p_entry);
+  m_p_main_layout->addWidget(m_p_error_label);
+  m_p_main_layout->addWidget(m_p_progress_bar);
+  m_p_main_layout->addLayout(m_p_button_layout);
+
+  QObject::connect(
+    m_p_import_button, &QPushButton::clicked,
+    [this]() {
+      QStringList analysis_ids;
+      QList<QDate> collection_dates;
+      const QStringList lines = m_p_entry->toPlainText().split('\n');
+      for (int x = 0; x < lines.size(); ++x) {
+        const QStringList fields =
+        lines[x].split(QRegularExpression{"[\\s,]+"}, Qt::SkipEmptyParts);
+        if (fields.isEmpty()) {
+          continue;
+        }
+        const QDate date = (2 == fields.size()) ?
+        QDate::fromString(fields[1], Qt::ISODate) : QDate{};
+        if (!date.isValid()) {
+          this->set_error_message(
+            tr("Line %1 needs an analysis ID and a date such as 2022-11-12.").arg(x + 1));
+          return;
+        }
+        analysis_ids.push_back(fields[0]);
+        collection_dates.push_back(date);
+      }
+      if (analysis_ids.isEmpty()) {
+        this->set_error_message(tr("Enter at least one analysis."));
+        return;
+      }
+      this->set_error_message(QString{});
+      Q_EMIT (import_button_pressed(analysis_ids, collection_dates));
+    });
+}
+
+QPushButton * ATIBatchEntryWindow::get_back_button() const
+{
+  return m_p_back_button;
+}
+
+void ATIBatchEntryWindow::set_error_message(const QString & message)
+{
+  m_p_error_label->setText(message);
+  m_p_error_label->setVisible(!message.isEmpty());
+}
+
+void ATIBatchEntryWindow::set_importing(bool importing)
+{
+  m_p_import_button->setDisabled(importing);
+  m_p_entry->setReadOnly(importing);
+  m_p_progress_bar->setVisible(importing);
+}
+
+}  // namespace reef_moonshiners::ui::icp_import_dialog
@@ -0,0 +1,282 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <reef_moonshiners/ui/icp_import_dialog/ati_batch_import.hpp>
+#include <reef_moonshiners/ui/icp_import_dialog/ati_import.hpp>
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QMetaObject>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QThreadPool>
+
+#include <reef_moonshiners/icp_elements.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace reef_moonshiners::ui::icp_import_dialog
+{
+
+namespace
+{
+
+/// what the fetcher needs of a reply, taken on the manager's thread
+struct Reply
+{
+  /// HTTP status code, 0 if the transfer failed
+  int status = 0;
+  std::string body;
+  std::string error;
+  std::string etag;
+  std::string last_modified;
+};
+
+}  // namespace
+
+ATIBatchImport::ATIBatchImport(
+  QNetworkAccessManager * manager, std::vector<Entry> entries,
+  QObject * parent)
+: QObject(parent),
+  m_p_manager(manager),
+  m_entries(std::move(entries))
+{
+}
+
+ATIBatchImport::~ATIBatchImport()
+{
+  this->cancel();
+}
+
+void ATIBatchImport::set_cache(std::shared_ptr<IcpCache> cache)
+{
+  m_p_cache = std::move(cache);
+}
+
+void ATIBatchImport::start()
+{
+  if (m_running) {
+    return;
+  }
+  m_running = true;
+  /* a fresh flag, so fetches left over from a cancelled run stay cancelled */
+  m_p_cancelled = std::make_shared<std::atomic<bool>>(false);
+  /* oldest first, so applying the results in order leaves the latest sample */
+  std::stable_sort(
+    m_entries.begin(), m_entries.end(), [](const Entry & lhs, const Entry & rhs) {
+      return lhs.collection_date < rhs.collection_date;
+    });
+  std::vector<BatchImportEntry> entries;
+  entries.reserve(m_entries.size());
+  for (const Entry & entry : m_entries) {
+    int year, month, day;
+    entry.collection_date.getDate(&year, &month, &day);
+    entries.push_back(
+      {entry.analysis_id.toStdString(), {},
+        std::chrono::year_month_day{
+          std::chrono::year(year), std::chrono::month(month), std::chrono::day(day)}});
+  }
+  BatchImportOptions options;
+  options.parallelism = parallelism;
+  auto fresh = std::make_shared<FreshPages>();
+  auto importer = std::make_shared<BatchImporter>(
+    _make_fetcher(m_p_manager, m_p_cache, fresh, m_p_cancelled),
+    [](const std::string & page, IcpResults & results, std::string & error) {
+      QString reason;
+      if (!ATIImport::parse(QByteArray::fromStdString(page), results, reason)) {
+        error = reason.toStdString();
+        return false;
+      }
+      return true;
+    },
+    options);
+  /* the fetches block on replies from this thread, so wait for them elsewhere */
+  QPointer<ATIBatchImport> guard{this};
+  QThreadPool::globalInstance()->start(
+    [importer = std::move(importer), entries = std::move(entries), cache = m_p_cache,
+    fresh = std::move(fresh), cancelled = m_p_cancelled, guard = std::move(guard)]() mutable {
+      auto values = std::make_shared<std::vector<IcpResults>>();
+      auto results = std::make_shared<std::vector<BatchImportResult>>(
+        importer->fetch(entries, *values));
+      /* pages are cached only once they parse, as a single import does */
+      for (size_t x = 0; cache && x < entries.size(); ++x) {
+        std::lock_guard<std::mutex> lock{fresh->mutex};
+        const auto page = fresh->pages.find(entries[x].analysis_id);
+        if (!(*results)[x].imported || page == fresh->pages.end()) {
+          continue;
+        }
+        auto & [html, entry] = page->second;
+        get_icp_concentrations((*values)[x], entry.values);
+        cache->store(page->first, html, std::move(entry));
+        fresh->pages.erase(page);
+      }
+      if (cancelled->load()) {
+        return;
+      }
+      QMetaObject::invokeMethod(
+        QCoreApplication::instance(),
+        [results = std::move(results), values = std::move(values), guard = std::move(guard),
+        cancelled = std::move(cancelled)]() {
+          /* checked again, as the run may be cancelled while this is queued */
+          if (guard && !cancelled->load()) {
+            guard->_finish(*results, *values);
+          }
+        },
+        Qt::QueuedConnection);
+    });
+}
+
+void ATIBatchImport::cancel()
+{
+  if (!m_running) {
+    return;
+  }
+  m_running = false;
+  m_p_cancelled->store(true);
+}
+
+bool ATIBatchImport::is_running() const
+{
+  return m_running;
+}
+
+BatchImporter::Fetcher ATIBatchImport::_make_fetcher(
+  QNetworkAccessManager * manager,
+  std::shared_ptr<IcpCache> cache,
+  std::shared_ptr<FreshPages> fresh,
+  std::shared_ptr<std::atomic<bool>> cancelled)
+{
+  return [manager = QPointer<QNetworkAccessManager>{manager}, cache = std::move(cache),
+           fresh = std::move(fresh), cancelled = std::move(cancelled)](
+    const std::string & analysis_id) {
+           FetchResult result;
+           if (cancelled->load()) {
+             result.error = "cancelled";
+             return result;
+           }
+           IcpCacheEntry cached_entry;
+           std::string cached_page;
+           const bool cached = cache && cache->lookup(analysis_id, cached_entry) &&
+           cache->load_page(cached_entry, cached_page);
+           const auto now = std::chrono::system_clock::now();
+           if (cached && now - cached_entry.validated < ATIImport::cache_max_age) {
+             return BatchImporter::make_fetch_result(200, std::move(cached_page), {});
+           }
+           QNetworkRequest request{ATIImport::make_url(QString::fromStdString(analysis_id))};
+           request.setTransferTimeout(ATIImport::transfer_timeout_ms);
+           if (cached && !cached_entry.etag.empty()) {
+             request.setRawHeader("If-None-Match", QByteArray::fromStdString(cached_entry.etag));
+           }
+           if (cached && !cached_entry.last_modified.empty()) {
+             request.setRawHeader(
+               "If-Modified-Since", QByteArray::fromStdString(cached_entry.last_modified));
+           }
+           /* the reply is delivered on the manager's thread, which fulfills the promise */
+           auto promise = std::make_shared<std::promise<Reply>>();
+           std::future<Reply> future = promise->get_future();
+           QMetaObject::invokeMethod(
+             QCoreApplication::instance(),
+             [manager, promise = std::move(promise), request = std::move(request)]() mutable {
+               if (!manager) {
+                 return;  /* the promise is dropped, which fails the fetch */
+               }
+               QNetworkReply * reply = manager->get(request);
+               QObject::connect(
+                 reply, &QNetworkReply::finished, reply,
+                 [reply, promise = std::move(promise)]() {
+                   reply->deleteLater();
+                   Reply taken;
+                   taken.status =
+                   reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+                   /* a transfer cut short is no success, whatever its status */
+                   if (QNetworkReply::NetworkError::NoError != reply->error() &&
+                   taken.status < 300)
+                   {
+                     taken.status = 0;
+                   }
+                   taken.body = reply->readAll().toStdString();
+                   taken.error = reply->errorString().toStdString();
+                   taken.etag = reply->rawHeader("ETag").toStdString();
+                   taken.last_modified = reply->rawHeader("Last-Modified").toStdString();
+                   promise->set_value(std::move(taken));
+                 });
+             },
+             Qt::QueuedConnection);
+           Reply reply;
+           /* a stalled transfer times out on its own; this only guards a stopped event loop */
+           const auto wait = std::chrono::milliseconds(3 * ATIImport::transfer_timeout_ms);
+           if (std::future_status::ready != future.wait_for(wait)) {
+             reply.error = "timed out waiting for the reply";
+           } else {
+             try {
+               reply = future.get();
+             } catch (const std::future_error &) {
+               reply.error = "the network access manager is gone";
+             }
+           }
+           if (cached && 304 == reply.status) {
+             /* not modified */
+             cache->mark_validated(analysis_id, std::chrono::system_clock::now());
+             return BatchImporter::make_fetch_result(200, std::move(cached_page), {});
+           }
+           result = BatchImporter::make_fetch_result(
+             reply.status, std::move(reply.body), std::move(reply.error));
+           if (cached && FetchStatus::OK != result.status) {
+             /* offline, or the lab is down: the cached results still stand */
+             fprintf(
+               stderr, "Warning: using the cached analysis of '%s': %s\n",
+               analysis_id.c_str(), result.error.c_str());
+             return BatchImporter::make_fetch_result(200, std::move(cached_page), {});
+           }
+           if (cache && FetchStatus::OK == result.status) {
+             IcpCacheEntry entry;
+             entry.etag = std::move(reply.etag);
+             entry.last_modified = std::move(reply.last_modified);
+             entry.validated = std::chrono::system_clock::now();
+             std::lock_guard<std::mutex> lock{fresh->mutex};
+             fresh->pages[analysis_id] = {result.page, std::move(entry)};
+           }
+           return result;
+         };
+}
+
+void ATIBatchImport::_finish(
+  const std::vector<BatchImportResult> & results,
+  const std::vector<IcpResults> & values)
+{
+  if (!m_running || m_p_cancelled->load()) {
+    return;
+  }
+  m_running = false;
+  int imported = 0;
+  for (size_t x = 0; x < m_entries.size(); ++x) {
+    if (results[x].imported) {
+      ++imported;
+      Q_EMIT succeeded(m_entries[x].collection_date, values[x]);
+    } else {
+      Q_EMIT failed(m_entries[x].analysis_id, QString::fromStdString(results[x].error));
+    }
+  }
+  Q_EMIT finished(imported, static_cast<int>(m_entries.size()));
+}
+
+}  // namespace reef_moonshiners::ui::icp_import_dialog
@@ -23,6 +23,7 @@ ATIEntryWindow::ATIEntryWindow(QWidget * parent)
   m_p_analysis_id_label = new QLabel(tr("Analysis ID:"));
   m_p_next_button = new QPushButton(tr("&Next"));
   m_p_back_button = new QPushButton(tr("&Back"));
+  m_p_batch_button = new QPushButton(tr("&Several..."));
   m_p_ati_id_entry = new QLineEdit();
 
   m_p_ati_entry_layout = new QHBoxLayout();
@@ -31,15 +32,19 @@ ATIEntryWindow::ATIEntryWindow(QWidget * parent)
 
   m_p_button_layout = new QHBoxLayout();
   m_p_button_layout->addWidget(m_p_back_button);
+  m_p_button_layout->addWidget(m_p_batch_button);
   m_p_button_layout->addWidget(m_p_next_button);
 
   m_p_calendar_widget = new QCalendarWidget();
   m_p_collection_label = new QLabel(tr("Select Collection Date:"));
+  m_p_progress_bar = new QProgressBar();
+  m_p_progress_bar->setVisible(false);
 
   m_p_main_layout = new QVBoxLayout(this);
   m_p_main_layout->addLayout(m_p_ati_entry_layout);
   m_p_main_layout->addWidget(m_p_collection_label);
   m_p_main_layout->addWidget(m_p_calendar_widget);
+  m_p_main_layout->addWidget(m_p_progress_bar);
   m_p_main_layout->addLayout(m_p_button_layout);
 
   QObject::connect(
@@ -54,6 +59,11 @@ QPushButton * ATIEntryWindow::get_back_button() const
   return m_p_back_button;
 }
 
+QPushButton * ATIEntryWindow::get_batch_button() const
+{
+  return m_p_batch_button;
+}
+
 void ATIEntryWindow::show_input_error_message()
 {
   if (!m_error_message_showing) {
@@ -74,4 +84,23 @@ void ATIEntryWindow::hide_input_error_message()
   }
 }
 
+void ATIEntryWindow::set_importing(bool importing)
+{
+  m_p_next_button->setDisabled(importing);
+  m_p_ati_id_entry->setDisabled(importing);
+  /* busy indicator until the size of the page is known */
+  m_p_progress_bar->setRange(0, 0);
+  m_p_progress_bar->setVisible(importing);
+}
+
+void ATIEntryWindow::set_progress(qint64 received, qint64 total)
+{
+  if (total <= 0) {
+    m_p_progress_bar->setRange(0, 0);
+    return;
+  }
+  m_p_progress_bar->setRange(0, 100);
+  m_p_progress_bar->setValue(static_cast<int>((100 * received) / total));
+}
+
 }  // namespace reef_moonshiners::ui::icp_import_dialog
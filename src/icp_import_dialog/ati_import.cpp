@@ -0,0 +1,222 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/ui/icp_import_dialog/ati_import.hpp>
+
+#include <QCoreApplication>
+#include <QMetaObject>
+#include <QNetworkRequest>
+#include <QThreadPool>
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace reef_moonshiners::ui::icp_import_dialog
+{
+
+ATIImport::ATIImport(
+  QNetworkAccessManager * manager, const QString & analysis_id,
+  const QDate & collection_date, QObject * parent)
+: QObject(parent),
+  m_p_manager(manager),
+  m_analysis_id(analysis_id),
+  m_collection_date(collection_date)
+{
+}
+
+ATIImport::~ATIImport()
+{
+  this->cancel();
+}
+
+void ATIImport::set_cache(std::shared_ptr<IcpCache> cache)
+{
+  m_p_cache = std::move(cache);
+}
+
+void ATIImport::start()
+{
+  if (m_running) {
+    return;
+  }
+  m_running = true;
+  /* a fresh flag, so a parse left over from a cancelled run stays cancelled */
+  m_p_cancelled = std::make_shared<std::atomic<bool>>(false);
+  m_cached = m_p_cache && m_p_cache->lookup(m_analysis_id.toStdString(), m_cache_entry);
+  if (m_cached && std::chrono::system_clock::now() - m_cache_entry.validated < cache_max_age) {
+    this->_finish_from_cache();
+    return;
+  }
+  QNetworkRequest request{make_url(m_analysis_id)};
+  request.setTransferTimeout(transfer_timeout_ms);
+  if (m_cached && !m_cache_entry.etag.empty()) {
+    request.setRawHeader("If-None-Match", QByteArray::fromStdString(m_cache_entry.etag));
+  }
+  if (m_cached && !m_cache_entry.last_modified.empty()) {
+    request.setRawHeader(
+      "If-Modified-Since", QByteArray::fromStdString(m_cache_entry.last_modified));
+  }
+  m_p_reply = m_p_manager->get(request);
+  QObject::connect(m_p_reply, &QNetworkReply::downloadProgress, this, &ATIImport::progress);
+  QObject::connect(
+    m_p_reply, &QNetworkReply::finished, this, &ATIImport::_handle_reply_finished);
+}
+
+void ATIImport::cancel()
+{
+  if (!m_running) {
+    return;
+  }
+  m_running = false;
+  m_p_cancelled->store(true);
+  if (m_p_reply) {
+    m_p_reply->disconnect(this);
+    m_p_reply->abort();
+    m_p_reply->deleteLater();
+  }
+}
+
+bool ATIImport::is_running() const
+{
+  return m_running;
+}
+
+const QString & ATIImport::get_analysis_id() const
+{
+  return m_analysis_id;
+}
+
+const QDate & ATIImport::get_collection_date() const
+{
+  return m_collection_date;
+}
+
+QUrl ATIImport::make_url(const QString & analysis_id)
+{
+  return QUrl{QString{"https://lab.atiaquaristik.com/publicAnalysis/"} + analysis_id};
+}
+
+void ATIImport::_handle_reply_finished()
+{
+  QNetworkReply * reply = m_p_reply;
+  m_p_reply = nullptr;
+  if (nullptr == reply) {
+    return;
+  }
+  reply->deleteLater();
+  if (QNetworkReply::NetworkError::NoError != reply->error()) {
+    if (m_cached) {
+      /* offline, or the lab is down: the cached results still stand */
+      fprintf(
+        stderr, "Warning: using the cached analysis: %s\n",
+        reply->errorString().toStdString().c_str());
+      this->_finish(this->_get_cached_result());
+      return;
+    }
+    /* error in transfer */
+    this->_finish({false, {}, reply->errorString()});
+    return;
+  }
+  const auto now = std::chrono::system_clock::now();
+  if (m_cached && 304 == reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt()) {
+    /* not modified */
+    m_p_cache->mark_validated(m_analysis_id.toStdString(), now);
+    this->_finish(this->_get_cached_result());
+    return;
+  }
+  IcpCacheEntry entry;
+  entry.etag = reply->rawHeader("ETag").toStdString();
+  entry.last_modified = reply->rawHeader("Last-Modified").toStdString();
+  entry.validated = now;
+  /* parse off of the UI thread; the import may be gone by the time it is done */
+  QPointer<ATIImport> guard{this};
+  QThreadPool::globalInstance()->start(
+    [html = reply->readAll(), cancelled = m_p_cancelled, guard = std::move(guard),
+    cache = m_p_cache, analysis_id = m_analysis_id.toStdString(),
+    entry = std::move(entry)]() mutable {
+      auto result = std::make_shared<ParseResult>();
+      result->parsed = parse(html, result->results, result->error);
+      if (result->parsed && cache) {
+        get_icp_concentrations(result->results, entry.values);
+        cache->store(
+          analysis_id, std::string_view{html.constData(), static_cast<size_t>(html.size())},
+          std::move(entry));
+      }
+      if (cancelled->load()) {
+        return;
+      }
+      QMetaObject::invokeMethod(
+        QCoreApplication::instance(),
+        [result = std::move(result), guard = std::move(guard),
+        cancelled = std::move(cancelled)]() {
+          /* checked again, as the run may be cancelled while this is queued */
+          if (guard && !cancelled->load()) {
+            guard->_finish(*result);
+          }
+        },
+        Qt::QueuedConnection);
+    });
+}
+
+void ATIImport::_finish(const ParseResult & result)
+{
+  if (!m_running || m_p_cancelled->load()) {
+    return;
+  }
+  m_running = false;
+  if (result.parsed) {
+    Q_EMIT succeeded(m_collection_date, result.results);
+  } else {
+    Q_EMIT failed(result.error);
+  }
+}
+
+void ATIImport::_finish_from_cache()
+{
+  QMetaObject::invokeMethod(
+    this, [this]() {this->_finish(this->_get_cached_result());}, Qt::QueuedConnection);
+}
+
+ATIImport::ParseResult ATIImport::_get_cached_result() const
+{
+  ParseResult result;
+  std::vector<std::string> unknown;
+  resolve_icp_results(m_cache_entry.values, result.results, unknown);
+  result.parsed = true;
+  return result;
+}
+
+bool ATIImport::parse(const QByteArray & source, IcpResults & results, QString & error)
+{
+  AtiPage page;
+  std::string reason;
+  const std::string_view html{source.constData(), static_cast<size_t>(source.size())};
+  if (!page.scan(html, reason)) {
+    error = QString::fromStdString(reason);
+    return false;
+  }
+  std::vector<std::string_view> unknown;
+  page.get_results(results, unknown);
+  for (const auto & name : unknown) {
+    fprintf(
+      stderr, "Warning: ignoring unknown element '%.*s' in the analysis\n",
+      static_cast<int>(name.size()), name.data());
+  }
+  return true;
+}
+
+}  // namespace reef_moonshiners::ui::icp_import_dialog
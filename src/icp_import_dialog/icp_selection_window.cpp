@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <reef_moonshiners/ui/icp_import_dialog/icp_selection_window.hpp>
+#include <reef_moonshiners/icp_provider.hpp>
 
 namespace reef_moonshiners::ui::icp_import_dialog
 {
@@ -37,8 +38,13 @@ IcpSelectionWindow::IcpSelectionWindow(QWidget * parent)
   m_p_main_layout->addLayout(m_p_selection_layout);
   m_p_main_layout->addLayout(m_p_button_layout);
 
-  /* Add ATI ICP as an option, more to come :) */
-  m_p_combo_box->insertItem(0, "ATI ICP-OES");
+  /* one option per provider, in the order IcpSelection counts them */
+  const auto providers = reef_moonshiners::get_icp_providers();
+  for (size_t x = 0; x < providers.size(); ++x) {
+    const auto name = providers[x]->get_name();
+    m_p_combo_box->insertItem(
+      static_cast<int>(x), QString::fromUtf8(name.data(), static_cast<int>(name.size())));
+  }
 
   this->setLayout(m_p_main_layout);
 
@@ -0,0 +1,678 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/icp_provider.hpp>
+#include <reef_moonshiners/ati_page.hpp>
+#include <reef_moonshiners/json_scanner.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <system_error>
+
+namespace
+{
+
+using reef_moonshiners::IcpElement;
+using reef_moonshiners::IcpReport;
+using reef_moonshiners::JsonScanner;
+
+std::string_view trim(const std::string_view text, const std::string_view space = " \t\r\n")
+{
+  const auto first = text.find_first_not_of(space);
+  if (first == std::string_view::npos) {
+    return std::string_view{};
+  }
+  return text.substr(first, text.find_last_not_of(space) - first + 1);
+}
+
+bool equals_folded(const std::string_view text, const std::string_view lower)
+{
+  return text.size() == lower.size() && std::equal(
+    text.begin(), text.end(), lower.begin(), [](const char a, const char b) {
+      return reef_moonshiners::fold_icp_case(a) == b;
+    });
+}
+
+template<size_t N>
+bool is_one_of(const std::string_view text, const std::array<std::string_view, N> & lower)
+{
+  return std::any_of(
+    lower.begin(), lower.end(), [text](const std::string_view x) {
+      return equals_folded(text, x);
+    });
+}
+
+constexpr std::array<std::string_view, 4> element_keys{"element", "name", "analyte", "symbol"};
+constexpr std::array<std::string_view, 3> value_keys{"value", "result", "concentration"};
+constexpr std::array<std::string_view, 2> unit_keys{"unit", "units"};
+constexpr std::array<std::string_view, 3> date_keys{"date", "sample date", "collection date"};
+
+/**
+ * @brief Check for results that were not measured
+ */
+bool is_not_measured(std::string_view text)
+{
+  text = trim(text);
+  constexpr std::array<std::string_view, 5> missing{"n/a", "na", "nd", "-", "--"};
+  return text.empty() || '<' == text.front() || is_one_of(text, missing);
+}
+
+/**
+ * @brief Parse a date in ISO form, YYYY-MM-DD
+ */
+bool parse_iso_date(std::string_view text, std::chrono::year_month_day & date)
+{
+  text = trim(text);
+  int year = 0;
+  unsigned month = 0, day = 0;
+  const char * end = text.data() + text.size();
+  auto result = std::from_chars(text.data(), end, year);
+  if (std::errc{} != result.ec || result.ptr == end || '-' != *result.ptr) {
+    return false;
+  }
+  result = std::from_chars(result.ptr + 1, end, month);
+  if (std::errc{} != result.ec || result.ptr == end || '-' != *result.ptr) {
+    return false;
+  }
+  result = std::from_chars(result.ptr + 1, end, day);
+  if (std::errc{} != result.ec || result.ptr != end) {
+    return false;
+  }
+  date = std::chrono::year_month_day{
+    std::chrono::year{year}, std::chrono::month{month}, std::chrono::day{day}};
+  return date.ok();
+}
+
+/**
+ * @brief Record one measured result of a known element
+ */
+bool record_result(
+  IcpReport & report, const IcpElement element, std::string_view name, const double value,
+  const std::string_view unit, std::string & error)
+{
+  const double scale = reef_moonshiners::get_icp_unit_scale(unit);
+  if (0.0 == scale) {
+    error = "unknown unit \"" + std::string{trim(unit)} + "\" for \"" + std::string{name} + "\"";
+    return false;
+  }
+  report.results.set(element, value * scale);
+  return true;
+}
+
+/**
+ * @brief Record a result given as text, which may not have been measured
+ */
+bool record_text_result(
+  IcpReport & report, std::string_view name, const std::string_view text,
+  const std::string_view unit, std::string & error)
+{
+  name = trim(name);
+  const IcpElement element = reef_moonshiners::find_icp_element(name);
+  if (IcpElement::UNKNOWN == element) {
+    report.unknown.push_back(name);
+    return true;
+  }
+  if (is_not_measured(text)) {
+    return true;
+  }
+  double value = 0.0;
+  if (!reef_moonshiners::parse_icp_value(text, value)) {
+    error = "malformed value for \"" + std::string{name} + "\"";
+    return false;
+  }
+  return record_result(report, element, name, value, unit, error);
+}
+
+/**
+ * @brief Splits CSV lines into fields
+ *
+ * Quoted fields are returned without their quotes, but doubled quotes inside
+ * them are left doubled, as element names and numbers never hold quotes.
+ */
+class CsvLines
+{
+public:
+  explicit CsvLines(std::string_view text)
+  : m_text(text)
+  {
+    constexpr std::string_view bom{"\xEF\xBB\xBF"};
+    if (m_text.substr(0, bom.size()) == bom) {
+      m_text.remove_prefix(bom.size());
+    }
+  }
+
+  /**
+   * @brief Next line holding data, skipping blank lines and comments
+   */
+  bool next(std::string_view & line)
+  {
+    while (!m_text.empty()) {
+      const auto end = m_text.find('\n');
+      line = m_text.substr(0, end);
+      m_text.remove_prefix(end == std::string_view::npos ? m_text.size() : end + 1);
+      ++m_line;
+      const auto content = trim(line);
+      if (!content.empty() && '#' != content.front()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  size_t get_line_number() const
+  {
+    return m_line;
+  }
+
+  /**
+   * @brief Pick the delimiter the header uses most
+   */
+  void detect_delimiter(const std::string_view header)
+  {
+    size_t best = 0;
+    for (const char delimiter : {',', ';', '\t'}) {
+      const auto count = static_cast<size_t>(std::count(header.begin(), header.end(), delimiter));
+      if (count > best) {
+        best = count;
+        m_delimiter = delimiter;
+      }
+    }
+  }
+
+  bool split(std::string_view line, std::vector<std::string_view> & fields) const
+  {
+    fields.clear();
+    for (;;) {
+      line = this->_trim(line);
+      if (!line.empty() && '"' == line.front()) {
+        size_t close = 1;
+        for (; close < line.size(); ++close) {
+          if ('"' == line[close]) {
+            if (close + 1 < line.size() && '"' == line[close + 1]) {
+              ++close;
+            } else {
+              break;
+            }
+          }
+        }
+        if (close >= line.size()) {
+          return false;
+        }
+        fields.push_back(line.substr(1, close - 1));
+        line = this->_trim(line.substr(close + 1));
+        if (line.empty()) {
+          return true;
+        }
+        if (line.front() != m_delimiter) {
+          return false;
+        }
+        line.remove_prefix(1);
+        continue;
+      }
+      const auto end = line.find(m_delimiter);
+      fields.push_back(this->_trim(line.substr(0, end)));
+      if (end == std::string_view::npos) {
+        return true;
+      }
+      line.remove_prefix(end + 1);
+    }
+  }
+
+private:
+  /// trim a field, keeping a tab delimiter
+  std::string_view _trim(const std::string_view text) const
+  {
+    return trim(text, ('\t' == m_delimiter) ? " \r\n" : " \t\r\n");
+  }
+
+  std::string_view m_text;
+  size_t m_line = 0;
+  char m_delimiter = ',';
+};
+
+/**
+ * @brief Column of a wide export
+ */
+struct CsvColumn
+{
+  std::string_view name;
+  IcpElement element = IcpElement::UNKNOWN;
+  std::string_view unit;
+  bool is_date = false;
+};
+
+/**
+ * @brief Split a header such as "Zinc (ug/L)" into its name and unit
+ */
+CsvColumn parse_column(const std::string_view header)
+{
+  CsvColumn column;
+  column.is_date = is_one_of(header, date_keys);
+  const auto open = header.find_first_of("([");
+  column.name = trim(header.substr(0, open));
+  if (open != std::string_view::npos) {
+    const auto close = header.find_first_of(")]", open);
+    column.unit = trim(header.substr(open + 1, close - open - 1));
+  }
+  column.element = reef_moonshiners::find_icp_element(column.name);
+  return column;
+}
+
+std::string malformed_row(const CsvLines & lines)
+{
+  return "malformed row on line " + std::to_string(lines.get_line_number());
+}
+
+bool parse_long_csv(
+  CsvLines & lines, const std::vector<std::string_view> & header, IcpReport & report,
+  std::string & error)
+{
+  constexpr size_t none = std::string_view::npos;
+  size_t name_column = none, value_column = none, unit_column = none, date_column = none;
+  for (size_t x = 0; x < header.size(); ++x) {
+    if (none == name_column && is_one_of(header[x], element_keys)) {
+      name_column = x;
+    } else if (none == value_column && is_one_of(header[x], value_keys)) {
+      value_column = x;
+    } else if (none == unit_column && is_one_of(header[x], unit_keys)) {
+      unit_column = x;
+    } else if (none == date_column && is_one_of(header[x], date_keys)) {
+      date_column = x;
+    }
+  }
+  std::string_view line;
+  std::vector<std::string_view> fields;
+  fields.reserve(header.size());
+  while (lines.next(line)) {
+    if (!lines.split(line, fields) || fields.size() != header.size()) {
+      error = malformed_row(lines);
+      return false;
+    }
+    const std::string_view unit = (none == unit_column) ? std::string_view{} : fields[unit_column];
+    if (!record_text_result(report, fields[name_column], fields[value_column], unit, error)) {
+      return false;
+    }
+    if (none != date_column && !report.collection_date && !fields[date_column].empty()) {
+      std::chrono::year_month_day date;
+      if (!parse_iso_date(fields[date_column], date)) {
+        error = "malformed date on line " + std::to_string(lines.get_line_number());
+        return false;
+      }
+      report.collection_date = date;
+    }
+  }
+  return true;
+}
+
+bool parse_wide_csv(
+  CsvLines & lines, const std::vector<std::string_view> & header, IcpReport & report,
+  std::string & error)
+{
+  std::vector<CsvColumn> columns;
+  columns.reserve(header.size());
+  for (const auto & cell : header) {
+    columns.push_back(parse_column(cell));
+  }
+  std::string_view line;
+  if (!lines.next(line)) {
+    error = "no results found";
+    return false;
+  }
+  std::vector<std::string_view> fields;
+  fields.reserve(header.size());
+  if (!lines.split(line, fields) || fields.size() != columns.size()) {
+    error = malformed_row(lines);
+    return false;
+  }
+  for (size_t x = 0; x < columns.size(); ++x) {
+    const CsvColumn & column = columns[x];
+    if (column.is_date) {
+      std::chrono::year_month_day date;
+      if (!parse_iso_date(fields[x], date)) {
+        error = "malformed date on line " + std::to_string(lines.get_line_number());
+        return false;
+      }
+      report.collection_date = date;
+    } else if (IcpElement::UNKNOWN == column.element) {
+      report.unknown.push_back(column.name);
+    } else if (!is_not_measured(fields[x])) {
+      double value = 0.0;
+      if (!reef_moonshiners::parse_icp_value(fields[x], value)) {
+        error = "malformed value for \"" + std::string{column.name} + "\"";
+        return false;
+      }
+      if (!record_result(report, column.element, column.name, value, column.unit, error)) {
+        return false;
+      }
+    }
+  }
+  /* a report is one sample, so a second row would be silently dropped */
+  if (lines.next(line)) {
+    error = "more than one sample in line " + std::to_string(lines.get_line_number());
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Read a result, which may be a number, a string or null
+ *
+ * @param measured Output, false if the result is null or not measured
+ */
+bool scan_json_value(JsonScanner & scanner, double & value, bool & measured)
+{
+  measured = false;
+  if (scanner.consume_null()) {
+    return true;
+  }
+  if (scanner.peek('"')) {
+    std::string_view text;
+    if (!scanner.string(text)) {
+      return false;
+    }
+    if (is_not_measured(text)) {
+      return true;
+    }
+    measured = reef_moonshiners::parse_icp_value(text, value);
+    return measured;
+  }
+  measured = scanner.number(value);
+  return measured;
+}
+
+/**
+ * @brief A result read from JSON, before it is recorded
+ */
+struct JsonResult
+{
+  std::string_view name;
+  std::string_view unit;
+  double value = 0.0;
+  bool measured = false;
+};
+
+bool record_json_result(IcpReport & report, const JsonResult & result, std::string & error)
+{
+  const std::string_view name = trim(result.name);
+  const IcpElement element = reef_moonshiners::find_icp_element(name);
+  if (IcpElement::UNKNOWN == element) {
+    report.unknown.push_back(name);
+    return true;
+  }
+  return !result.measured ||
+         record_result(report, element, name, result.value, result.unit, error);
+}
+
+/**
+ * @brief Read an object of fields, such as {"value": 3.2, "unit": "ug/L"}
+ */
+bool scan_json_fields(JsonScanner & scanner, JsonResult & result)
+{
+  if (!scanner.consume('{')) {
+    return false;
+  }
+  if (scanner.consume('}')) {
+    return true;
+  }
+  do {
+    std::string_view key;
+    if (!scanner.string(key) || !scanner.consume(':')) {
+      return false;
+    }
+    bool read = false;
+    if (is_one_of(key, element_keys)) {
+      read = scanner.string(result.name);
+    } else if (is_one_of(key, value_keys)) {
+      read = scan_json_value(scanner, result.value, result.measured);
+    } else if (is_one_of(key, unit_keys)) {
+      read = scanner.string(result.unit);
+    } else {
+      read = scanner.skip_value(2);
+    }
+    if (!read) {
+      return false;
+    }
+  } while (scanner.consume(','));
+  return scanner.consume('}');
+}
+
+bool scan_json_array(JsonScanner & scanner, IcpReport & report, std::string & error)
+{
+  if (!scanner.consume('[')) {
+    return false;
+  }
+  if (scanner.consume(']')) {
+    return true;
+  }
+  size_t index = 0;
+  do {
+    JsonResult result;
+    if (!scan_json_fields(scanner, result) || result.name.empty()) {
+      error = "malformed result " + std::to_string(index);
+      return false;
+    }
+    if (!record_json_result(report, result, error)) {
+      return false;
+    }
+    ++index;
+  } while (scanner.consume(','));
+  return scanner.consume(']');
+}
+
+bool scan_json_object(
+  JsonScanner & scanner, IcpReport & report, const bool top, std::string & error)
+{
+  if (!scanner.consume('{')) {
+    return false;
+  }
+  if (scanner.consume('}')) {
+    return true;
+  }
+  do {
+    JsonResult result;
+    if (!scanner.string(result.name) || !scanner.consume(':')) {
+      return false;
+    }
+    if (top && is_one_of(result.name, date_keys)) {
+      std::string_view text;
+      std::chrono::year_month_day date;
+      if (!scanner.string(text) || !parse_iso_date(text, date)) {
+        error = "malformed date";
+        return false;
+      }
+      report.collection_date = date;
+      continue;
+    }
+    if (top && equals_folded(result.name, "results")) {
+      const bool read = scanner.peek('[') ?
+        scan_json_array(scanner, report, error) : scan_json_object(scanner, report, false, error);
+      if (!read) {
+        return false;
+      }
+      continue;
+    }
+    bool read = false;
+    if (reef_moonshiners::find_icp_element(trim(result.name)) == IcpElement::UNKNOWN) {
+      read = scanner.skip_value(1);
+    } else if (scanner.peek('{')) {
+      read = scan_json_fields(scanner, result);
+    } else {
+      read = scan_json_value(scanner, result.value, result.measured);
+    }
+    if (!read) {
+      error = "malformed value for \"" + std::string{result.name} + "\"";
+      return false;
+    }
+    if (!record_json_result(report, result, error)) {
+      return false;
+    }
+  } while (scanner.consume(','));
+  return scanner.consume('}');
+}
+
+const reef_moonshiners::AtiIcpProvider ati_provider;
+const reef_moonshiners::CsvIcpProvider csv_provider;
+const reef_moonshiners::JsonIcpProvider json_provider;
+
+const std::array<const reef_moonshiners::IcpProvider *, 3> providers{
+  &ati_provider, &csv_provider, &json_provider};
+
+}  // namespace
+
+namespace reef_moonshiners
+{
+
+void IcpReport::clear()
+{
+  results.clear();
+  collection_date.reset();
+  unknown.clear();
+}
+
+std::string_view AtiIcpProvider::get_name() const
+{
+  return "ATI ICP-OES";
+}
+
+bool AtiIcpProvider::is_file_based() const
+{
+  return false;
+}
+
+bool AtiIcpProvider::parse(
+  const std::string_view text, IcpReport & report, std::string & error) const
+{
+  report.clear();
+  AtiPage page;
+  if (!page.scan(text, error)) {
+    return false;
+  }
+  page.get_results(report.results, report.unknown);
+  return true;
+}
+
+std::string_view CsvIcpProvider::get_name() const
+{
+  return "CSV export";
+}
+
+bool CsvIcpProvider::is_file_based() const
+{
+  return true;
+}
+
+bool CsvIcpProvider::parse(
+  const std::string_view text, IcpReport & report, std::string & error) const
+{
+  report.clear();
+  CsvLines lines{text};
+  std::string_view line;
+  if (!lines.next(line)) {
+    error = "no results found";
+    return false;
+  }
+  lines.detect_delimiter(line);
+  std::vector<std::string_view> header;
+  if (!lines.split(line, header)) {
+    error = "malformed header";
+    return false;
+  }
+  const bool is_long =
+    std::any_of(
+    header.begin(), header.end(), [](auto x) {return is_one_of(x, element_keys);}) &&
+    std::any_of(header.begin(), header.end(), [](auto x) {return is_one_of(x, value_keys);});
+  if (!(is_long ? parse_long_csv(lines, header, report, error) :
+    parse_wide_csv(lines, header, report, error)))
+  {
+    report.results.clear();
+    return false;
+  }
+  if (0 == report.results.size()) {
+    error = "no results found";
+    return false;
+  }
+  return true;
+}
+
+std::string_view JsonIcpProvider::get_name() const
+{
+  return "JSON export";
+}
+
+bool JsonIcpProvider::is_file_based() const
+{
+  return true;
+}
+
+bool JsonIcpProvider::parse(
+  const std::string_view text, IcpReport & report, std::string & error) const
+{
+  report.clear();
+  JsonScanner scanner{text.data(), text.data() + text.size()};
+  error.clear();
+  const bool read = scanner.peek('[') ?
+    scan_json_array(scanner, report, error) : scan_json_object(scanner, report, true, error);
+  if (!read || !scanner.at_end()) {
+    if (error.empty()) {
+      error = "malformed JSON";
+    }
+    report.results.clear();
+    return false;
+  }
+  if (0 == report.results.size()) {
+    error = "no results found";
+    return false;
+  }
+  return true;
+}
+
+std::span<const IcpProvider * const> get_icp_providers()
+{
+  return providers;
+}
+
+double get_icp_unit_scale(std::string_view unit)
+{
+  unit = trim(unit);
+  /* micro is either the micro sign or the Greek letter mu */
+  constexpr std::array<std::string_view, 5> micrograms{
+    "", "ug/l", "\xC2\xB5g/l", "\xCE\xBCg/l", "ppb"};
+  constexpr std::array<std::string_view, 2> milligrams{"mg/l", "ppm"};
+  if (is_one_of(unit, micrograms)) {
+    return 1.0;
+  }
+  if (is_one_of(unit, milligrams)) {
+    return 1E3;
+  }
+  return 0.0;
+}
+
+bool parse_icp_value(std::string_view text, double & value)
+{
+  text = trim(text);
+  /* some locales write a decimal comma, which from_chars does not read */
+  std::array<char, 64> buffer;
+  if (text.find(',') != std::string_view::npos && text.size() <= buffer.size()) {
+    std::replace_copy(text.begin(), text.end(), buffer.begin(), ',', '.');
+    text = std::string_view{buffer.data(), text.size()};
+  }
+  if (text.empty()) {
+    return false;
+  }
+  const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+  return std::errc{} == ec && end == text.data() + text.size();
+}
+
+}  // namespace reef_moonshiners
@@ -0,0 +1,191 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/journal.hpp>
+#include <reef_moonshiners/element_base.hpp>
+
+#include <cstdio>
+#include <sstream>
+#include <system_error>
+#include <utility>
+
+namespace
+{
+
+/// "RMJ" and the format version
+constexpr uint32_t journal_magic = 0x014a4d52;
+
+/// type, day, value, key length and the longest key replay accepts
+constexpr size_t max_record_size =
+  sizeof(reef_moonshiners::JournalEntryType) + sizeof(int32_t) + sizeof(double) +
+  sizeof(uint16_t) + reef_moonshiners::Journal::max_key_length;
+
+/**
+ * FNV-1a over a record, to detect torn writes
+ */
+uint32_t checksum(const std::string & data)
+{
+  uint32_t hash = 2166136261u;
+  for (const char c : data) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+}  // namespace
+
+namespace reef_moonshiners
+{
+
+Journal::Journal(std::filesystem::path path)
+: m_path(std::move(path))
+{
+}
+
+const std::filesystem::path & Journal::get_path() const
+{
+  return m_path;
+}
+
+std::vector<JournalEntry> Journal::replay()
+{
+  std::vector<JournalEntry> entries;
+  m_stream.close();
+  m_entries = 0;
+  std::ifstream file{m_path, std::ios::binary};
+  if (!file) {
+    return entries;  /* nothing was journaled */
+  }
+  uint32_t magic = 0;
+  binary_in(file, magic);
+  if (!file || journal_magic != magic) {
+    fprintf(stderr, "Error: '%s' is not a journal, ignoring it\n", m_path.string().c_str());
+    file.close();
+    this->clear();
+    return entries;
+  }
+  std::error_code error;
+  const uintmax_t file_size = std::filesystem::file_size(m_path, error);
+  std::streamoff intact = file.tellg();
+  for (;; ) {
+    uint32_t size = 0;
+    binary_in(file, size);
+    if (!file) {
+      break;
+    }
+    /* a corrupt size is a torn tail too, and must not size the buffer */
+    const uintmax_t remaining = file_size - static_cast<uintmax_t>(file.tellg());
+    if (size > max_record_size || size + sizeof(uint32_t) > remaining) {
+      break;
+    }
+    std::string record(size, '\0');
+    file.read(record.data(), record.size());
+    uint32_t sum = 0;
+    binary_in(file, sum);
+    if (!file || checksum(record) != sum) {
+      break;
+    }
+    std::istringstream stream{record};
+    JournalEntry entry;
+    int32_t day = 0;
+    uint16_t key_length = 0;
+    binary_in(stream, entry.type);
+    binary_in(stream, day);
+    binary_in(stream, entry.value);
+    binary_in(stream, key_length);
+    if (!stream || key_length > max_key_length) {
+      break;
+    }
+    entry.key.resize(key_length);
+    stream.read(entry.key.data(), key_length);
+    if (!stream) {
+      break;
+    }
+    entry.date = std::chrono::sys_days{std::chrono::days{day}};
+    entries.push_back(std::move(entry));
+    intact = file.tellg();
+  }
+  file.close();
+  /* drop a torn tail, so appended entries follow the last intact one */
+  if (file_size != static_cast<uintmax_t>(intact)) {
+    fprintf(stderr, "Warning: dropping the torn tail of '%s'\n", m_path.string().c_str());
+    std::filesystem::resize_file(m_path, intact, error);
+  }
+  m_entries = entries.size();
+  return entries;
+}
+
+bool Journal::append(const JournalEntry & entry)
+{
+  if (!m_stream.is_open() && !this->_open()) {
+    return false;
+  }
+  std::ostringstream record;
+  binary_out(record, entry.type);
+  binary_out(
+    record,
+    static_cast<int32_t>(std::chrono::sys_days{entry.date}.time_since_epoch().count()));
+  binary_out(record, entry.value);
+  binary_out(record, static_cast<uint16_t>(entry.key.size()));
+  record.write(entry.key.data(), entry.key.size());
+  const std::string data = record.str();
+  /* one write per entry, so a crash tears at most the last one */
+  std::ostringstream framed;
+  binary_out(framed, static_cast<uint32_t>(data.size()));
+  framed.write(data.data(), data.size());
+  binary_out(framed, checksum(data));
+  const std::string bytes = framed.str();
+  m_stream.write(bytes.data(), bytes.size());
+  m_stream.flush();
+  if (!m_stream) {
+    fprintf(stderr, "Error: could not append to '%s'\n", m_path.string().c_str());
+    m_stream.close();
+    return false;
+  }
+  ++m_entries;
+  return true;
+}
+
+size_t Journal::get_entry_count() const
+{
+  return m_entries;
+}
+
+bool Journal::clear()
+{
+  m_stream.close();
+  m_entries = 0;
+  std::error_code error;
+  std::filesystem::remove(m_path, error);
+  return !error;
+}
+
+bool Journal::_open()
+{
+  std::error_code error;
+  const bool empty = !std::filesystem::exists(m_path, error) ||
+    0 == std::filesystem::file_size(m_path, error);
+  m_stream.open(m_path, std::ios::binary | std::ios::app);
+  if (!m_stream) {
+    fprintf(stderr, "Error: could not open '%s'\n", m_path.string().c_str());
+    return false;
+  }
+  if (empty) {
+    binary_out(m_stream, journal_magic);
+  }
+  return true;
+}
+
+}  // namespace reef_moonshiners
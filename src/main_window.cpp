@@ -17,17 +17,38 @@
 #include <fstream>
 #include <filesystem>
 #include <iostream>
-
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <QFileDialog>
+#include <QMessageBox>
 #include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QEventLoop>
-#include <QXmlStreamReader>
-#include <QJsonDocument>
-#include <QJsonParseError>
+#include <QSignalBlocker>
+
+#include <reef_moonshiners/mapped_file.hpp>
+#include <reef_moonshiners/save_file.hpp>
 
 namespace
 {
 namespace fs = std::filesystem;
+
+/* names of the settings in the journal */
+constexpr std::string_view tank_volume_setting = "tank_volume";
+constexpr std::string_view refugium_setting = "refugium";
+constexpr std::string_view nano_dose_setting = "nano_dose";
+constexpr std::string_view iodine_drops_setting = "iodine_drops";
+constexpr std::string_view vanadium_drops_setting = "vanadium_drops";
+constexpr std::string_view rubidium_frequency_setting = "rubidium_frequency";
+constexpr std::string_view rubidium_start_date_setting = "rubidium_start_date";
+
+fs::path data_directory()
+{
+  return fs::path{QStandardPaths::writableLocation(QStandardPaths::AppDataLocation).toStdString()};
+}
+
 }  // namespace
 
 namespace reef_moonshiners::ui
@@ -36,8 +57,6 @@ namespace reef_moonshiners::ui
 MainWindow::MainWindow(QWidget * parent)
 : QMainWindow(parent)
 {
-  reef_moonshiners::ElementBase::set_tank_size(reef_moonshiners::gallons_to_liters(75));
-
   m_p_dose_label = new QLabel(tr("Dosing Summary"), this);
   m_p_dose_label->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
   m_p_import_action = new QAction(tr("Import ICP Data"), this);
@@ -49,6 +68,9 @@ MainWindow::MainWindow(QWidget * parent)
   m_p_settings_window = new SettingsWindow(this);
   m_p_icp_selection_window = new icp_import_dialog::IcpSelectionWindow(this);
   m_p_ati_entry_window = new icp_import_dialog::ATIEntryWindow(this);
+  m_p_ati_batch_entry_window = new icp_import_dialog::ATIBatchEntryWindow(this);
+  m_p_network = new QNetworkAccessManager(this);
+  m_p_icp_cache = std::make_shared<reef_moonshiners::IcpCache>(data_directory() / "icp_cache");
   m_p_ati_correction_start_window = new icp_import_dialog::ATICorrectionStartWindow(this);
   m_p_about_window = new AboutWindow(this);
 
@@ -59,8 +81,11 @@ MainWindow::MainWindow(QWidget * parent)
   m_p_main_layout->addWidget(m_p_calendar);
   m_p_main_layout->addWidget(m_p_dose_label);
 
-  m_p_list_widget = new QListWidget();
-  m_p_main_layout->addWidget(m_p_list_widget);
+  /* rows are all one height, so the view lays out only the rows in sight */
+  m_p_list_view = new QListView();
+  m_p_list_view->setUniformItemSizes(true);
+  m_p_list_view->setLayoutMode(QListView::Batched);
+  m_p_main_layout->addWidget(m_p_list_view);
 
   m_p_toolbar = new QToolBar(this);
   m_p_toolbar->addAction(m_p_import_action);
@@ -75,7 +100,7 @@ MainWindow::MainWindow(QWidget * parent)
 
   /* list connections */
   QObject::connect(
-    m_p_list_widget, &QListWidget::itemClicked,
+    m_p_list_view, &QListView::clicked,
     this, &MainWindow::_handle_item_clicked);
 
   /* action mappings */
@@ -126,6 +151,16 @@ MainWindow::MainWindow(QWidget * parent)
   QObject::connect(
     m_p_ati_entry_window, &icp_import_dialog::ATIEntryWindow::next_button_pressed,
     this, &MainWindow::_handle_next_ati_entry_window);
+  QObject::connect(
+    m_p_ati_entry_window->get_batch_button(), &QPushButton::clicked,
+    this, &MainWindow::_handle_batch_ati_entry_window);
+  QObject::connect(
+    m_p_ati_batch_entry_window->get_back_button(), &QPushButton::clicked,
+    this, &MainWindow::_handle_back_ati_batch_entry_window);
+  QObject::connect(
+    m_p_ati_batch_entry_window,
+    &icp_import_dialog::ATIBatchEntryWindow::import_button_pressed,
+    this, &MainWindow::_handle_import_ati_batch_entry_window);
   QObject::connect(
     m_p_ati_correction_start_window,
     &icp_import_dialog::ATICorrectionStartWindow::okay_button_pressed,
@@ -156,122 +191,165 @@ MainWindow::MainWindow(QWidget * parent)
 
   this->_fill_element_list();
   this->_load();
+  /* changes made after the last save */
+  reef_moonshiners::Journal journal{data_directory() / "reef_moonshiners.journal"};
+  for (const auto & entry : journal.replay()) {
+    this->_apply(entry);
+  }
+  m_journaled = journal.get_entry_count();
+  m_p_persistence = std::make_unique<reef_moonshiners::PersistenceWorker>(
+    std::move(journal),
+    [out = data_directory() / "reef_moonshiners.dat"](const std::string & snapshot) {
+      return replace_file(out, snapshot);
+    },
+    m_persistence_window,
+    [this] {
+      /* a change that could not be journaled is kept by a full save instead */
+      QMetaObject::invokeMethod(this, &MainWindow::_save, Qt::QueuedConnection);
+    });
+  this->_update_settings_window();
   this->_refresh_elements();
 }
 
+MainWindow::~MainWindow()
+{
+  /* fold the journal into the save file */
+  if (m_journaled > 0) {
+    this->_save();
+  }
+  /* finish writing before the elements go away */
+  m_p_persistence.reset();
+}
+
 void MainWindow::_fill_element_list()
 {
+  /* elements are listed in the order they are added */
+  std::vector<const reef_moonshiners::ElementBase *> listed;
+  const auto add = [this, &listed](reef_moonshiners::ElementBase * element) {
+      const std::chrono::year_month_day now{std::chrono::floor<std::chrono::days>(
+          std::chrono::system_clock::now())};
+      /* every element doses our tank, and starts unmeasured */
+      element->set_tank(m_p_tank);
+      element->set_concentration(0.0, now);
+      listed.push_back(element);
+    };
+
   /* daily elements */
 
   auto manganese = std::make_unique<reef_moonshiners::Manganese>();
-  m_elements.emplace(std::move(manganese), new ElementDisplay(manganese.get(), m_p_list_widget));
+  add(manganese.get());
+  m_elements.insert(std::move(manganese));
   auto chromium = std::make_unique<reef_moonshiners::Chromium>();
-  m_elements.emplace(std::move(chromium), new ElementDisplay(chromium.get(), m_p_list_widget));
+  add(chromium.get());
+  m_elements.insert(std::move(chromium));
   auto selenium = std::make_unique<reef_moonshiners::Selenium>();
-  m_elements.emplace(std::move(selenium), new ElementDisplay(selenium.get(), m_p_list_widget));
+  add(selenium.get());
+  m_elements.insert(std::move(selenium));
   auto cobalt = std::make_unique<reef_moonshiners::Cobalt>();
-  m_elements.emplace(std::move(cobalt), new ElementDisplay(cobalt.get(), m_p_list_widget));
+  add(cobalt.get());
+  m_elements.insert(std::move(cobalt));
   auto iron = std::make_unique<reef_moonshiners::Iron>();
-  m_elements.emplace(std::move(iron), new ElementDisplay(iron.get(), m_p_list_widget));
+  add(iron.get());
+  m_elements.insert(std::move(iron));
 
   /* rubidium */
 
   m_p_rubidium_element = std::make_unique<reef_moonshiners::Rubidium>();
-  m_p_rubidium_display = new ElementDisplay(m_p_rubidium_element.get(), m_p_list_widget);
+  add(m_p_rubidium_element.get());
 
   /* dropper elements */
 
   auto iodine = std::make_unique<reef_moonshiners::Iodine>();
   m_p_iodine_element = iodine.get();
-  m_dropper_elements.emplace(std::move(iodine), new ElementDisplay(iodine.get(), m_p_list_widget));
+  add(iodine.get());
+  m_dropper_elements.insert(std::move(iodine));
   auto vanadium = std::make_unique<reef_moonshiners::Vanadium>();
   m_p_vanadium_element = vanadium.get();
-  m_dropper_elements.emplace(
-    std::move(vanadium), new ElementDisplay(
-      vanadium.get(), m_p_list_widget));
+  add(vanadium.get());
+  m_dropper_elements.insert(std::move(vanadium));
 
   /* corrections */
   auto fluorine = std::make_unique<reef_moonshiners::Fluorine>();
-  m_correction_elements.emplace(
-    std::move(fluorine),
-    new ElementDisplay(fluorine.get(), m_p_list_widget));
+  add(fluorine.get());
+  m_correction_elements.insert(std::move(fluorine));
   auto bromine = std::make_unique<reef_moonshiners::Bromine>();
-  m_correction_elements.emplace(
-    std::move(bromine),
-    new ElementDisplay(bromine.get(), m_p_list_widget));
+  add(bromine.get());
+  m_correction_elements.insert(std::move(bromine));
   auto nickel = std::make_unique<reef_moonshiners::Nickel>();
-  m_correction_elements.emplace(
-    std::move(nickel),
-    new ElementDisplay(nickel.get(), m_p_list_widget));
+  add(nickel.get());
+  m_correction_elements.insert(std::move(nickel));
   auto zinc = std::make_unique<reef_moonshiners::Zinc>();
-  m_correction_elements.emplace(std::move(zinc), new ElementDisplay(zinc.get(), m_p_list_widget));
+  add(zinc.get());
+  m_correction_elements.insert(std::move(zinc));
   auto barium = std::make_unique<reef_moonshiners::Barium>();
-  m_correction_elements.emplace(
-    std::move(barium),
-    new ElementDisplay(barium.get(), m_p_list_widget));
+  add(barium.get());
+  m_correction_elements.insert(std::move(barium));
   auto boron = std::make_unique<reef_moonshiners::Boron>();
-  m_correction_elements.emplace(std::move(boron), new ElementDisplay(boron.get(), m_p_list_widget));
+  add(boron.get());
+  m_correction_elements.insert(std::move(boron));
   auto strontium = std::make_unique<reef_moonshiners::Strontium>();
-  m_correction_elements.emplace(
-    std::move(strontium),
-    new ElementDisplay(strontium.get(), m_p_list_widget));
+  add(strontium.get());
+  m_correction_elements.insert(std::move(strontium));
   auto potassium = std::make_unique<reef_moonshiners::Potassium>();
-  m_correction_elements.emplace(
-    std::move(potassium),
-    new ElementDisplay(potassium.get(), m_p_list_widget));
+  add(potassium.get());
+  m_correction_elements.insert(std::move(potassium));
+
+  m_p_dose_model = new DoseListModel(std::move(listed), this);
+  m_p_list_view->setModel(m_p_dose_model);
 }
 
-void MainWindow::_handle_item_clicked(QListWidgetItem * p_item)
+void MainWindow::_handle_item_clicked(const QModelIndex & index)
 {
-  if (nullptr == p_item) {
+  if (!index.isValid()) {
     return;
   }
-
-  if (p_item->data(Qt::CheckStateRole) != Qt::Checked) {
-    dynamic_cast<ElementDisplay *>(p_item)->set_checked(true);
-  } else {
-    dynamic_cast<ElementDisplay *>(p_item)->set_checked(false);
-  }
+  m_p_dose_model->toggle_checked(index);
 }
 
 void MainWindow::_save()
 {
-  fs::path out{
-    QStandardPaths::writableLocation(QStandardPaths::AppDataLocation).toStdString()};
-  fs::create_directories(out);  /* create if not exists */
-  out = out / "reef_moonshiners.dat";
-  std::ofstream file{out, std::ios::binary};
-  binary_out(file, m_save_file_version);
-  binary_out(file, reef_moonshiners::ElementBase::get_tank_size());
-  binary_out(file, m_refugium_state);
-  binary_out(file, m_nano_dose_state);
-  for (const auto & [daily, display] : m_elements) {
-    (void)display;
-    file << *daily;
+  /* sections are keyed by element name, so the order we visit them in does not matter */
+  reef_moonshiners::SaveFile save_file;
+  std::ostream & settings = save_file.add_section("settings");
+  binary_out(settings, m_p_tank->get_volume());
+  binary_out(settings, m_refugium_state);
+  binary_out(settings, m_nano_dose_state);
+  for (const auto & daily : m_elements) {
+    save_file.add_section(daily->get_name()) << *daily;
   }
-  for (const auto & [daily, display] : m_dropper_elements) {
-    (void)display;
-    file << *daily;
+  for (const auto & dropper : m_dropper_elements) {
+    save_file.add_section(dropper->get_name()) << *dropper;
   }
-  file << *m_p_rubidium_element;
-  for (const auto & [correction, display] : m_correction_elements) {
-    (void)display;
-    file << *correction;
+  save_file.add_section(m_p_rubidium_element->get_name()) << *m_p_rubidium_element;
+  for (const auto & correction : m_correction_elements) {
+    correction->write_settings_to(save_file.add_section(correction->get_name()));
+    correction->write_ledger_to(save_file.add_section(correction->get_name() + "/ledger"));
   }
+  /* serialize here, the worker thread writes it out */
+  std::ostringstream snapshot;
+  binary_out(snapshot, static_cast<uint64_t>(m_save_file_version));
+  save_file.write_to(snapshot);
+  m_p_persistence->save(snapshot.str());
+  m_journaled = 0;
 }
 
 bool MainWindow::_load()
 {
-  fs::path dir{QStandardPaths::writableLocation(QStandardPaths::AppDataLocation).toStdString()};
-  fs::path in = dir / "reef_moonshiners.dat";
+  fs::path in = data_directory() / "reef_moonshiners.dat";
   if (!fs::exists(in)) {
     m_p_vanadium_element->set_drops(1);
     m_p_iodine_element->set_drops(2);
     return false;  /* this will be created after we save */
   }
-  std::ifstream file{in, std::ios::binary};
+  /* map the save, so loading reads straight out of the page cache */
+  reef_moonshiners::MappedFile mapped;
+  if (!mapped.open(in)) {
+    fprintf(stderr, "Error: could not open '%s'\n", in.string().c_str());
+    return false;
+  }
+  reef_moonshiners::MemoryStream file{mapped.get_data()};
   /* read save_file_version */
-  size_t save_file_version = 0;
+  uint64_t save_file_version = 0;
   binary_in(file, save_file_version);
   if (save_file_version > m_save_file_version) {
     /* version zero assumed */
@@ -280,25 +358,31 @@ bool MainWindow::_load()
     file.seekg(0, file.beg);
   }
   reef_moonshiners::ElementBase::set_load_version(save_file_version);
+  bool loaded = true;
+  if (save_file_version >= 5) {
+    loaded = this->_load_sections(file, save_file_version);
+  } else {
+    this->_load_sequential(file, save_file_version);
+  }
+  return loaded;
+}
+
+void MainWindow::_load_sequential(std::istream & file, const size_t save_file_version)
+{
+  /* files prior to version 5 are a sequence of elements, in the order of our sets */
   double tank_size;
   binary_in(file, tank_size);
-  reef_moonshiners::ElementBase::set_tank_size(tank_size);
-  const double gallons = reef_moonshiners::liters_to_gallons(tank_size);
-  m_p_settings_window->get_tank_size_edit()->setText(QString().setNum(gallons));
+  m_p_tank->set_volume(tank_size);
   binary_in(file, m_refugium_state);
-  m_p_settings_window->get_refugium_checkbox()->setCheckState(Qt::CheckState(m_refugium_state));
   if (save_file_version >= 3) {
     binary_in(file, m_nano_dose_state);
   }
-  m_p_settings_window->get_nano_dose_checkbox()->setCheckState(Qt::CheckState(m_nano_dose_state));
-  for (auto & [daily, display] : m_elements) {
-    (void)display;
+  for (auto & daily : m_elements) {
     file >> *daily;
   }
   /* load dropper elements */
   if (save_file_version >= 1) {
-    for (auto & [daily, display] : m_dropper_elements) {
-      (void)display;
+    for (auto & daily : m_dropper_elements) {
       file >> *daily;
     }
   } else {
@@ -309,6 +393,69 @@ bool MainWindow::_load()
   if (save_file_version >= 2) {
     file >> *m_p_rubidium_element;
   }
+  for (auto & correction : m_correction_elements) {
+    file >> *correction;
+  }
+}
+
+bool MainWindow::_load_sections(std::istream & file, const size_t save_file_version)
+{
+  reef_moonshiners::SaveFile save_file;
+  if (!save_file.read_from(file)) {
+    return false;
+  }
+  if (save_file.seek(file, "settings")) {
+    double tank_size;
+    binary_in(file, tank_size);
+    m_p_tank->set_volume(tank_size);
+    binary_in(file, m_refugium_state);
+    binary_in(file, m_nano_dose_state);
+  }
+  for (auto & daily : m_elements) {
+    if (save_file.seek(file, daily->get_name())) {
+      file >> *daily;
+    }
+  }
+  if (save_file.seek(file, m_p_vanadium_element->get_name())) {
+    file >> *m_p_vanadium_element;
+  } else {
+    m_p_vanadium_element->set_drops(1);
+  }
+  if (save_file.seek(file, m_p_iodine_element->get_name())) {
+    file >> *m_p_iodine_element;
+  } else {
+    m_p_iodine_element->set_drops(2);
+  }
+  if (save_file.seek(file, m_p_rubidium_element->get_name())) {
+    file >> *m_p_rubidium_element;
+  }
+  for (auto & correction : m_correction_elements) {
+    if (save_file.seek(file, correction->get_name())) {
+      correction->read_settings_from(file);
+    }
+    /* dose histories are only read once something asks for them */
+    std::string ledger;
+    if (save_file.read_section(file, correction->get_name() + "/ledger", ledger)) {
+      correction->defer_ledger(std::move(ledger), save_file_version);
+    }
+  }
+  return true;
+}
+
+void MainWindow::_update_settings_window()
+{
+  /* the loaded elements already hold these settings, so don't echo them back */
+  const QSignalBlocker tank_size_blocker{m_p_settings_window->get_tank_size_edit()};
+  const QSignalBlocker refugium_blocker{m_p_settings_window->get_refugium_checkbox()};
+  const QSignalBlocker nano_dose_blocker{m_p_settings_window->get_nano_dose_checkbox()};
+  const QSignalBlocker iodine_blocker{m_p_settings_window->get_iodine_spinbox()};
+  const QSignalBlocker vanadium_blocker{m_p_settings_window->get_vanadium_spinbox()};
+  const QSignalBlocker rubidium_date_blocker{m_p_settings_window->get_rubidium_start_dateedit()};
+  const QSignalBlocker rubidium_blocker{m_p_settings_window->get_rubidium_combobox()};
+  const double gallons = reef_moonshiners::liters_to_gallons(m_p_tank->get_volume());
+  m_p_settings_window->get_tank_size_edit()->setText(QString().setNum(gallons));
+  m_p_settings_window->get_refugium_checkbox()->setCheckState(Qt::CheckState(m_refugium_state));
+  m_p_settings_window->get_nano_dose_checkbox()->setCheckState(Qt::CheckState(m_nano_dose_state));
   m_p_settings_window->get_iodine_spinbox()->setValue(
     (int)m_p_iodine_element->get_dose(std::chrono::year_month_day{}));
   m_p_settings_window->get_vanadium_spinbox()->setValue(
@@ -318,26 +465,112 @@ bool MainWindow::_load()
     QDate((int)date.year(), (unsigned)date.month(), (unsigned)date.day()));
   m_p_settings_window->get_rubidium_combobox()->setCurrentIndex(
     (uint8_t)m_p_rubidium_element->get_dosing_frequency());
-  for (auto & [correction, display] : m_correction_elements) {
-    (void)display;
-    file >> *correction;
-  }
-  return true;
 }
 
 void MainWindow::_refresh_elements()
 {
-  for (auto &[element, display] : m_correction_elements) {
-    display->update_dosage(m_p_calendar->selectedDate());
+  /* the model recomputes only the elements whose generation moved, and tells */
+  /* the view which rows changed */
+  m_p_dose_model->set_date(m_p_calendar->selectedDate());
+}
+
+reef_moonshiners::ElementBase * MainWindow::_find_element(const std::string & name)
+{
+  for (auto & element : m_elements) {
+    if (element->get_name() == name) {
+      return element.get();
+    }
   }
-  for (auto &[element, display] : m_elements) {
-    display->update_dosage(m_p_calendar->selectedDate());
+  for (auto & element : m_dropper_elements) {
+    if (element->get_name() == name) {
+      return element.get();
+    }
+  }
+  if (m_p_rubidium_element->get_name() == name) {
+    return m_p_rubidium_element.get();
   }
-  for (auto &[element, display] : m_dropper_elements) {
-    display->update_dosage(m_p_calendar->selectedDate());
+  for (auto & element : m_correction_elements) {
+    if (element->get_name() == name) {
+      return element.get();
+    }
+  }
+  return nullptr;
+}
+
+void MainWindow::_record(const reef_moonshiners::JournalEntry & entry)
+{
+  this->_apply(entry);
+  m_p_persistence->append(entry);
+  if (++m_journaled >= m_journal_compaction_threshold) {
+    this->_save();
+  }
+}
+
+void MainWindow::_apply(const reef_moonshiners::JournalEntry & entry)
+{
+  using reef_moonshiners::JournalEntryType;
+  switch (entry.type) {
+    case JournalEntryType::APPLY_DOSE:
+      if (auto * element = this->_find_element(entry.key)) {
+        element->apply_dose(entry.value, entry.date);
+      }
+      break;
+    case JournalEntryType::SET_CONCENTRATION:
+      if (auto * element = this->_find_element(entry.key)) {
+        element->set_concentration(entry.value, entry.date);
+      }
+      break;
+    case JournalEntryType::SET_CORRECTION_START_DATE:
+      for (auto & correction : m_correction_elements) {
+        if (correction->get_name() == entry.key) {
+          correction->set_correction_start_date(entry.date);
+        }
+      }
+      break;
+    case JournalEntryType::SET_SETTING:
+      this->_apply_setting(entry);
+      break;
+  }
+}
+
+void MainWindow::_apply_setting(const reef_moonshiners::JournalEntry & entry)
+{
+  if (tank_volume_setting == entry.key) {
+    m_p_tank->set_volume(entry.value);
+  } else if (refugium_setting == entry.key) {
+    m_refugium_state = static_cast<int>(entry.value);
+    if (Qt::Checked == m_refugium_state) {
+      for (const auto & element : m_elements) {
+        element->set_multiplier(2.0);  /* this doubles the daily dose */
+      }
+    } else if (Qt::Unchecked == m_refugium_state) {
+      for (const auto & element : m_elements) {
+        element->set_multiplier(1.0);
+      }
+    }
+  } else if (nano_dose_setting == entry.key) {
+    m_nano_dose_state = static_cast<int>(entry.value);
+    if (Qt::Checked == m_nano_dose_state) {
+      for (const auto & element : m_elements) {
+        element->set_use_nano_dose(true);
+      }
+    } else if (Qt::Unchecked == m_nano_dose_state) {
+      for (const auto & element : m_elements) {
+        element->set_use_nano_dose(false);
+      }
+    }
+  } else if (iodine_drops_setting == entry.key) {
+    m_p_iodine_element->set_drops(static_cast<size_t>(entry.value));
+  } else if (vanadium_drops_setting == entry.key) {
+    m_p_vanadium_element->set_drops(static_cast<size_t>(entry.value));
+  } else if (rubidium_frequency_setting == entry.key) {
+    m_p_rubidium_element->set_dosing_frequency(
+      static_cast<reef_moonshiners::RubidiumSelection>(static_cast<uint8_t>(entry.value)));
+  } else if (rubidium_start_date_setting == entry.key) {
+    m_p_rubidium_element->set_initial_dose_date(entry.date);
+  } else {
+    fprintf(stderr, "Warning: ignoring unknown setting '%s'\n", entry.key.c_str());
   }
-  m_p_rubidium_display->update_dosage(m_p_calendar->selectedDate());
-  _save();
 }
 
 void MainWindow::_activate_settings_window()
@@ -400,31 +633,17 @@ void MainWindow::_activate_about_window()
 
 void MainWindow::_update_refugium_state(int state)
 {
-  if (Qt::Checked == state) {
-    for (const auto & [element, display] : m_elements) {
-      element->set_multiplier(2.0);  /* this doubles the daily dose */
-    }
-  } else if (Qt::Unchecked == state) {
-    for (const auto & [element, display] : m_elements) {
-      element->set_multiplier(1.0);
-    }
-  }
-  m_refugium_state = state;
+  this->_record(
+    {reef_moonshiners::JournalEntryType::SET_SETTING, std::string{refugium_setting}, {},
+      static_cast<double>(state)});
   this->_refresh_elements();
 }
 
 void MainWindow::_update_nano_dose_state(int state)
 {
-  if (Qt::Checked == state) {
-    for (const auto & [element, display] : m_elements) {
-      element->set_use_nano_dose(true);  /* this doubles the daily dose */
-    }
-  } else if (Qt::Unchecked == state) {
-    for (const auto & [element, display] : m_elements) {
-      element->set_use_nano_dose(false);
-    }
-  }
-  m_nano_dose_state = state;
+  this->_record(
+    {reef_moonshiners::JournalEntryType::SET_SETTING, std::string{nano_dose_setting}, {},
+      static_cast<double>(state)});
   this->_refresh_elements();
 }
 
@@ -436,27 +655,34 @@ void MainWindow::_update_tank_size(const QString & text)
     /* TODO(allenh1): Add error message popup */
     return;
   }
-  reef_moonshiners::ElementBase::set_tank_size(
-    reef_moonshiners::gallons_to_liters(tank_size_gallons));
+  this->_record(
+    {reef_moonshiners::JournalEntryType::SET_SETTING, std::string{tank_volume_setting}, {},
+      reef_moonshiners::gallons_to_liters(tank_size_gallons)});
   /* update elements */
   this->_refresh_elements();
 }
 
 void MainWindow::_update_iodine_drops(int drops)
 {
-  m_p_iodine_element->set_drops(drops);
+  this->_record(
+    {reef_moonshiners::JournalEntryType::SET_SETTING, std::string{iodine_drops_setting}, {},
+      static_cast<double>(drops)});
   this->_refresh_elements();
 }
 
 void MainWindow::_update_vanadium_drops(int drops)
 {
-  m_p_vanadium_element->set_drops(drops);
+  this->_record(
+    {reef_moonshiners::JournalEntryType::SET_SETTING, std::string{vanadium_drops_setting}, {},
+      static_cast<double>(drops)});
   this->_refresh_elements();
 }
 
 void MainWindow::_update_rubidium_selection(reef_moonshiners::RubidiumSelection rubidium_selection)
 {
-  m_p_rubidium_element->set_dosing_frequency(rubidium_selection);
+  this->_record(
+    {reef_moonshiners::JournalEntryType::SET_SETTING, std::string{rubidium_frequency_setting}, {},
+      static_cast<double>(static_cast<uint8_t>(rubidium_selection))});
 }
 
 void MainWindow::_update_rubidium_start_date(QDate rubidium_start_date)
@@ -465,109 +691,233 @@ void MainWindow::_update_rubidium_start_date(QDate rubidium_start_date)
   rubidium_start_date.getDate(&year, &month, &day);
   const std::chrono::year_month_day date{
     std::chrono::year(year), std::chrono::month(month), std::chrono::day(day)};
-  m_p_rubidium_element->set_initial_dose_date(date);
+  this->_record(
+    {reef_moonshiners::JournalEntryType::SET_SETTING, std::string{rubidium_start_date_setting},
+      date, 0.0});
 }
 
 void MainWindow::_handle_next_icp_selection_window(
   reef_moonshiners::ui::icp_import_dialog::IcpSelection icp_selection)
 {
+  const auto providers = reef_moonshiners::get_icp_providers();
+  const auto index = static_cast<size_t>(icp_selection);
   switch (icp_selection) {
     case IcpSelection::ATI_ICP_OES:
+      m_p_icp_import_origin = m_p_ati_entry_window;
       m_p_active_icp_selection_window = m_p_ati_entry_window;
       this->_activate_icp_import_dialog();
       break;
     default:
-      exit(1);
+      /* exports are read from a file, then corrected as ATI analyses are */
+      if (index < providers.size() && providers[index]->is_file_based() &&
+        this->_import_icp_file(*providers[index]))
+      {
+        m_p_icp_import_origin = m_p_icp_selection_window;
+        this->_handle_ati_import_succeeded();
+      }
   }
 }
 
+bool MainWindow::_import_icp_file(const reef_moonshiners::IcpProvider & provider)
+{
+  const QString name = QString::fromUtf8(
+    provider.get_name().data(), static_cast<int>(provider.get_name().size()));
+  const QString path = QFileDialog::getOpenFileName(
+    this, tr("Import %1").arg(name), QString{},
+    tr("ICP reports (*.csv *.json *.txt);;All files (*)"));
+  if (path.isEmpty()) {
+    return false;
+  }
+  reef_moonshiners::MappedFile mapped;
+  reef_moonshiners::IcpReport report;
+  std::string error = "could not open the file";
+  if (!mapped.open(path.toStdString()) || !provider.parse(mapped.get_data(), report, error)) {
+    fprintf(
+      stderr, "Error: ICP import of '%s' failed: %s\n", path.toStdString().c_str(),
+      error.c_str());
+    QMessageBox::warning(
+      this, tr("Import %1").arg(name),
+      tr("Could not import the report: %1").arg(QString::fromStdString(error)));
+    return false;
+  }
+  for (const auto & unknown : report.unknown) {
+    fprintf(
+      stderr, "Warning: ignoring unknown element '%.*s' in the analysis\n",
+      static_cast<int>(unknown.size()), unknown.data());
+  }
+  QDate date = m_p_calendar->selectedDate();
+  if (report.collection_date) {
+    const auto & ymd = *report.collection_date;
+    date = QDate{
+      static_cast<int>(ymd.year()), static_cast<int>(static_cast<unsigned>(ymd.month())),
+      static_cast<int>(static_cast<unsigned>(ymd.day()))};
+  }
+  this->_apply_icp_results(date, report.results);
+  return true;
+}
+
 void MainWindow::_handle_back_ati_entry_window()
 {
+  /* going back abandons the import in progress */
+  if (m_p_ati_import) {
+    m_p_ati_import->cancel();
+    m_p_ati_import->deleteLater();
+    m_p_ati_entry_window->set_importing(false);
+  }
   m_p_active_icp_selection_window = m_p_icp_selection_window;
   this->_activate_icp_import_dialog();
 }
 
 void MainWindow::_handle_next_ati_entry_window(const QString & text, const QDate & date)
 {
-  QString url{"https://lab.atiaquaristik.com/publicAnalysis/"};
-  url += text;
-  /* connect to the host */
-  this->setDisabled(true);
-  QNetworkAccessManager manager;
-  manager.setTransferTimeout(10E3);  /* ten second timeout */
-  QNetworkReply * response = manager.get(QNetworkRequest(QUrl(url)));
-  QEventLoop event;
-  connect(response, SIGNAL(finished()), &event, SLOT(quit()));
-  event.exec();
-  if (QNetworkReply::NetworkError::NoError != response->error()) {
-    /* error in transfer */
-    this->setEnabled(true);
-    m_p_ati_entry_window->show_input_error_message();
-    return;
+  /* only one import drives the entry window at a time */
+  if (m_p_ati_import) {
+    m_p_ati_import->cancel();
+    m_p_ati_import->deleteLater();
   }
+  auto * import = new icp_import_dialog::ATIImport(m_p_network, text, date, this);
+  import->set_cache(m_p_icp_cache);
+  m_p_ati_import = import;
+  QObject::connect(
+    import, &icp_import_dialog::ATIImport::progress,
+    m_p_ati_entry_window, &icp_import_dialog::ATIEntryWindow::set_progress);
+  QObject::connect(
+    import, &icp_import_dialog::ATIImport::succeeded, this,
+    [this, import](
+      const QDate & collection_date, const IcpResults & results) {
+      import->deleteLater();
+      this->_apply_icp_results(collection_date, results);
+      if (import == m_p_ati_import) {
+        this->_handle_ati_import_succeeded();
+      }
+    });
+  QObject::connect(
+    import, &icp_import_dialog::ATIImport::failed, this,
+    [this, import](const QString & reason) {
+      import->deleteLater();
+      fprintf(stderr, "Error: ICP import failed: %s\n", reason.toStdString().c_str());
+      if (import == m_p_ati_import) {
+        m_p_ati_entry_window->set_importing(false);
+        m_p_ati_entry_window->show_input_error_message();
+      }
+    });
   m_p_ati_entry_window->hide_input_error_message();
-  // Source should be stored here
-  QString html{response->readAll()};
-  /* find the data table */
-  auto idx = html.indexOf("var dataTable");
-  if (idx < 0) {
-    fprintf(stderr, "data table not found\n");
-    return;
-  }
-  /* truncate */
-  html = html.sliced(idx);
-  /* find start of relevant data */
-  idx = html.indexOf("\"0\":");
-  if (idx < 0) {
-    fprintf(stderr, "zero section not found\n");
-    return;
+  m_p_ati_entry_window->set_importing(true);
+  import->start();
+}
+
+void MainWindow::_handle_batch_ati_entry_window()
+{
+  m_p_icp_import_origin = m_p_ati_batch_entry_window;
+  m_p_active_icp_selection_window = m_p_ati_batch_entry_window;
+  this->_activate_icp_import_dialog();
+}
+
+void MainWindow::_handle_back_ati_batch_entry_window()
+{
+  /* going back abandons the import in progress */
+  if (m_p_ati_batch_import) {
+    m_p_ati_batch_import->cancel();
+    m_p_ati_batch_import->deleteLater();
+    m_p_ati_batch_entry_window->set_importing(false);
   }
-  html = QString("{") + html.sliced(idx);
-  /* find end of the table */
-  idx = html.indexOf("tank:");
-  /* truncate */
-  html = html.sliced(0, idx);
-  html = html.sliced(0, html.lastIndexOf(','));
-  /* parse as JSON */
-  QJsonParseError err{QJsonParseError::NoError};
-  QJsonDocument parsed = QJsonDocument::fromJson(html.toUtf8(), &err);
-  if (QJsonParseError::ParseError::NoError != err.error) {
-    fprintf(stderr, "Error parsing JSON: '%s'\n", err.errorString().toStdString().c_str());
-    fprintf(stderr, "text: '%s'\n", html.toStdString().c_str());
-    return;
+  m_p_icp_import_origin = m_p_ati_entry_window;
+  m_p_active_icp_selection_window = m_p_ati_entry_window;
+  this->_activate_icp_import_dialog();
+}
+
+void MainWindow::_handle_import_ati_batch_entry_window(
+  const QStringList & analysis_ids, const QList<QDate> & collection_dates)
+{
+  if (m_p_ati_batch_import) {
+    m_p_ati_batch_import->cancel();
+    m_p_ati_batch_import->deleteLater();
   }
-  std::unordered_map<std::string, double> values;
-  for (size_t x = 0; x < 43; ++x) {
-    double scale = 1.0;
-    if (parsed[QString().setNum(x)]["element"]["units_id"].toInt() == 2) {
-      scale = 1E3;  /* mg / L -> ug / L */
-    }
-    values[parsed[QString().setNum(x)]["element"]["description_en"].toString().toStdString()] =
-      parsed[QString().setNum(x)]["elements_value"].toDouble() * scale;
+  std::vector<icp_import_dialog::ATIBatchImport::Entry> entries;
+  for (int x = 0; x < analysis_ids.size(); ++x) {
+    entries.push_back({analysis_ids[x], collection_dates[x]});
   }
+  auto * import = new icp_import_dialog::ATIBatchImport(m_p_network, std::move(entries), this);
+  import->set_cache(m_p_icp_cache);
+  m_p_ati_batch_import = import;
+  /* reasons are collected, so one message lists every analysis that failed */
+  auto failures = std::make_shared<QStringList>();
+  QObject::connect(
+    import, &icp_import_dialog::ATIBatchImport::succeeded,
+    this, &MainWindow::_apply_icp_results);
+  QObject::connect(
+    import, &icp_import_dialog::ATIBatchImport::failed, this,
+    [failures](const QString & analysis_id, const QString & reason) {
+      fprintf(
+        stderr, "Error: ICP import of '%s' failed: %s\n", analysis_id.toStdString().c_str(),
+        reason.toStdString().c_str());
+      failures->push_back(analysis_id);
+    });
+  QObject::connect(
+    import, &icp_import_dialog::ATIBatchImport::finished, this,
+    [this, import, failures](int imported, int total) {
+      import->deleteLater();
+      if (import != m_p_ati_batch_import) {
+        return;
+      }
+      m_p_ati_batch_entry_window->set_importing(false);
+      if (imported < total) {
+        m_p_ati_batch_entry_window->set_error_message(
+          tr("Imported %1 of %2 analyses. Verify these IDs, and try again: %3")
+          .arg(imported).arg(total).arg(failures->join(", ")));
+      }
+      if (imported == total) {
+        this->_handle_ati_import_succeeded();
+      }
+    });
+  m_p_ati_batch_entry_window->set_error_message(QString{});
+  m_p_ati_batch_entry_window->set_importing(true);
+  import->start();
+}
+
+void MainWindow::_apply_icp_results(
+  const QDate & date, const IcpResults & results)
+{
   int year, month, day;
   date.getDate(&year, &month, &day);
   const std::chrono::year_month_day date_of_sample{
     std::chrono::year(year), std::chrono::month(month), std::chrono::day(day)};
-  for (auto &[element, display] : m_correction_elements) {
-    /* set concentration */
-    element->set_concentration(values[element->get_name()], date_of_sample);
+  std::string missing;
+  const auto record = [&](const reef_moonshiners::ElementBase & element) {
+      /* elements missing from the analysis keep their last measurement */
+      const IcpElement id = element.get_icp_element();
+      if (!results.contains(id)) {
+        missing += (missing.empty() ? "" : ", ") + element.get_name();
+        return;
+      }
+      this->_record(
+        {reef_moonshiners::JournalEntryType::SET_CONCENTRATION, element.get_name(),
+          date_of_sample, results.get(id)});
+    };
+  for (auto & element : m_correction_elements) {
+    record(*element);
   }
-  for (auto &[element, display] : m_dropper_elements) {
-    /* set concentration */
-    element->set_concentration(values[element->get_name()], date_of_sample);
+  for (auto & element : m_dropper_elements) {
+    record(*element);
   }
-  for (auto &[element, display] : m_elements) {
-    /* set concentration */
-    element->set_concentration(values[element->get_name()], date_of_sample);
+  for (auto & element : m_elements) {
+    record(*element);
   }
+  if (!missing.empty()) {
+    fprintf(stderr, "Warning: the analysis has no results for %s\n", missing.c_str());
+  }
+}
+
+void MainWindow::_handle_ati_import_succeeded()
+{
+  m_p_ati_entry_window->set_importing(false);
+  m_p_ati_entry_window->hide_input_error_message();
   /* handle iodine */
   m_p_active_icp_selection_window = m_p_ati_correction_start_window;
   m_p_ati_correction_start_window->set_iodine_increase(m_p_iodine_element->is_low());
   m_p_ati_correction_start_window->set_iodine_decrease(m_p_iodine_element->is_high());
   m_p_ati_correction_start_window->set_vanadium_increase(m_p_vanadium_element->is_low());
   m_p_ati_correction_start_window->set_vanadium_decrease(m_p_vanadium_element->is_high());
-  this->setEnabled(true);
   this->_activate_icp_import_dialog();
 }
 
@@ -577,10 +927,11 @@ void MainWindow::_handle_okay_ati_correction_start_window(const QDate & date)
   date.getDate(&year, &month, &day);
   const std::chrono::year_month_day start_date{
     std::chrono::year(year), std::chrono::month(month), std::chrono::day(day)};
-  for (auto &[element, display] : m_correction_elements) {
+  for (auto & element : m_correction_elements) {
     /* set concentration */
-    (void)display;
-    element->set_correction_start_date(start_date);
+    this->_record(
+      {reef_moonshiners::JournalEntryType::SET_CORRECTION_START_DATE, element->get_name(),
+        start_date, 0.0});
   }
   m_p_active_icp_selection_window = nullptr;
   this->_activate_calendar_window();
@@ -588,7 +939,9 @@ void MainWindow::_handle_okay_ati_correction_start_window(const QDate & date)
 
 void MainWindow::_handle_back_ati_correction_start_window()
 {
-  m_p_active_icp_selection_window = m_p_ati_entry_window;
+  /* return to whichever window the analysis was imported from */
+  m_p_active_icp_selection_window = (nullptr != m_p_icp_import_origin) ?
+    m_p_icp_import_origin : m_p_ati_entry_window;
   this->_activate_icp_import_dialog();
 }
 
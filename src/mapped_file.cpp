@@ -0,0 +1,259 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/mapped_file.hpp>
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define REEF_MOONSHINERS_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+#ifdef REEF_MOONSHINERS_HAVE_MMAP
+/**
+ * Write a file and wait for its contents to reach the disk
+ */
+bool write_synced(const std::filesystem::path & path, std::string_view bytes)
+{
+  const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  while (!bytes.empty()) {
+    const ssize_t written = ::write(fd, bytes.data(), bytes.size());
+    if (written < 0 && EINTR == errno) {
+      continue;
+    } else if (written < 0) {
+      ::close(fd);
+      return false;
+    }
+    bytes.remove_prefix(static_cast<size_t>(written));
+  }
+  const bool synced = (0 == ::fsync(fd));
+  return (0 == ::close(fd)) && synced;
+}
+
+/**
+ * Wait for the entries of a directory, such as a rename, to reach the disk
+ */
+bool sync_directory(const std::filesystem::path & directory)
+{
+  const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  const bool synced = (0 == ::fsync(fd));
+  ::close(fd);
+  return synced;
+}
+#else
+bool write_synced(const std::filesystem::path & path, std::string_view bytes)
+{
+  /* without fsync, flushing to the OS is the best we can do */
+  std::ofstream file{path, std::ios::binary};
+  file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  return static_cast<bool>(file.flush());
+}
+
+bool sync_directory(const std::filesystem::path &)
+{
+  return true;
+}
+#endif
+
+}  // namespace
+
+namespace reef_moonshiners
+{
+
+MappedFile::~MappedFile()
+{
+  this->close();
+}
+
+MappedFile::MappedFile(MappedFile && other) noexcept
+{
+  *this = std::move(other);
+}
+
+MappedFile & MappedFile::operator=(MappedFile && other) noexcept
+{
+  if (this != &other) {
+    this->close();
+    m_buffer = std::move(other.m_buffer);
+    m_data = other.m_mapped ? other.m_data : m_buffer.data();
+    m_size = other.m_size;
+    m_open = other.m_open;
+    m_mapped = other.m_mapped;
+    other.m_data = nullptr;
+    other.m_size = 0;
+    other.m_open = false;
+    other.m_mapped = false;
+  }
+  return *this;
+}
+
+bool MappedFile::open(const std::filesystem::path & path)
+{
+  this->close();
+#ifdef REEF_MOONSHINERS_HAVE_MMAP
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (0 != ::fstat(fd, &info)) {
+    ::close(fd);
+    return false;
+  }
+  m_size = static_cast<size_t>(info.st_size);
+  if (m_size > 0) {
+    void * data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED != data) {
+      m_data = static_cast<const char *>(data);
+      m_mapped = true;
+    }
+  }
+  ::close(fd);  /* the mapping keeps the file alive */
+  if (m_mapped || 0 == m_size) {
+    m_open = true;
+    return true;
+  }
+#endif
+  /* no mmap, read it all at once */
+  std::ifstream file{path, std::ios::binary | std::ios::ate};
+  if (!file) {
+    return false;
+  }
+  m_buffer.resize(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(m_buffer.data(), m_buffer.size());
+  if (!file) {
+    m_buffer.clear();
+    return false;
+  }
+  m_data = m_buffer.data();
+  m_size = m_buffer.size();
+  m_open = true;
+  return true;
+}
+
+void MappedFile::close()
+{
+#ifdef REEF_MOONSHINERS_HAVE_MMAP
+  if (m_mapped) {
+    ::munmap(const_cast<char *>(m_data), m_size);
+  }
+#endif
+  m_buffer.clear();
+  m_data = nullptr;
+  m_size = 0;
+  m_open = false;
+  m_mapped = false;
+}
+
+bool MappedFile::is_open() const
+{
+  return m_open;
+}
+
+bool MappedFile::is_mapped() const
+{
+  return m_mapped;
+}
+
+std::string_view MappedFile::get_data() const
+{
+  return std::string_view{m_data, m_size};
+}
+
+MemoryStreamBuffer::MemoryStreamBuffer(std::string_view data)
+{
+  /* the get area never writes, despite the non-const pointers */
+  char * begin = const_cast<char *>(data.data());
+  this->setg(begin, begin, begin + data.size());
+}
+
+MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekoff(
+  off_type offset, std::ios_base::seekdir direction,
+  std::ios_base::openmode mode)
+{
+  if (!(mode & std::ios_base::in)) {
+    return pos_type(off_type(-1));
+  }
+  off_type base = 0;
+  if (std::ios_base::cur == direction) {
+    base = this->gptr() - this->eback();
+  } else if (std::ios_base::end == direction) {
+    base = this->egptr() - this->eback();
+  }
+  const off_type position = base + offset;
+  if (position < 0 || position > this->egptr() - this->eback()) {
+    return pos_type(off_type(-1));
+  }
+  this->setg(this->eback(), this->eback() + position, this->egptr());
+  return pos_type(position);
+}
+
+MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekpos(
+  pos_type position,
+  std::ios_base::openmode mode)
+{
+  return this->seekoff(off_type(position), std::ios_base::beg, mode);
+}
+
+MemoryStream::MemoryStream(std::string_view data)
+: std::istream(nullptr),
+  m_buffer(data)
+{
+  this->rdbuf(&m_buffer);
+}
+
+bool replace_file(const std::filesystem::path & path, std::string_view bytes)
+{
+  std::error_code error;
+  std::filesystem::create_directories(path.parent_path(), error);  /* create if not exists */
+  std::filesystem::path temporary = path;
+  temporary += ".tmp";
+  /* the contents must be on disk before the rename can expose them */
+  if (!write_synced(temporary, bytes)) {
+    fprintf(stderr, "Error: could not write '%s'\n", temporary.string().c_str());
+    return false;
+  }
+  std::filesystem::rename(temporary, path, error);
+  if (error) {
+    fprintf(stderr, "Error: could not replace '%s'\n", path.string().c_str());
+    return false;
+  }
+  /* and the rename must be on disk before callers drop what it replaced */
+  const std::filesystem::path directory = path.has_parent_path() ? path.parent_path() : ".";
+  if (!sync_directory(directory)) {
+    fprintf(stderr, "Error: could not sync '%s'\n", directory.string().c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace reef_moonshiners
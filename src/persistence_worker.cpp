@@ -0,0 +1,157 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/persistence_worker.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+namespace reef_moonshiners
+{
+
+PersistenceWorker::PersistenceWorker(
+  Journal journal, SnapshotWriter writer,
+  const std::chrono::milliseconds window,
+  SnapshotRequest request)
+: m_journal(std::move(journal)),
+  m_writer(std::move(writer)),
+  m_request(std::move(request)),
+  m_window(window),
+  m_thread(&PersistenceWorker::_run, this)
+{
+}
+
+PersistenceWorker::~PersistenceWorker()
+{
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_stopping = true;
+  }
+  m_wake.notify_all();
+  m_thread.join();
+}
+
+void PersistenceWorker::append(JournalEntry entry)
+{
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    /* a later entry for the same thing supersedes one still waiting, up to a snapshot */
+    for (auto it = m_pending.rbegin(); it != m_pending.rend() && !it->is_snapshot; ++it) {
+      if (it->entry.type == entry.type && it->entry.key == entry.key &&
+        it->entry.date == entry.date)
+      {
+        m_pending.erase(std::next(it).base());
+        break;
+      }
+    }
+    m_pending.push_back(Task{false, std::move(entry), {}});
+    m_last_submit = std::chrono::steady_clock::now();
+  }
+  m_wake.notify_all();
+}
+
+void PersistenceWorker::save(std::string snapshot)
+{
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    /* entries stay queued, in case this snapshot fails to write */
+    std::erase_if(m_pending, [](const Task & task) {return task.is_snapshot;});
+    m_pending.push_back(Task{true, {}, std::move(snapshot)});
+    m_last_submit = std::chrono::steady_clock::now();
+  }
+  m_wake.notify_all();
+}
+
+void PersistenceWorker::flush()
+{
+  std::unique_lock<std::mutex> lock{m_mutex};
+  ++m_flushes;
+  m_wake.notify_all();
+  m_drained.wait(lock, [this] {return m_pending.empty() && !m_writing;});
+  --m_flushes;
+}
+
+size_t PersistenceWorker::get_snapshot_count() const
+{
+  std::lock_guard<std::mutex> lock{m_mutex};
+  return m_snapshots;
+}
+
+size_t PersistenceWorker::get_append_failure_count() const
+{
+  std::lock_guard<std::mutex> lock{m_mutex};
+  return m_append_failures;
+}
+
+void PersistenceWorker::_run()
+{
+  std::unique_lock<std::mutex> lock{m_mutex};
+  for (;; ) {
+    m_wake.wait(lock, [this] {return m_stopping || !m_pending.empty();});
+    if (m_pending.empty()) {
+      break;  /* stopping, with nothing left to write */
+    }
+    /* wait for the edits to settle */
+    while (!m_stopping && 0 == m_flushes) {
+      const auto deadline = m_last_submit + m_window;
+      if (std::chrono::steady_clock::now() >= deadline) {
+        break;
+      }
+      m_wake.wait_until(lock, deadline);
+    }
+    std::vector<Task> tasks;
+    tasks.swap(m_pending);
+    m_writing = true;
+    lock.unlock();
+    this->_write(tasks);
+    lock.lock();
+    m_writing = false;
+    if (m_pending.empty()) {
+      m_drained.notify_all();
+    }
+  }
+  m_drained.notify_all();
+}
+
+void PersistenceWorker::_write(std::vector<Task> & tasks)
+{
+  /* true while an entry is neither journaled nor part of a written snapshot */
+  bool unsaved = false;
+  for (const Task & task : tasks) {
+    if (!task.is_snapshot) {
+      if (!m_journal.append(task.entry)) {
+        unsaved = true;
+        std::lock_guard<std::mutex> lock{m_mutex};
+        ++m_append_failures;
+      }
+    } else if (m_writer(task.snapshot)) {
+      /* the snapshot holds everything journaled so far */
+      m_journal.clear();
+      unsaved = false;
+      std::lock_guard<std::mutex> lock{m_mutex};
+      ++m_snapshots;
+    } else {
+      fprintf(stderr, "Error: could not write snapshot, keeping the journal\n");
+    }
+  }
+  if (unsaved) {
+    fprintf(stderr, "Error: could not journal a change, requesting a snapshot\n");
+    if (m_request) {
+      m_request();
+    }
+  }
+}
+
+}  // namespace reef_moonshiners
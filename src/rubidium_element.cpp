@@ -14,6 +14,8 @@
 
 #include <reef_moonshiners/rubidium_element.hpp>
 
+#include <algorithm>
+
 namespace reef_moonshiners
 {
 
@@ -24,7 +26,12 @@ Rubidium::Rubidium()
 
 double Rubidium::get_target_concentration() const
 {
-  switch (m_dosing_frequency) {
+  return _get_target_concentration(m_dosing_frequency);
+}
+
+double Rubidium::_get_target_concentration(const RubidiumSelection selection) const
+{
+  switch (selection) {
     case RubidiumSelection::DAILY:
       return m_daily_concentration;
     case RubidiumSelection::MONTHLY:
@@ -40,6 +47,7 @@ double Rubidium::get_target_concentration() const
 void Rubidium::set_dosing_frequency(RubidiumSelection _dosing_frequency)
 {
   m_dosing_frequency = _dosing_frequency;
+  _bump_generation();
 }
 
 RubidiumSelection Rubidium::get_dosing_frequency() const
@@ -50,6 +58,7 @@ RubidiumSelection Rubidium::get_dosing_frequency() const
 void Rubidium::set_initial_dose_date(const std::chrono::year_month_day & date)
 {
   m_initial_rubidium_dose_date = date;
+  _bump_generation();
 }
 
 std::chrono::year_month_day Rubidium::get_initial_dose_date() const
@@ -57,51 +66,112 @@ std::chrono::year_month_day Rubidium::get_initial_dose_date() const
   return m_initial_rubidium_dose_date;
 }
 
-double Rubidium::get_dose(const std::chrono::year_month_day & date) const
+std::optional<RubidiumSelection> Rubidium::_get_dose_selection(
+  const std::chrono::year_month_day & date) const
 {
-  double dose = 0.0;
+  if (RubidiumSelection::INITIAL == m_dosing_frequency) {
+    /* not a dosing frequency, nothing is scheduled */
+    return std::nullopt;
+  } else if (date == m_initial_rubidium_dose_date) {
+    return RubidiumSelection::INITIAL;
+  }
   switch (m_dosing_frequency) {
     case RubidiumSelection::DAILY:
-      /* we are just a normal daily element, unless it's the initial date */
-      if (date == m_initial_rubidium_dose_date) {
-        /* temporarily swap the dosing frequency */
-        m_dosing_frequency = RubidiumSelection::INITIAL;
-        dose = this->DailyElement::get_dose(date);
-        m_dosing_frequency = RubidiumSelection::DAILY;
-      } else {
-        dose = this->DailyElement::get_dose(date);
+      return RubidiumSelection::DAILY;
+    case RubidiumSelection::MONTHLY:
+      if (date.day() == m_initial_rubidium_dose_date.day()) {
+        return RubidiumSelection::MONTHLY;
+      }
+      break;
+    case RubidiumSelection::QUARTERLY:
+      /* your days are fixed on the start of the quarter */
+      if (date.day() == std::chrono::day(1) &&
+        ((static_cast<unsigned>(date.month()) - 1) % 3 == 0))
+      {
+        return RubidiumSelection::QUARTERLY;
+      }
+      break;
+    case RubidiumSelection::INITIAL:
+      break;
+  }
+  return std::nullopt;
+}
+
+double Rubidium::get_dose(const std::chrono::year_month_day & date) const
+{
+  const auto selection = _get_dose_selection(date);
+  if (!selection) {
+    return 0.0;
+  }
+  return this->_get_dose_for_target(_get_target_concentration(*selection));
+}
+
+std::vector<double> Rubidium::get_doses(
+  const std::chrono::year_month_day & start,
+  const std::chrono::year_month_day & end) const
+{
+  const std::chrono::days days = std::chrono::sys_days{end} - std::chrono::sys_days{start};
+  if (days.count() <= 0) {
+    return {};
+  }
+  std::vector<double> doses(static_cast<size_t>(days.count()));
+  this->fill_doses(start, doses);
+  return doses;
+}
+
+void Rubidium::fill_doses(
+  const std::chrono::year_month_day & start,
+  std::span<double> doses) const
+{
+  std::fill(doses.begin(), doses.end(), 0.0);
+  if (doses.empty() || RubidiumSelection::INITIAL == m_dosing_frequency) {
+    return;
+  }
+  const std::chrono::sys_days first{start};
+  const std::chrono::sys_days last = first + std::chrono::days(doses.size());
+  const std::chrono::year_month_day end{last};
+  const double dose = this->_get_dose_for_target(_get_target_concentration(m_dosing_frequency));
+  const auto set_dose = [&](const std::chrono::year_month_day & date, const double amount) {
+      if (!date.ok()) {
+        return;
+      }
+      const std::chrono::sys_days day{date};
+      if (first <= day && day < last) {
+        doses[static_cast<size_t>((day - first).count())] = amount;
       }
+    };
+  /* the two amounts are computed once, and only the dose days are visited */
+  const std::chrono::year_month first_month{start.year(), start.month()};
+  const std::chrono::year_month last_month{end.year(), end.month()};
+  switch (m_dosing_frequency) {
+    case RubidiumSelection::DAILY:
+      std::fill(doses.begin(), doses.end(), dose);
       break;
     case RubidiumSelection::MONTHLY:
-      if (date == m_initial_rubidium_dose_date) {
-        m_dosing_frequency = RubidiumSelection::INITIAL;
-        dose = this->DailyElement::get_dose(date);
-        m_dosing_frequency = RubidiumSelection::MONTHLY;
-      } else if (date.day() == m_initial_rubidium_dose_date.day()) {
-        dose = this->DailyElement::get_dose(date);
+      for (auto month = first_month; month <= last_month; month += std::chrono::months(1)) {
+        set_dose(month / m_initial_rubidium_dose_date.day(), dose);
       }
       break;
     case RubidiumSelection::QUARTERLY:
-      {
-        /* your days are fixed on the start of the quarter */
-        if (date == m_initial_rubidium_dose_date) {
-          m_dosing_frequency = RubidiumSelection::INITIAL;
-          dose = this->DailyElement::get_dose(date);
-          m_dosing_frequency = RubidiumSelection::QUARTERLY;
-        } else if (date.day() == std::chrono::day(1) && date.month() == std::chrono::January) {
-          dose = this->DailyElement::get_dose(date);
-        } else if (date.day() == std::chrono::day(1) && date.month() == std::chrono::April) {
-          dose = this->DailyElement::get_dose(date);
-        } else if (date.day() == std::chrono::day(1) && date.month() == std::chrono::July) {
-          dose = this->DailyElement::get_dose(date);
-        } else if (date.day() == std::chrono::day(1) && date.month() == std::chrono::October) {
-          dose = this->DailyElement::get_dose(date);
+      for (auto month = first_month; month <= last_month; month += std::chrono::months(1)) {
+        if ((static_cast<unsigned>(month.month()) - 1) % 3 == 0) {
+          set_dose(month / std::chrono::day(1), dose);
         }
       }
+      break;
     case RubidiumSelection::INITIAL:
       break;
   }
-  return dose;
+  /* the initial dose replaces whatever else was scheduled that day */
+  set_dose(
+    m_initial_rubidium_dose_date,
+    this->_get_dose_for_target(_get_target_concentration(RubidiumSelection::INITIAL)));
+}
+
+bool Rubidium::is_same_dose_every_day() const
+{
+  /* even daily doses differ on the initial dose date */
+  return false;
 }
 
 void Rubidium::write_to(std::ostream & stream) const
@@ -114,7 +184,7 @@ void Rubidium::write_to(std::ostream & stream) const
 void Rubidium::read_from(std::istream & stream)
 {
   this->DailyElement::read_from(stream);
-  uint8_t freq;
+  uint8_t freq = static_cast<uint8_t>(m_dosing_frequency);
   binary_in(stream, freq);
   m_dosing_frequency = static_cast<RubidiumSelection>(freq);
   binary_in(stream, m_initial_rubidium_dose_date);
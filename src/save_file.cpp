@@ -0,0 +1,163 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/save_file.hpp>
+#include <reef_moonshiners/binary_io.hpp>
+#include <reef_moonshiners/mapped_file.hpp>
+
+#include <cstdio>
+
+namespace reef_moonshiners
+{
+
+std::ostream & SaveFile::add_section(const std::string & name)
+{
+  std::ostringstream & section = m_pending[name];
+  section.str({});
+  section.clear();
+  return section;
+}
+
+void SaveFile::write_to(std::ostream & stream) const
+{
+  /* the table's size is known up front, so offsets can be written in one pass */
+  uint64_t offset = sizeof(uint32_t);
+  for (const auto & [name, data] : m_pending) {
+    (void)data;
+    offset += sizeof(uint64_t) + name.size() + 2 * sizeof(uint64_t);
+  }
+  binary_out(stream, static_cast<uint32_t>(m_pending.size()));
+  std::vector<std::string> sections;
+  sections.reserve(m_pending.size());
+  for (const auto & [name, data] : m_pending) {
+    sections.push_back(data.str());
+    const uint64_t size = sections.back().size();
+    binary_out(stream, static_cast<uint64_t>(name.size()));
+    stream.write(name.data(), name.size());
+    binary_out(stream, offset);
+    binary_out(stream, size);
+    offset += size;
+  }
+  for (const auto & section : sections) {
+    stream.write(section.data(), section.size());
+  }
+}
+
+bool SaveFile::read_from(std::string_view bytes)
+{
+  MemoryStream stream{bytes};
+  if (!this->read_from(stream)) {
+    return false;
+  }
+  m_bytes = bytes;
+  return true;
+}
+
+std::string_view SaveFile::get_section(const std::string & name) const
+{
+  const auto it = m_sections.find(name);
+  if (it == m_sections.end()) {
+    return {};
+  }
+  return m_bytes.substr(it->second.offset, it->second.size);
+}
+
+bool SaveFile::read_from(std::istream & stream)
+{
+  m_sections.clear();
+  m_bytes = {};
+  m_base = stream.tellg();
+  stream.seekg(0, std::ios::end);
+  const std::streamoff end = stream.tellg();
+  stream.seekg(m_base);
+  if (!stream || end < m_base) {
+    fprintf(stderr, "Error: save file could not be read\n");
+    return false;
+  }
+  const auto length = static_cast<uint64_t>(end - m_base);
+
+  uint32_t count = 0;
+  binary_in(stream, count);
+  for (uint32_t x = 0; x < count && stream; ++x) {
+    uint64_t name_length = 0;
+    binary_in(stream, name_length);
+    if (!stream || name_length > max_name_length) {
+      break;
+    }
+    std::string name(name_length, '\0');
+    stream.read(name.data(), name_length);
+    Section section;
+    binary_in(stream, section.offset);
+    binary_in(stream, section.size);
+    if (!stream || section.offset > length || section.size > length - section.offset) {
+      fprintf(stderr, "Error: save file section '%s' is out of bounds\n", name.c_str());
+      m_sections.clear();
+      return false;
+    }
+    m_sections[name] = section;
+  }
+  if (!stream || m_sections.size() != count) {
+    fprintf(stderr, "Error: save file section table is malformed\n");
+    m_sections.clear();
+    return false;
+  }
+  return true;
+}
+
+bool SaveFile::contains(const std::string & name) const
+{
+  return m_sections.contains(name);
+}
+
+std::vector<std::string> SaveFile::get_section_names() const
+{
+  std::vector<std::string> names;
+  names.reserve(m_sections.size());
+  for (const auto & [name, section] : m_sections) {
+    (void)section;
+    names.push_back(name);
+  }
+  return names;
+}
+
+uint64_t SaveFile::get_section_size(const std::string & name) const
+{
+  const auto it = m_sections.find(name);
+  return (it == m_sections.end()) ? 0 : it->second.size;
+}
+
+bool SaveFile::seek(std::istream & stream, const std::string & name) const
+{
+  const auto it = m_sections.find(name);
+  if (it == m_sections.end()) {
+    return false;
+  }
+  stream.clear();
+  stream.seekg(m_base + static_cast<std::streamoff>(it->second.offset));
+  return static_cast<bool>(stream);
+}
+
+bool SaveFile::read_section(
+  std::istream & stream, const std::string & name,
+  std::string & data) const
+{
+  if (!this->seek(stream, name)) {
+    return false;
+  }
+  data.resize(m_sections.at(name).size);
+  stream.read(data.data(), data.size());
+  return static_cast<bool>(stream);
+}
+
+}  // namespace reef_moonshiners
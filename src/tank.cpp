@@ -0,0 +1,47 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <reef_moonshiners/tank.hpp>
+
+namespace reef_moonshiners
+{
+
+Tank::Tank(const double _volume)
+: m_volume(_volume)
+{
+}
+
+double Tank::get_volume() const
+{
+  return m_volume;
+}
+
+void Tank::set_volume(const double _volume)
+{
+  m_volume = _volume;
+  ++m_generation;
+}
+
+uint64_t Tank::get_generation() const
+{
+  return m_generation;
+}
+
+const std::shared_ptr<Tank> & Tank::get_default()
+{
+  static const std::shared_ptr<Tank> default_tank = std::make_shared<Tank>();
+  return default_tank;
+}
+
+}  // namespace reef_moonshiners
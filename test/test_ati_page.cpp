@@ -0,0 +1,145 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <reef_moonshiners/ati_page.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+std::string make_entry(
+  const size_t index, const std::string & name, const int units_id,
+  const std::string & value)
+{
+  const std::string key = std::to_string(index);
+  return "\"" + key + "\": {\"id\": " + std::to_string(9000 + index) +
+         ", \"element\": {\"id\": " + key + ", \"symbol\": \"" + name.substr(0, 2) +
+         "\", \"description_en\": \"" + name + "\", \"description_de\": \"" + name +
+         "\\u00e4\", \"units_id\": " + std::to_string(units_id) +
+         ", \"limits\": [0.5, {\"low\": null, \"high\": 1e3}], \"visible\": true}" +
+         ", \"elements_value\": " + value + ", \"comment\": \"say \\\"hi\\\"\"},\n";
+}
+
+std::string make_page(const std::string & entries)
+{
+  return "<html><head><script src=\"/js/app.js\"></script></head><body>\n"
+         "<div id=\"analysis\"></div>\n<script>\n"
+         "  var dataTable = new AnalysisTable({\n" + entries +
+         "    tank: {\"name\": \"Display\", \"volume\": 450},\n"
+         "    chart: true\n"
+         "  });\n"
+         "</script></body></html>\n";
+}
+
+}  // namespace
+
+TEST(TestAtiPage, test_scan)
+{
+  std::string entries;
+  entries += make_entry(0, "Sodium", 2, "10932.5");
+  entries += make_entry(1, "Zinc", 1, "3.25");
+  entries += make_entry(2, "Iron", 1, "\"0.8\"");
+  entries += make_entry(3, "Lithium", 1, "null");
+  entries += make_entry(4, "Potassium", 2, "412");
+  const std::string page = make_page(entries);
+
+  reef_moonshiners::AtiPage scanned;
+  std::string error;
+  ASSERT_TRUE(scanned.scan(page, error)) << error;
+  const auto measurements = scanned.get_measurements();
+  ASSERT_EQ(measurements.size(), 4u);
+  EXPECT_EQ(measurements[0].name, "Sodium");
+  EXPECT_DOUBLE_EQ(measurements[0].value, 10932.5E3);
+  EXPECT_EQ(measurements[1].name, "Zinc");
+  EXPECT_DOUBLE_EQ(measurements[1].value, 3.25);
+  EXPECT_EQ(measurements[2].name, "Iron");
+  EXPECT_DOUBLE_EQ(measurements[2].value, 0.8);
+  /* Lithium was not measured */
+  EXPECT_EQ(measurements[3].name, "Potassium");
+  EXPECT_DOUBLE_EQ(measurements[3].value, 412E3);
+  /* names view the page */
+  EXPECT_GE(measurements[1].name.data(), page.data());
+  EXPECT_LT(measurements[1].name.data(), page.data() + page.size());
+
+  reef_moonshiners::IcpResults results;
+  ASSERT_TRUE(reef_moonshiners::parse_ati_page(page, results, error));
+  EXPECT_EQ(results.size(), 4u);
+  EXPECT_DOUBLE_EQ(results.get(reef_moonshiners::IcpElement::ZINC), 3.25);
+  EXPECT_FALSE(results.contains(reef_moonshiners::IcpElement::LITHIUM));
+
+  /* other spellings resolve, and names that are not elements are reported */
+  const std::string other_page =
+    make_page(make_entry(0, "Chloride", 1, "1.0") + make_entry(1, "ZN", 1, "2.0"));
+  ASSERT_TRUE(scanned.scan(other_page, error));
+  std::vector<std::string_view> unknown;
+  scanned.get_results(results, unknown);
+  EXPECT_EQ(results.size(), 1u);
+  EXPECT_DOUBLE_EQ(results.get(reef_moonshiners::IcpElement::ZINC), 2.0);
+  EXPECT_EQ(unknown, (std::vector<std::string_view>{"Chloride"}));
+}
+
+TEST(TestAtiPage, test_any_number_of_entries)
+{
+  for (const size_t count : {1u, 43u, 60u}) {
+    std::string entries;
+    for (size_t x = 0; x < count; ++x) {
+      entries += make_entry(x, "Element" + std::to_string(x), 1, std::to_string(x) + ".5");
+    }
+    reef_moonshiners::AtiPage scanned;
+    std::string error;
+    ASSERT_TRUE(scanned.scan(make_page(entries), error)) << error;
+    ASSERT_EQ(scanned.get_measurements().size(), count);
+    EXPECT_DOUBLE_EQ(scanned.get_measurements().back().value, (count - 1) + 0.5);
+  }
+
+  std::string entries;
+  for (size_t x = 0; x <= reef_moonshiners::AtiPage::max_measurements; ++x) {
+    entries += make_entry(x, "Element", 1, "1.0");
+  }
+  reef_moonshiners::AtiPage scanned;
+  std::string error;
+  EXPECT_FALSE(scanned.scan(make_page(entries), error));
+  EXPECT_EQ(error, "too many results");
+}
+
+TEST(TestAtiPage, test_malformed)
+{
+  reef_moonshiners::AtiPage scanned;
+  std::string error;
+  EXPECT_FALSE(scanned.scan("<html>Analysis not found</html>", error));
+  EXPECT_EQ(error, "data table not found");
+  EXPECT_FALSE(scanned.scan(make_page(""), error));
+  EXPECT_EQ(error, "zero section not found");
+
+  const std::string page = make_page(
+    make_entry(0, "Zinc", 1, "3.25") + make_entry(1, "Iron", 1, "0.8"));
+  /* every truncation fails cleanly, short of the end of the table */
+  const auto table_end = page.find("    tank:");
+  for (size_t size = page.find("\"0\":"); size < table_end - 2; ++size) {
+    EXPECT_FALSE(scanned.scan(std::string_view{page}.substr(0, size), error)) << size;
+  }
+  EXPECT_FALSE(scanned.scan(make_page(make_entry(0, "Zinc", 1, "three")), error));
+  EXPECT_EQ(error, "malformed entry \"0\"");
+  EXPECT_FALSE(scanned.scan(make_page(make_entry(0, "Zinc", 1, "null")), error));
+  EXPECT_EQ(error, "no results found");
+
+  /* nesting is bounded */
+  const std::string deep = "\"0\": {\"x\": " + std::string(10000, '[') + "}";
+  EXPECT_FALSE(scanned.scan(make_page(deep), error));
+}
@@ -0,0 +1,124 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <reef_moonshiners/batch_dose_engine.hpp>
+#include <reef_moonshiners/elements.hpp>
+
+#include <vector>
+
+TEST(TestBatchDoseEngine, test_matches_elements)
+{
+  const std::chrono::year_month_day start{
+    std::chrono::year(2022), std::chrono::October, std::chrono::day(1)};
+  const std::vector<double> gallons{17, 75, 100, 300, 17000};
+  const std::vector<double> zinc_measured{0.0, 1.0, 4.9, 5.0, 7.0};
+  const std::vector<double> iron_measured{0.0, 0.0, 0.02, 0.0, 0.005};
+  constexpr size_t days = 20;
+
+  reef_moonshiners::BatchDoseEngine engine{gallons.size()};
+  const size_t zinc_column = engine.add_element(reef_moonshiners::Zinc{});
+  const size_t iron_column = engine.add_element(reef_moonshiners::Iron{});
+  const size_t barium_column = engine.add_element(reef_moonshiners::Barium{});
+
+  std::vector<reef_moonshiners::Zinc> zinc(gallons.size());
+  std::vector<reef_moonshiners::Iron> iron(gallons.size());
+  std::vector<reef_moonshiners::Barium> barium(gallons.size());
+  for (size_t t = 0; t < gallons.size(); ++t) {
+    engine.set_tank_size(t, reef_moonshiners::gallons_to_liters(gallons[t]));
+    zinc[t].set_concentration(zinc_measured[t], start);
+    zinc[t].set_correction_start_date(start + std::chrono::days(t));
+    iron[t].set_concentration(iron_measured[t], start);
+    iron[t].set_multiplier((t % 2) ? 2.0 : 1.0);
+    barium[t].set_concentration(4.0 * t, start);
+    barium[t].set_correction_start_date(start);
+    engine.load(t, zinc_column, zinc[t]);
+    engine.load(t, iron_column, iron[t]);
+    engine.load(t, barium_column, barium[t]);
+  }
+
+  std::vector<double> doses;
+  engine.compute(start, days, doses);
+  ASSERT_EQ(doses.size(), gallons.size() * 3 * days);
+  for (size_t t = 0; t < gallons.size(); ++t) {
+    reef_moonshiners::ElementBase::set_tank_size(reef_moonshiners::gallons_to_liters(gallons[t]));
+    for (size_t d = 0; d < days; ++d) {
+      const auto date = start + std::chrono::days(d);
+      EXPECT_EQ(doses[(t * 3 + zinc_column) * days + d], zinc[t].get_dose(date));
+      EXPECT_EQ(doses[(t * 3 + iron_column) * days + d], iron[t].get_dose(date));
+      EXPECT_EQ(doses[(t * 3 + barium_column) * days + d], barium[t].get_dose(date));
+    }
+  }
+}
+
+TEST(TestBatchDoseEngine, test_rounding_matches_elements)
+{
+  /* enough tanks that most land in the vectorized body of the kernels */
+  const std::chrono::year_month_day start{
+    std::chrono::year(2022), std::chrono::October, std::chrono::day(1)};
+  constexpr size_t tanks = 1001;
+
+  reef_moonshiners::BatchDoseEngine engine{tanks};
+  const size_t iron_column = engine.add_element(reef_moonshiners::Iron{});
+  const size_t zinc_column = engine.add_element(reef_moonshiners::Zinc{});
+
+  std::vector<reef_moonshiners::Iron> iron(tanks);
+  std::vector<reef_moonshiners::Zinc> zinc(tanks);
+  for (size_t t = 0; t < tanks; ++t) {
+    engine.set_tank_size(t, 1.0 + 3.7 * t);
+    iron[t].set_concentration(0.0, start);
+    zinc[t].set_concentration(0.0037 * t, start);
+    zinc[t].set_correction_start_date(start);
+    engine.load(t, iron_column, iron[t]);
+    engine.load(t, zinc_column, zinc[t]);
+  }
+
+  std::vector<double> doses;
+  engine.compute(start, 1, doses);
+  for (size_t t = 0; t < tanks; ++t) {
+    reef_moonshiners::ElementBase::set_tank_size(1.0 + 3.7 * t);
+    EXPECT_EQ(doses[t * 2 + iron_column], iron[t].get_dose(start));
+    EXPECT_EQ(doses[t * 2 + zinc_column], zinc[t].get_dose(start));
+  }
+}
+
+TEST(TestBatchDoseEngine, test_correction_started_before_range)
+{
+  /* a correction already under way keeps the rest of its window */
+  const std::chrono::year_month_day correction_start{
+    std::chrono::year(2024), std::chrono::January, std::chrono::day(1)};
+  const std::chrono::year_month_day start = std::chrono::sys_days{correction_start} +
+    std::chrono::days(10);
+  constexpr size_t days = 10;
+
+  reef_moonshiners::BatchDoseEngine engine{1};
+  const size_t potassium_column = engine.add_element(reef_moonshiners::Potassium{});
+  reef_moonshiners::Potassium potassium;
+  engine.set_tank_size(0, 400.0);
+  potassium.set_concentration(0.0, correction_start);
+  potassium.set_correction_start_date(correction_start);
+  engine.load(0, potassium_column, potassium);
+
+  std::vector<double> doses;
+  engine.compute(start, days, doses);
+  ASSERT_EQ(doses.size(), days);
+  reef_moonshiners::ElementBase::set_tank_size(400.0);
+  ASSERT_GT(potassium.get_correction_duration().count(), 10);
+  for (size_t d = 0; d < days; ++d) {
+    const auto date = std::chrono::sys_days{start} + std::chrono::days(d);
+    EXPECT_GT(doses[d], 0.0);
+    EXPECT_EQ(doses[d], potassium.get_dose(date));
+  }
+}
@@ -0,0 +1,500 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <reef_moonshiners/batch_importer.hpp>
+#include <reef_moonshiners/elements.hpp>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+
+/**
+ * Local stand-in for the lab's server
+ *
+ * Serves each request from a handler over keep-alive HTTP/1.1, and keeps
+ * count of connections and concurrent requests.
+ */
+class StandInServer
+{
+public:
+  /// target -> (status, body)
+  using Handler = std::function<std::pair<int, std::string>(const std::string & target)>;
+
+  explicit StandInServer(Handler handler)
+  : m_handler(std::move(handler))
+  {
+    m_listen_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    ::bind(m_listen_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    ::listen(m_listen_fd, 64);
+    socklen_t size = sizeof(address);
+    ::getsockname(m_listen_fd, reinterpret_cast<sockaddr *>(&address), &size);
+    m_port = ntohs(address.sin_port);
+    m_accept_thread = std::thread{[this]() {this->_accept();}};
+  }
+
+  ~StandInServer()
+  {
+    ::shutdown(m_listen_fd, SHUT_RDWR);
+    ::close(m_listen_fd);
+    m_accept_thread.join();
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      for (const int fd : m_clients) {
+        ::shutdown(fd, SHUT_RDWR);
+      }
+    }
+    for (auto & thread : m_client_threads) {
+      thread.join();
+    }
+    for (const int fd : m_clients) {
+      ::close(fd);
+    }
+  }
+
+  uint16_t get_port() const
+  {
+    return m_port;
+  }
+
+  size_t get_connections() const
+  {
+    return m_connections.load();
+  }
+
+  size_t get_max_concurrent() const
+  {
+    return m_max_concurrent.load();
+  }
+
+private:
+  void _accept()
+  {
+    for (;;) {
+      const int fd = ::accept(m_listen_fd, nullptr, nullptr);
+      if (fd < 0) {
+        return;
+      }
+      ++m_connections;
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_clients.push_back(fd);
+      m_client_threads.emplace_back([this, fd]() {this->_serve(fd);});
+    }
+  }
+
+  void _serve(const int fd)
+  {
+    std::string buffer;
+    char chunk[4096];
+    for (;;) {
+      const auto end = buffer.find("\r\n\r\n");
+      if (end == std::string::npos) {
+        const ssize_t got = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (got <= 0) {
+          return;
+        }
+        buffer.append(chunk, static_cast<size_t>(got));
+        continue;
+      }
+      const std::string request = buffer.substr(0, end);
+      buffer.erase(0, end + 4);
+      const auto target_start = request.find(' ') + 1;
+      const std::string target =
+        request.substr(target_start, request.find(' ', target_start) - target_start);
+
+      const size_t concurrent = ++m_concurrent;
+      size_t seen = m_max_concurrent.load();
+      while (concurrent > seen && !m_max_concurrent.compare_exchange_weak(seen, concurrent)) {
+      }
+      /* long enough for requests to overlap */
+      std::this_thread::sleep_for(5ms);
+      const auto [status, body] = m_handler(target);
+      --m_concurrent;
+
+      std::ostringstream response;
+      response << "HTTP/1.1 " << status << " Status\r\n"
+               << "Content-Length: " << body.size() << "\r\n"
+               << "Connection: keep-alive\r\n\r\n" << body;
+      const std::string bytes = response.str();
+      if (::send(fd, bytes.data(), bytes.size(), MSG_NOSIGNAL) < 0) {
+        return;
+      }
+    }
+  }
+
+  Handler m_handler;
+  int m_listen_fd = -1;
+  uint16_t m_port = 0;
+  std::thread m_accept_thread;
+  std::mutex m_mutex;
+  std::vector<int> m_clients;
+  std::vector<std::thread> m_client_threads;
+  std::atomic<size_t> m_connections{0};
+  std::atomic<size_t> m_concurrent{0};
+  std::atomic<size_t> m_max_concurrent{0};
+};
+
+/**
+ * Keep-alive HTTP/1.1 client for StandInServer
+ *
+ * Understands only the responses the stand-in sends, which always give a
+ * Content-Length. Connections are returned to the pool after each response,
+ * so each worker reuses its own.
+ */
+class StandInClient
+{
+public:
+  explicit StandInClient(const uint16_t port)
+  : m_port(port)
+  {
+  }
+
+  ~StandInClient()
+  {
+    for (const int fd : m_idle) {
+      ::close(fd);
+    }
+  }
+
+  reef_moonshiners::FetchResult get(const std::string & target)
+  {
+    int fd = -1;
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      if (!m_idle.empty()) {
+        fd = m_idle.back();
+        m_idle.pop_back();
+      }
+    }
+    if (fd < 0 && (fd = this->_connect()) < 0) {
+      return reef_moonshiners::BatchImporter::make_fetch_result(0, {}, "could not connect");
+    }
+    int status = 0;
+    std::string body;
+    if (!_exchange(fd, target, status, body)) {
+      ::close(fd);
+      return reef_moonshiners::BatchImporter::make_fetch_result(0, {}, "connection failed");
+    }
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_idle.push_back(fd);
+    }
+    return reef_moonshiners::BatchImporter::make_fetch_result(status, std::move(body), {});
+  }
+
+  size_t get_connections_opened() const
+  {
+    return m_connections_opened.load();
+  }
+
+private:
+  int _connect()
+  {
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(m_port);
+    if (0 != ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address))) {
+      ::close(fd);
+      return -1;
+    }
+    timeval timeout{};
+    timeout.tv_sec = 10;
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ++m_connections_opened;
+    return fd;
+  }
+
+  static bool _exchange(
+    const int fd, const std::string & target, int & status,
+    std::string & body)
+  {
+    const std::string request =
+      "GET " + target + " HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: keep-alive\r\n\r\n";
+    if (::send(fd, request.data(), request.size(), MSG_NOSIGNAL) !=
+      static_cast<ssize_t>(request.size()))
+    {
+      return false;
+    }
+    std::string buffer;
+    char chunk[4096];
+    size_t end = std::string::npos;
+    size_t length = 0;
+    for (;;) {
+      if (std::string::npos == end && std::string::npos != (end = buffer.find("\r\n\r\n"))) {
+        const std::string head = buffer.substr(0, end);
+        buffer.erase(0, end + 4);
+        status = std::atoi(head.c_str() + head.find(' ') + 1);
+        const auto field = head.find("Content-Length: ");
+        length = (std::string::npos == field) ?
+          0 : std::strtoull(head.c_str() + field + 16, nullptr, 10);
+      }
+      if (std::string::npos != end && buffer.size() >= length) {
+        body = buffer.substr(0, length);
+        return true;
+      }
+      const ssize_t got = ::recv(fd, chunk, sizeof(chunk), 0);
+      if (got <= 0) {
+        return false;
+      }
+      buffer.append(chunk, static_cast<size_t>(got));
+    }
+  }
+
+  uint16_t m_port;
+  std::atomic<size_t> m_connections_opened{0};
+  std::mutex m_mutex;
+  std::vector<int> m_idle;
+};
+
+/// fetches the target prefix followed by the analysis ID
+reef_moonshiners::BatchImporter::Fetcher make_http_fetcher(
+  std::shared_ptr<StandInClient> client,
+  std::string prefix)
+{
+  return [client = std::move(client), prefix = std::move(prefix)](const std::string & analysis_id) {
+           return client->get(prefix + analysis_id);
+         };
+}
+
+/// reads pages of "name=value" lines
+bool parse_page(
+  const std::string & page, reef_moonshiners::IcpResults & results,
+  std::string & error)
+{
+  std::istringstream lines{page};
+  std::string line;
+  while (std::getline(lines, line)) {
+    const auto equals = line.find('=');
+    if (equals == std::string::npos) {
+      error = "malformed line '" + line + "'";
+      return false;
+    }
+    char * end = nullptr;
+    const double value = std::strtod(line.c_str() + equals + 1, &end);
+    if (end == line.c_str() + equals + 1 || '\0' != *end) {
+      error = "malformed value '" + line + "'";
+      return false;
+    }
+    results.set(reef_moonshiners::find_icp_element(line.substr(0, equals)), value);
+  }
+  return true;
+}
+
+reef_moonshiners::BatchImportOptions fast_options(const size_t parallelism)
+{
+  reef_moonshiners::BatchImportOptions options;
+  options.parallelism = parallelism;
+  options.max_attempts = 3;
+  options.initial_backoff = 1ms;
+  options.max_backoff = 4ms;
+  return options;
+}
+
+}  // namespace
+
+TEST(TestBatchImporter, test_import)
+{
+  constexpr size_t tanks = 24;
+  std::mutex mutex;
+  std::map<std::string, int> fetches;
+  StandInServer server{
+    [&](const std::string & target) -> std::pair<int, std::string> {
+      const std::string id = target.substr(target.rfind('/') + 1);
+      std::lock_guard<std::mutex> lock{mutex};
+      const int count = ++fetches[id];
+      if ("flaky" == id) {
+        return (count < 3) ? std::pair<int, std::string>{503, "busy"} : std::pair<int, std::string>{
+          200, "Zinc=1\n"};
+      }
+      if ("unknown" == id) {
+        return {404, "no such analysis"};
+      }
+      if ("down" == id) {
+        return {500, "broken"};
+      }
+      if ("garbled" == id) {
+        return {200, "not a page"};
+      }
+      return {200, "Zinc=" + id + "\nIron=12.5\n"};
+    }};
+
+  const std::chrono::year_month_day date{2022y / 9 / 14};
+  std::vector<std::unique_ptr<reef_moonshiners::Zinc>> zinc;
+  std::vector<std::unique_ptr<reef_moonshiners::Iron>> iron;
+  std::vector<reef_moonshiners::BatchImportEntry> entries;
+  for (size_t x = 0; x < tanks + 4; ++x) {
+    zinc.emplace_back(std::make_unique<reef_moonshiners::Zinc>());
+    iron.emplace_back(std::make_unique<reef_moonshiners::Iron>());
+    std::string id = std::to_string(x);
+    if (tanks + 0 == x) {
+      id = "flaky";
+    } else if (tanks + 1 == x) {
+      id = "unknown";
+    } else if (tanks + 2 == x) {
+      id = "down";
+    } else if (tanks + 3 == x) {
+      id = "garbled";
+    }
+    entries.push_back({id, {zinc.back().get(), iron.back().get()}, date});
+  }
+
+  constexpr size_t parallelism = 4;
+  std::vector<reef_moonshiners::BatchImportResult> results;
+  {
+    auto client = std::make_shared<StandInClient>(server.get_port());
+    reef_moonshiners::BatchImporter importer{
+      make_http_fetcher(client, "/publicAnalysis/"), parse_page, fast_options(parallelism)};
+    results = importer.run(entries);
+    /* keep-alive: one connection per worker, however many analyses */
+    EXPECT_LE(client->get_connections_opened(), parallelism);
+  }
+  EXPECT_LE(server.get_max_concurrent(), parallelism);
+  EXPECT_GT(server.get_max_concurrent(), 1u);
+
+  ASSERT_EQ(results.size(), entries.size());
+  for (size_t x = 0; x < tanks; ++x) {
+    EXPECT_TRUE(results[x].imported) << results[x].error;
+    EXPECT_EQ(results[x].attempts, 1u);
+    EXPECT_EQ(zinc[x]->get_last_measured_concentration(), static_cast<double>(x));
+    EXPECT_EQ(zinc[x]->get_last_measurement_date(), date);
+    EXPECT_EQ(iron[x]->get_last_measured_concentration(), 12.5);
+    EXPECT_TRUE(results[x].missing.empty());
+  }
+  /* transient failures are retried */
+  EXPECT_TRUE(results[tanks].imported);
+  EXPECT_EQ(results[tanks].attempts, 3u);
+  /* elements an analysis lacks are reported, and left alone */
+  EXPECT_EQ(results[tanks].missing, (std::vector<std::string>{"Iron"}));
+  EXPECT_EQ(iron[tanks]->get_last_measured_concentration(), 0.0);
+  /* permanent failures are not */
+  EXPECT_FALSE(results[tanks + 1].imported);
+  EXPECT_EQ(results[tanks + 1].attempts, 1u);
+  EXPECT_EQ(results[tanks + 1].error, "HTTP status 404");
+  /* retries give up eventually */
+  EXPECT_FALSE(results[tanks + 2].imported);
+  EXPECT_EQ(results[tanks + 2].attempts, 3u);
+  /* pages that do not parse leave the elements alone */
+  EXPECT_FALSE(results[tanks + 3].imported);
+  EXPECT_FALSE(results[tanks + 3].error.empty());
+  EXPECT_EQ(zinc[tanks + 3]->get_last_measured_concentration(), 0.0);
+}
+
+TEST(TestBatchImporter, test_fetch_without_applying)
+{
+  /* the app fetches off of the UI thread, then applies the results itself */
+  std::atomic<size_t> fetches{0};
+  reef_moonshiners::BatchImporter importer{
+    [&](const std::string & analysis_id) {
+      ++fetches;
+      return reef_moonshiners::BatchImporter::make_fetch_result(
+        ("missing" == analysis_id) ? 404 : 200, "Zinc=" + analysis_id.substr(0, 1) + "\n", "");
+    },
+    parse_page, fast_options(2)};
+  reef_moonshiners::Zinc zinc;
+  const std::chrono::year_month_day date{2022y / 9 / 14};
+  std::vector<reef_moonshiners::IcpResults> values;
+  const auto results = importer.fetch(
+    {{"3", {&zinc}, date}, {"missing", {&zinc}, date}, {"5", {&zinc}, date}}, values);
+  ASSERT_EQ(results.size(), 3u);
+  ASSERT_EQ(values.size(), 3u);
+  EXPECT_EQ(fetches.load(), 3u);
+  EXPECT_TRUE(results[0].imported);
+  EXPECT_EQ(values[0].get(reef_moonshiners::IcpElement::ZINC), 3.0);
+  EXPECT_FALSE(results[1].imported);
+  EXPECT_EQ(results[1].error, "HTTP status 404");
+  EXPECT_EQ(values[2].get(reef_moonshiners::IcpElement::ZINC), 5.0);
+  /* nothing was applied */
+  EXPECT_EQ(zinc.get_last_measured_concentration(), 0.0);
+}
+
+TEST(TestBatchImporter, test_fetch_result)
+{
+  using reef_moonshiners::BatchImporter;
+  using reef_moonshiners::FetchStatus;
+  EXPECT_EQ(BatchImporter::make_fetch_result(200, "page", "").status, FetchStatus::OK);
+  EXPECT_EQ(BatchImporter::make_fetch_result(200, "page", "").page, "page");
+  for (const int status : {0, 408, 429, 500, 503}) {
+    EXPECT_EQ(
+      BatchImporter::make_fetch_result(status, "", "offline").status,
+      FetchStatus::TRANSIENT_ERROR) << status;
+  }
+  EXPECT_EQ(BatchImporter::make_fetch_result(0, "", "offline").error, "offline");
+  EXPECT_EQ(
+    BatchImporter::make_fetch_result(404, "", "").status, FetchStatus::PERMANENT_ERROR);
+}
+
+TEST(TestBatchImporter, test_backoff)
+{
+  reef_moonshiners::BatchImportOptions options;
+  options.initial_backoff = 100ms;
+  options.max_backoff = 1000ms;
+  reef_moonshiners::BatchImporter importer{nullptr, nullptr, options};
+  std::mt19937_64 rng{7};
+  for (size_t attempt = 1; attempt < 10; ++attempt) {
+    const auto ceiling = std::min<std::chrono::milliseconds>(
+      options.initial_backoff * (1 << (attempt - 1)), options.max_backoff);
+    for (int x = 0; x < 100; ++x) {
+      const auto wait = importer.get_backoff(attempt, rng);
+      EXPECT_GE(wait.count(), 0);
+      EXPECT_LE(wait, ceiling);
+    }
+  }
+}
+
+TEST(TestBatchImporter, test_connection_refused)
+{
+  /* nothing listens here once the server is gone */
+  uint16_t port = 0;
+  {
+    StandInServer server{[](const std::string &) {return std::pair<int, std::string>{200, ""};}};
+    port = server.get_port();
+  }
+  reef_moonshiners::Zinc zinc;
+  reef_moonshiners::BatchImporter importer{
+    make_http_fetcher(std::make_shared<StandInClient>(port), "/publicAnalysis/"),
+    parse_page, fast_options(1)};
+  const auto results = importer.run({{"1", {&zinc}, 2022y / 9 / 14}});
+  ASSERT_EQ(results.size(), 1u);
+  /* an unreachable server is worth retrying, until the attempts run out */
+  EXPECT_FALSE(results[0].imported);
+  EXPECT_EQ(results[0].attempts, 3u);
+  EXPECT_FALSE(results[0].error.empty());
+}
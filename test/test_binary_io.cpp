@@ -0,0 +1,114 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <reef_moonshiners/binary_io.hpp>
+#include <reef_moonshiners/element_base.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+using namespace std::chrono_literals;
+
+TEST(TestBinaryIO, test_little_endian)
+{
+  std::stringstream stream;
+  reef_moonshiners::binary_out(stream, uint32_t{0x01020304});
+  reef_moonshiners::binary_out(stream, int16_t{-2});
+  const std::string bytes = stream.str();
+  ASSERT_EQ(6u, bytes.size());
+  EXPECT_EQ("\x04\x03\x02\x01\xfe\xff", bytes);
+}
+
+TEST(TestBinaryIO, test_round_trip)
+{
+  const std::chrono::year_month_day date{2022y / 7 / 14};
+  const std::unordered_map<std::string, double> map{{"iodine", 0.06}, {"barium", 8.0}};
+  std::stringstream stream;
+  reef_moonshiners::binary_out(stream, 1.25);
+  reef_moonshiners::binary_out(stream, uint64_t{1} << 40);
+  reef_moonshiners::binary_out(stream, reef_moonshiners::DosingUnit::DROPS);
+  reef_moonshiners::binary_out(stream, date);
+  reef_moonshiners::binary_out(stream, std::string{"Molybdenum"});
+  reef_moonshiners::binary_out(stream, map);
+
+  double d = 0.0;
+  uint64_t u = 0;
+  reef_moonshiners::DosingUnit unit = reef_moonshiners::DosingUnit::ML;
+  std::chrono::year_month_day read_date;
+  std::string name;
+  std::unordered_map<std::string, double> read_map;
+  reef_moonshiners::binary_in(stream, d);
+  reef_moonshiners::binary_in(stream, u);
+  reef_moonshiners::binary_in(stream, unit);
+  reef_moonshiners::binary_in(stream, read_date);
+  reef_moonshiners::binary_in(stream, name);
+  reef_moonshiners::binary_in(stream, read_map);
+  ASSERT_TRUE(stream);
+  EXPECT_EQ(1.25, d);
+  EXPECT_EQ(uint64_t{1} << 40, u);
+  EXPECT_EQ(reef_moonshiners::DosingUnit::DROPS, unit);
+  EXPECT_EQ(date, read_date);
+  EXPECT_EQ("Molybdenum", name);
+  EXPECT_EQ(map, read_map);
+}
+
+TEST(TestBinaryIO, test_date_layout)
+{
+  /* dates must read the same as the raw copies older versions wrote */
+  const std::chrono::year_month_day date{2023y / 12 / 31};
+  std::stringstream stream;
+  reef_moonshiners::binary_out(stream, date);
+  ASSERT_EQ(sizeof(date), stream.str().size());
+  if constexpr (std::endian::native == std::endian::little) {
+    EXPECT_EQ(0, std::memcmp(&date, stream.str().data(), sizeof(date)));
+  }
+}
+
+TEST(TestBinaryIO, test_corrupt_length)
+{
+  std::stringstream stream;
+  reef_moonshiners::binary_out(stream, uint64_t{0xffffffffffff});
+  stream << "not nearly that long";
+  std::string name = "unchanged";
+  reef_moonshiners::binary_in(stream, name);
+  EXPECT_FALSE(stream);
+  EXPECT_TRUE(name.empty());
+}
+
+TEST(TestBinaryIO, test_truncated_string)
+{
+  std::stringstream stream;
+  reef_moonshiners::binary_out(stream, uint64_t{16});
+  stream << "short";
+  std::string name;
+  reef_moonshiners::binary_in(stream, name);
+  EXPECT_FALSE(stream);
+  EXPECT_TRUE(name.empty());
+}
+
+TEST(TestBinaryIO, test_truncated_scalar)
+{
+  std::stringstream stream;
+  stream << "ab";
+  uint32_t value = 7;
+  reef_moonshiners::binary_in(stream, value);
+  EXPECT_FALSE(stream);
+  EXPECT_EQ(7u, value);
+}
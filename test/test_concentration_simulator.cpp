@@ -0,0 +1,129 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <reef_moonshiners/concentration_simulator.hpp>
+#include <reef_moonshiners/elements.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+const std::chrono::year_month_day start{
+  std::chrono::year(2022), std::chrono::October, std::chrono::day(1)};
+
+}  // namespace
+
+TEST(TestConcentrationSimulator, test_without_error)
+{
+  auto tank = std::make_shared<reef_moonshiners::Tank>(reef_moonshiners::gallons_to_liters(75));
+  reef_moonshiners::Iron iron;
+  reef_moonshiners::Zinc zinc;
+  reef_moonshiners::Iodine iodine;
+  iron.set_tank(tank);
+  zinc.set_tank(tank);
+  iodine.set_tank(tank);
+  iron.set_concentration(0.5, start);
+  zinc.set_concentration(0.0, start);
+  zinc.set_correction_start_date(start);
+  iodine.set_concentration(30.0, start);
+
+  reef_moonshiners::SimulationParameters parameters;
+  parameters.scenarios = 10;
+  parameters.days = 60;
+  parameters.measurement_error = 0.0;
+  reef_moonshiners::ConcentrationSimulator simulator{{&iron, &zinc, &iodine}};
+  const auto bands = simulator.run(start, parameters);
+  ASSERT_EQ(bands.get_element_count(), 3u);
+  ASSERT_EQ(bands.get_day_count(), 60u);
+  ASSERT_EQ(bands.get_percentiles().size(), 3u);
+
+  const std::vector<const reef_moonshiners::ElementBase *> elements{&iron, &zinc, &iodine};
+  for (size_t e = 0; e < elements.size(); ++e) {
+    double expected = elements[e]->get_last_measured_concentration();
+    for (size_t d = 0; d < parameters.days; ++d) {
+      expected += elements[e]->get_dose(start + std::chrono::days(d)) * 1E-3 *
+        elements[e]->get_element_concentration() / tank->get_volume();
+      for (size_t p = 0; p < bands.get_percentiles().size(); ++p) {
+        EXPECT_NEAR(bands.get(e, p, d), expected, 1E-9);
+      }
+    }
+  }
+  /* the correction approaches the target, less what the dose truncation drops */
+  EXPECT_LE(bands.get(1, 1, 59), zinc.get_target_concentration());
+  EXPECT_GT(bands.get(1, 1, 59), 0.99 * zinc.get_target_concentration());
+  /* drops do not move the simulated concentration */
+  EXPECT_EQ(bands.get(2, 1, 59), 30.0);
+}
+
+TEST(TestConcentrationSimulator, test_bands)
+{
+  reef_moonshiners::Manganese manganese;
+  manganese.set_tank(std::make_shared<reef_moonshiners::Tank>(400.0));
+  manganese.set_concentration(0.1, start);
+
+  reef_moonshiners::SimulationParameters parameters;
+  parameters.scenarios = 2000;
+  parameters.days = 30;
+  parameters.measurement_error = 0.2;
+  parameters.consumption_rate = 0.05;
+  parameters.consumption_error = 0.5;
+  parameters.percentiles = {5.0, 50.0, 95.0};
+  parameters.seed = 42;
+  reef_moonshiners::ConcentrationSimulator simulator{{&manganese}};
+
+  parameters.threads = 1;
+  const auto serial = simulator.run(start, parameters);
+  parameters.threads = 4;
+  const auto parallel = simulator.run(start, parameters);
+  for (size_t d = 0; d < parameters.days; ++d) {
+    EXPECT_LT(serial.get(0, 0, d), serial.get(0, 1, d));
+    EXPECT_LT(serial.get(0, 1, d), serial.get(0, 2, d));
+    for (size_t p = 0; p < 3; ++p) {
+      /* the same seed gives the same bands on any number of threads */
+      EXPECT_EQ(serial.get(0, p, d), parallel.get(0, p, d));
+    }
+  }
+  /* the measurement error bounds the first day */
+  EXPECT_GE(serial.get(0, 0, 0), 0.1 * 0.8 * 0.925);
+  EXPECT_LE(serial.get(0, 2, 0), 0.1 * 1.2 + manganese.get_dose(start) * 1E-3 *
+    manganese.get_element_concentration() / 400.0);
+}
+
+TEST(TestConcentrationSimulator, test_nano_dose)
+{
+  /* a nano dose raises the concentration by the nano supplement's strength */
+  auto tank = std::make_shared<reef_moonshiners::Tank>(100.0);
+  reef_moonshiners::Iron iron;
+  iron.set_tank(tank);
+  iron.set_concentration(0.0, start);
+  iron.set_use_nano_dose(true);
+  ASSERT_NE(iron.get_dose_concentration(), iron.get_element_concentration());
+
+  reef_moonshiners::SimulationParameters parameters;
+  parameters.scenarios = 3;
+  parameters.days = 10;
+  parameters.measurement_error = 0.0;
+  reef_moonshiners::ConcentrationSimulator simulator{{&iron}};
+  const auto bands = simulator.run(start, parameters);
+  double expected = 0.0;
+  for (size_t d = 0; d < parameters.days; ++d) {
+    expected += iron.get_dose(start + std::chrono::days(d)) * 1E-3 *
+      iron.get_dose_concentration() / tank->get_volume();
+    EXPECT_NEAR(bands.get(0, 1, d), expected, 1E-9);
+  }
+}
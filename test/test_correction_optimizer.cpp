@@ -0,0 +1,152 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <reef_moonshiners/correction_optimizer.hpp>
+#include <reef_moonshiners/elements.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+struct Corrections
+{
+  Corrections()
+  {
+    const std::chrono::year_month_day now{
+      std::chrono::floor<std::chrono::days>(std::chrono::system_clock::now())};
+    auto tank = std::make_shared<reef_moonshiners::Tank>(reef_moonshiners::gallons_to_liters(120));
+    for (reef_moonshiners::CorrectionElement * element :
+      std::vector<reef_moonshiners::CorrectionElement *>{&zinc, &molybdenum, &nickel, &boron})
+    {
+      element->set_tank(tank);
+      element->set_correction_start_date(now);
+    }
+    zinc.set_concentration(0.0, now);
+    molybdenum.set_concentration(3.0, now);
+    nickel.set_concentration(0.0, now);
+    boron.set_concentration(4.5E3, now);
+  }
+
+  std::vector<const reef_moonshiners::CorrectionElement *> get() const
+  {
+    return {&zinc, &molybdenum, &nickel, &boron};
+  }
+
+  reef_moonshiners::Zinc zinc;
+  reef_moonshiners::Molybdenum molybdenum;
+  reef_moonshiners::Nickel nickel;
+  reef_moonshiners::Boron boron;
+};
+
+/**
+ * Check the solution doses each element its total, never over its maximum
+ */
+void check_totals(
+  const std::vector<const reef_moonshiners::CorrectionElement *> & elements,
+  const reef_moonshiners::CorrectionSolution & solution)
+{
+  for (size_t e = 0; e < elements.size(); ++e) {
+    double total = 0.0;
+    for (size_t day = 0; day < solution.days; ++day) {
+      EXPECT_LE(solution.get_dose(e, day), elements[e]->get_max_daily_dose());
+      total += solution.get_dose(e, day);
+    }
+    EXPECT_LE(total, elements[e]->get_correction_total());
+    EXPECT_NEAR(total, elements[e]->get_correction_total(), 0.01);
+  }
+}
+
+}  // namespace
+
+TEST(TestCorrectionOptimizer, test_unconstrained)
+{
+  Corrections corrections;
+  const auto elements = corrections.get();
+  const auto solution = reef_moonshiners::CorrectionOptimizer{}.solve(elements);
+  ASSERT_TRUE(solution.complete);
+  ASSERT_EQ(solution.days_to_target.size(), elements.size());
+  ASSERT_EQ(solution.doses.size(), solution.days * elements.size());
+  check_totals(elements, solution);
+  for (size_t e = 0; e < elements.size(); ++e) {
+    /* at most one more day than the even split, for what truncation leaves over */
+    const auto duration = static_cast<size_t>(elements[e]->get_correction_duration().count());
+    EXPECT_GE(solution.days_to_target[e], duration);
+    EXPECT_LE(solution.days_to_target[e], duration + 1);
+  }
+  EXPECT_EQ(
+    solution.days,
+    *std::max_element(solution.days_to_target.begin(), solution.days_to_target.end()));
+}
+
+TEST(TestCorrectionOptimizer, test_daily_budget)
+{
+  Corrections corrections;
+  const auto elements = corrections.get();
+  double total = 0.0;
+  for (const auto * element : elements) {
+    total += element->get_correction_total();
+  }
+  reef_moonshiners::CorrectionConstraints constraints;
+  constraints.daily_budget = 10.0;
+  const auto solution = reef_moonshiners::CorrectionOptimizer{constraints}.solve(elements);
+  ASSERT_TRUE(solution.complete);
+  check_totals(elements, solution);
+  for (size_t day = 0; day < solution.days; ++day) {
+    double pumped = 0.0;
+    for (size_t e = 0; e < elements.size(); ++e) {
+      pumped += solution.get_dose(e, day);
+    }
+    EXPECT_LE(pumped, constraints.daily_budget + 1E-9);
+  }
+  /* the budget is kept busy, so we finish within a day of the bound */
+  const auto bound = static_cast<size_t>(std::ceil(total / constraints.daily_budget));
+  EXPECT_GE(solution.days, bound);
+  EXPECT_LE(solution.days, bound + 1);
+}
+
+TEST(TestCorrectionOptimizer, test_spacing)
+{
+  Corrections corrections;
+  const auto elements = corrections.get();
+  reef_moonshiners::CorrectionConstraints constraints;
+  constraints.max_elements_per_day = 2;
+  constraints.min_interval = 2;
+  const auto solution = reef_moonshiners::CorrectionOptimizer{constraints}.solve(elements);
+  ASSERT_TRUE(solution.complete);
+  check_totals(elements, solution);
+  for (size_t day = 0; day < solution.days; ++day) {
+    size_t dosed = 0;
+    for (size_t e = 0; e < elements.size(); ++e) {
+      if (solution.get_dose(e, day) > 0.0) {
+        ++dosed;
+        if (day > 0) {
+          EXPECT_EQ(solution.get_dose(e, day - 1), 0.0);
+        }
+      }
+    }
+    EXPECT_LE(dosed, constraints.max_elements_per_day);
+  }
+
+  /* a horizon that is too short leaves the corrections incomplete */
+  constraints.horizon = 3;
+  const auto partial = reef_moonshiners::CorrectionOptimizer{constraints}.solve(elements);
+  EXPECT_FALSE(partial.complete);
+  EXPECT_EQ(partial.days, 3u);
+}
@@ -18,6 +18,9 @@
 
 #include <fstream>
 #include <filesystem>
+#include <memory>
+#include <sstream>
+#include <string>
 
 namespace fs = std::filesystem;
 
@@ -163,9 +166,9 @@ TEST(TestCorrections, test_ostream)
   reef_moonshiners::Fluorine fluorine_out;
   fluorine_out.set_concentration(0.0, now);
 
-  fs::path out = fs::temp_directory_path() / "out";
+  fs::path out = fs::temp_directory_path() / "test_corrections_test_ostream.out";
   std::ofstream out_file{out, std::ios::binary};
-  static constexpr size_t out_version = 3;
+  static constexpr size_t out_version = 4;
   reef_moonshiners::binary_out(out_file, out_version);
   out_file << molybdenum_out << fluorine_out;
   out_file.close();
@@ -192,3 +195,159 @@ TEST(TestCorrections, test_ostream)
   EXPECT_EQ(fluorine_in.get_last_measurement_date(), fluorine_out.get_last_measurement_date());
   EXPECT_EQ(fluorine_in.get_target_concentration(), fluorine_out.get_target_concentration());
 }
+
+TEST(TestCorrections, test_dose_ledger)
+{
+  const std::chrono::year_month_day start{
+    std::chrono::year(2022), std::chrono::September, std::chrono::day(1)};
+  reef_moonshiners::DoseLedger ledger;
+  /* record out of order, with a gap and an overwrite */
+  ledger.set(start + std::chrono::days(10), 3.0);
+  ledger.set(start, 1.0);
+  ledger.set(start + std::chrono::days(5), 2.0);
+  ledger.set(start + std::chrono::days(5), 2.5);
+  EXPECT_EQ(ledger.size(), 3u);
+  EXPECT_DOUBLE_EQ(ledger.get(start + std::chrono::days(5)), 2.5);
+  EXPECT_DOUBLE_EQ(ledger.get(start + std::chrono::days(6)), 0.0);
+  EXPECT_DOUBLE_EQ(ledger.total(start, start + std::chrono::days(11)), 6.5);
+  EXPECT_DOUBLE_EQ(ledger.total(start, start + std::chrono::days(10)), 3.5);
+  EXPECT_DOUBLE_EQ(ledger.total(start + std::chrono::days(1), start + std::chrono::days(6)), 2.5);
+  EXPECT_DOUBLE_EQ(ledger.total(start + std::chrono::days(6), start), 0.0);
+}
+
+TEST(TestCorrections, test_dose_ledger_ostream)
+{
+  const std::chrono::year_month_day start{
+    std::chrono::year(1969), std::chrono::December, std::chrono::day(20)};
+  reef_moonshiners::DoseLedger ledger_out;
+  for (int day = 0; day < 400; day += 3) {
+    ledger_out.set(start + std::chrono::days(day), 0.25 * day);
+  }
+
+  fs::path out = fs::temp_directory_path() / "test_corrections_test_dose_ledger_ostream.out";
+  std::ofstream out_file{out, std::ios::binary};
+  ledger_out.write_to(out_file);
+  /* version 3 stored a map of date -> dose */
+  const size_t legacy_len = 2;
+  reef_moonshiners::binary_out(out_file, legacy_len);
+  reef_moonshiners::binary_out(out_file, start + std::chrono::days(7));
+  reef_moonshiners::binary_out(out_file, 2.0);
+  reef_moonshiners::binary_out(out_file, start);
+  reef_moonshiners::binary_out(out_file, 1.0);
+  out_file.close();
+
+  reef_moonshiners::DoseLedger ledger_in;
+  reef_moonshiners::DoseLedger legacy_in;
+  std::ifstream in_file{out, std::ios::binary};
+  reef_moonshiners::ElementBase::set_load_version(4);
+  ledger_in.read_from(in_file);
+  reef_moonshiners::ElementBase::set_load_version(3);
+  legacy_in.read_from(in_file);
+  EXPECT_EQ(ledger_in.size(), ledger_out.size());
+  for (int day = -5; day < 405; ++day) {
+    const auto date = start + std::chrono::days(day);
+    EXPECT_EQ(ledger_in.get(date), ledger_out.get(date));
+    EXPECT_EQ(ledger_in.total(start, date), ledger_out.total(start, date));
+  }
+  EXPECT_EQ(legacy_in.size(), 2u);
+  EXPECT_DOUBLE_EQ(legacy_in.get(start), 1.0);
+  EXPECT_DOUBLE_EQ(legacy_in.get(start + std::chrono::days(7)), 2.0);
+  EXPECT_DOUBLE_EQ(legacy_in.total(start, start + std::chrono::days(8)), 3.0);
+}
+
+TEST(TestCorrections, test_dose_ledger_compact)
+{
+  const std::chrono::year_month_day start{
+    std::chrono::year(2020), std::chrono::January, std::chrono::day(1)};
+  reef_moonshiners::DoseLedger ledger_out;
+  /* three years of daily corrections at the pump's resolution, with a break */
+  for (int day = 0; day < 3 * 365; ++day) {
+    if (day < 400 || day >= 430) {
+      ledger_out.set(
+        start + std::chrono::days(day),
+        reef_moonshiners::truncate_places<2>(0.37 * (1 + day % 5)));
+    }
+  }
+  /* doses off the pump's resolution are kept exactly */
+  ledger_out.set(start + std::chrono::days(-3), 1.0 / 3.0);
+  ledger_out.set(start + std::chrono::days(415), 1E-9);
+
+  std::stringstream stream;
+  ledger_out.write_to(stream);
+  /* the chunked layout took 8 bytes per dose */
+  EXPECT_LT(stream.str().size(), 3 * ledger_out.size());
+
+  reef_moonshiners::DoseLedger ledger_in;
+  ledger_in.read_from(stream, 6);
+  ASSERT_TRUE(stream);
+  EXPECT_EQ(ledger_in.size(), ledger_out.size());
+  for (int day = -5; day < 3 * 365 + 5; ++day) {
+    const auto date = start + std::chrono::days(day);
+    EXPECT_EQ(ledger_in.get(date), ledger_out.get(date));
+  }
+
+  /* versions 4 and 5 wrote the chunks as they were laid out in memory */
+  std::stringstream chunked;
+  const int32_t day_index = static_cast<int32_t>(
+    std::chrono::sys_days{start}.time_since_epoch().count());
+  reef_moonshiners::binary_out(chunked, uint64_t{1});
+  reef_moonshiners::binary_out(chunked, day_index / reef_moonshiners::DoseLedger::chunk_days);
+  reef_moonshiners::binary_out(
+    chunked, uint32_t{1} << (day_index % reef_moonshiners::DoseLedger::chunk_days));
+  reef_moonshiners::binary_out(chunked, 1.5);
+  reef_moonshiners::DoseLedger chunked_in;
+  chunked_in.read_from(chunked, 5);
+  EXPECT_EQ(chunked_in.size(), 1u);
+  EXPECT_EQ(chunked_in.get(start), 1.5);
+
+  /* chunks out of order would break lookups, so they fail the stream */
+  std::stringstream unordered;
+  reef_moonshiners::binary_out(unordered, uint64_t{2});
+  for (const int32_t key : {day_index / reef_moonshiners::DoseLedger::chunk_days + 1,
+      day_index / reef_moonshiners::DoseLedger::chunk_days})
+  {
+    reef_moonshiners::binary_out(unordered, key);
+    reef_moonshiners::binary_out(unordered, uint32_t{1});
+    reef_moonshiners::binary_out(unordered, 1.5);
+  }
+  reef_moonshiners::DoseLedger unordered_in;
+  unordered_in.read_from(unordered, 5);
+  EXPECT_FALSE(unordered);
+
+  /* a truncated history fails the stream */
+  const std::string bytes = stream.str();
+  std::stringstream truncated{bytes.substr(0, bytes.size() - 1)};
+  reef_moonshiners::DoseLedger truncated_in;
+  truncated_in.read_from(truncated, 6);
+  EXPECT_FALSE(truncated);
+}
+
+TEST(TestCorrections, test_correction_plan_invalidation)
+{
+  const std::chrono::year_month_day now{
+    std::chrono::year(2022), std::chrono::October, std::chrono::day(1)};
+  auto tank = std::make_shared<reef_moonshiners::Tank>(reef_moonshiners::gallons_to_liters(100));
+  reef_moonshiners::Zinc element;
+  element.set_tank(tank);
+  element.set_concentration(0, now);
+  element.set_correction_start_date(now);
+  EXPECT_DOUBLE_EQ(element.get_dose(now), 0.63);
+  EXPECT_EQ(element.get_correction_duration(), std::chrono::days(3));
+  /* tank size change */
+  tank->set_volume(reef_moonshiners::gallons_to_liters(300));
+  EXPECT_DOUBLE_EQ(element.get_dose(now), element.get_correction_dose());
+  EXPECT_NEAR(element.get_dose(now), 3 * 0.63, 0.01);
+  /* new measurement */
+  element.set_concentration(5.0, now);
+  EXPECT_DOUBLE_EQ(element.get_dose(now), 0.0);
+  EXPECT_EQ(element.get_correction_duration(), std::chrono::days(0));
+  element.set_concentration(0, now);
+  /* new start date */
+  element.set_correction_start_date(now + std::chrono::days(1));
+  EXPECT_DOUBLE_EQ(element.get_dose(now), 0.0);
+  EXPECT_GT(element.get_dose(now + std::chrono::days(1)), 0.0);
+  /* switching tanks */
+  element.set_tank(
+    std::make_shared<reef_moonshiners::Tank>(reef_moonshiners::gallons_to_liters(100)));
+  EXPECT_DOUBLE_EQ(element.get_dose(now + std::chrono::days(1)), 0.63);
+}
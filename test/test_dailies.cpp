@@ -18,6 +18,9 @@
 
 #include <fstream>
 #include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -82,7 +85,7 @@ TEST(TestDailies, test_ostream)
   iron_out.set_concentration(0.0, now);
   iron_out.set_multiplier(2.0);
 
-  fs::path out = fs::temp_directory_path() / "out";
+  fs::path out = fs::temp_directory_path() / "test_dailies_test_ostream.out";
   std::ofstream out_file{out, std::ios::binary};
   static constexpr size_t out_version = 3;
   reef_moonshiners::binary_out(out_file, out_version);
@@ -113,3 +116,98 @@ TEST(TestDailies, test_ostream)
   EXPECT_EQ(iron_in.get_last_measurement_date(), iron_out.get_last_measurement_date());
   EXPECT_EQ(iron_in.get_target_concentration(), iron_out.get_target_concentration());
 }
+
+TEST(TestDailies, test_tank_per_element)
+{
+  const std::chrono::year_month_day now{std::chrono::floor<std::chrono::days>(
+      std::chrono::system_clock::now())};
+  const std::vector<double> gallons{50, 75, 100, 300};
+  std::vector<reef_moonshiners::Iron> elements(gallons.size());
+  for (size_t x = 0; x < gallons.size(); ++x) {
+    elements[x].set_tank(
+      std::make_shared<reef_moonshiners::Tank>(reef_moonshiners::gallons_to_liters(gallons[x])));
+    elements[x].set_concentration(0.0, now);
+  }
+  /* the default tank no longer affects these elements */
+  reef_moonshiners::ElementBase::set_tank_size(0.0);
+  std::vector<double> doses(gallons.size());
+  std::vector<std::thread> threads;
+  for (size_t x = 0; x < gallons.size(); ++x) {
+    threads.emplace_back([&, x]() {doses[x] = elements[x].get_dose(now);});
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  EXPECT_DOUBLE_EQ(doses[0], 0.02);
+  EXPECT_DOUBLE_EQ(doses[1], 0.03);
+  EXPECT_DOUBLE_EQ(doses[2], 0.04);
+  EXPECT_DOUBLE_EQ(doses[3], 0.11);
+}
+
+TEST(TestDailies, test_rubidium_calendar)
+{
+  const std::chrono::year_month_day start{
+    std::chrono::year(2022), std::chrono::November, std::chrono::day(15)};
+  const std::chrono::year_month_day end = start + std::chrono::days(800);
+  reef_moonshiners::Rubidium element;
+  element.set_tank(
+    std::make_shared<reef_moonshiners::Tank>(reef_moonshiners::gallons_to_liters(100)));
+  element.set_concentration(0.0, start);
+  element.set_initial_dose_date(start + std::chrono::days(20));
+  for (const auto frequency : {reef_moonshiners::RubidiumSelection::DAILY,
+      reef_moonshiners::RubidiumSelection::MONTHLY,
+      reef_moonshiners::RubidiumSelection::QUARTERLY})
+  {
+    element.set_dosing_frequency(frequency);
+    const std::vector<double> doses = element.get_doses(start, end);
+    ASSERT_EQ(doses.size(), 800u);
+    size_t dose_days = 0;
+    for (size_t x = 0; x < doses.size(); ++x) {
+      EXPECT_EQ(doses[x], element.get_dose(start + std::chrono::days(x)));
+      dose_days += (doses[x] > 0.0);
+    }
+    /* the dosing frequency is untouched by the initial dose */
+    EXPECT_EQ(element.get_dosing_frequency(), frequency);
+    EXPECT_GT(dose_days, 0u);
+  }
+  element.set_dosing_frequency(reef_moonshiners::RubidiumSelection::QUARTERLY);
+  EXPECT_GT(
+    element.get_dose(start + std::chrono::days(20)),
+    element.get_dose(
+      std::chrono::year_month_day{std::chrono::year(2023), std::chrono::April,
+        std::chrono::day(1)}));
+}
+
+TEST(TestDailies, test_same_dose_every_day)
+{
+  const std::chrono::year_month_day start{
+    std::chrono::year(2022), std::chrono::November, std::chrono::day(15)};
+  auto tank = std::make_shared<reef_moonshiners::Tank>(reef_moonshiners::gallons_to_liters(100));
+  reef_moonshiners::Iron iron_element;
+  reef_moonshiners::Iodine iodine_element;
+  reef_moonshiners::Rubidium rubidium_element;
+  reef_moonshiners::Zinc zinc_element;
+  for (reef_moonshiners::ElementBase * element :
+    std::vector<reef_moonshiners::ElementBase *>{
+      &iron_element, &iodine_element, &rubidium_element, &zinc_element})
+  {
+    element->set_tank(tank);
+    element->set_concentration(0.0, start);
+  }
+  EXPECT_TRUE(iron_element.is_same_dose_every_day());
+  EXPECT_TRUE(iodine_element.is_same_dose_every_day());
+  EXPECT_FALSE(rubidium_element.is_same_dose_every_day());
+  EXPECT_FALSE(zinc_element.is_same_dose_every_day());
+  for (size_t x = 0; x < 400; ++x) {
+    EXPECT_EQ(iron_element.get_dose(start + std::chrono::days(x)), iron_element.get_dose(start));
+  }
+
+  /* a drop count changes only its own element, the tank changes them all */
+  const uint64_t iron_generation = iron_element.get_generation();
+  const uint64_t iodine_generation = iodine_element.get_generation();
+  iodine_element.set_drops(3);
+  EXPECT_EQ(iron_element.get_generation(), iron_generation);
+  EXPECT_NE(iodine_element.get_generation(), iodine_generation);
+  tank->set_volume(reef_moonshiners::gallons_to_liters(50));
+  EXPECT_NE(iron_element.get_generation(), iron_generation);
+}
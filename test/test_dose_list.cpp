@@ -0,0 +1,183 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <reef_moonshiners/dose_list.hpp>
+#include <reef_moonshiners/elements.hpp>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+using reef_moonshiners::DoseRow;
+using reef_moonshiners::DoseRowEdit;
+using reef_moonshiners::DoseRowEditType;
+
+namespace
+{
+
+/**
+ * @brief Iron that counts how often its schedule is computed
+ */
+struct CountedIron final : public reef_moonshiners::Iron
+{
+  void fill_doses(
+    const std::chrono::year_month_day & start, std::span<double> doses) const final
+  {
+    ++fills;
+    this->Iron::fill_doses(start, doses);
+  }
+
+  mutable size_t fills = 0;
+};
+
+std::vector<DoseRow> apply_all(
+  std::vector<DoseRow> rows, const std::vector<DoseRowEdit> & edits,
+  const std::vector<DoseRow> & to)
+{
+  for (const auto & edit : edits) {
+    reef_moonshiners::apply_dose_row_edit(rows, edit, to);
+  }
+  return rows;
+}
+
+}  // namespace
+
+TEST(TestDoseList, test_diff)
+{
+  const std::vector<DoseRow> from{{0, 1.0}, {1, 1.0}, {2, 1.0}, {3, 1.0}, {6, 1.0}};
+  const std::vector<DoseRow> to{{0, 1.0}, {1, 2.0}, {4, 1.0}, {5, 1.0}, {6, 1.0}, {7, 1.0}};
+  std::vector<DoseRowEdit> edits;
+  reef_moonshiners::diff_dose_rows(from, to, edits);
+  EXPECT_EQ(
+    edits, (std::vector<DoseRowEdit>{
+    {DoseRowEditType::CHANGE, 1, 1},
+    {DoseRowEditType::REMOVE, 2, 2},
+    {DoseRowEditType::INSERT, 2, 2},
+    {DoseRowEditType::INSERT, 5, 1}}));
+  EXPECT_EQ(apply_all(from, edits, to), to);
+
+  reef_moonshiners::diff_dose_rows(to, to, edits);
+  EXPECT_TRUE(edits.empty());
+  reef_moonshiners::diff_dose_rows({}, to, edits);
+  EXPECT_EQ(edits, (std::vector<DoseRowEdit>{{DoseRowEditType::INSERT, 0, to.size()}}));
+  reef_moonshiners::diff_dose_rows(to, {}, edits);
+  EXPECT_EQ(edits, (std::vector<DoseRowEdit>{{DoseRowEditType::REMOVE, 0, to.size()}}));
+}
+
+TEST(TestDoseList, test_random_diffs)
+{
+  std::mt19937 random{1234};
+  const auto make_rows = [&random]() {
+      std::vector<DoseRow> rows;
+      for (size_t element = 0; element < 300; ++element) {
+        if (random() % 2) {
+          rows.push_back(DoseRow{element, static_cast<double>(random() % 3)});
+        }
+      }
+      return rows;
+    };
+  std::vector<DoseRowEdit> edits;
+  for (size_t x = 0; x < 200; ++x) {
+    const auto from = make_rows();
+    const auto to = make_rows();
+    reef_moonshiners::diff_dose_rows(from, to, edits);
+    ASSERT_EQ(apply_all(from, edits, to), to);
+    /* runs are as long as they can be */
+    for (size_t y = 1; y < edits.size(); ++y) {
+      const auto & last = edits[y - 1];
+      if (last.type == edits[y].type) {
+        const size_t next = (DoseRowEditType::REMOVE == last.type) ?
+          last.row : last.row + last.count;
+        EXPECT_NE(next, edits[y].row);
+      }
+    }
+  }
+}
+
+TEST(TestDoseList, test_recomputes_only_changes)
+{
+  const std::chrono::year_month_day start{
+    std::chrono::year(2022), std::chrono::October, std::chrono::day(1)};
+  auto tank = std::make_shared<reef_moonshiners::Tank>(reef_moonshiners::gallons_to_liters(120));
+  CountedIron iron;
+  reef_moonshiners::Iodine iodine;
+  reef_moonshiners::Rubidium rubidium;
+  for (reef_moonshiners::ElementBase * element :
+    std::vector<reef_moonshiners::ElementBase *>{&iron, &iodine, &rubidium})
+  {
+    element->set_tank(tank);
+    element->set_concentration(0.0, start);
+  }
+  iodine.set_drops(0);
+  rubidium.set_dosing_frequency(reef_moonshiners::RubidiumSelection::MONTHLY);
+  rubidium.set_initial_dose_date(start + std::chrono::days(3));
+
+  reef_moonshiners::DoseList list{{&iron, &iodine, &rubidium}};
+  const auto apply = [&list](const std::chrono::year_month_day & date) {
+      const auto edits = list.update(date);
+      for (const auto & edit : edits) {
+        list.apply(edit);
+      }
+      return edits;
+    };
+  /* no drops yet, so iodine is not listed */
+  auto edits = apply(start);
+  EXPECT_EQ(edits, (std::vector<DoseRowEdit>{{DoseRowEditType::INSERT, 0, 1}}));
+  EXPECT_EQ(iron.fills, 1u);
+  ASSERT_EQ(list.get_rows().size(), 1u);
+  EXPECT_EQ(list.get_rows()[0], (DoseRow{0, iron.get_dose(start)}));
+
+  /* moving within the schedule recomputes nothing */
+  edits = apply(start + std::chrono::days(3));
+  EXPECT_EQ(edits, (std::vector<DoseRowEdit>{{DoseRowEditType::INSERT, 1, 1}}));
+  EXPECT_EQ(list.get_rows()[1].element, 2u);
+  edits = apply(start + std::chrono::days(4));
+  EXPECT_EQ(edits, (std::vector<DoseRowEdit>{{DoseRowEditType::REMOVE, 1, 1}}));
+  EXPECT_EQ(iron.fills, 1u);
+
+  /* a drop count recomputes only its dropper */
+  iodine.set_drops(2);
+  edits = apply(start + std::chrono::days(4));
+  EXPECT_EQ(edits, (std::vector<DoseRowEdit>{{DoseRowEditType::INSERT, 1, 1}}));
+  EXPECT_EQ(list.get_rows()[1], (DoseRow{1, 2.0}));
+  EXPECT_EQ(iron.fills, 1u);
+
+  /* the tank recomputes everything */
+  tank->set_volume(reef_moonshiners::gallons_to_liters(240));
+  edits = apply(start + std::chrono::days(4));
+  EXPECT_EQ(edits, (std::vector<DoseRowEdit>{{DoseRowEditType::CHANGE, 0, 1}}));
+  EXPECT_EQ(iron.fills, 2u);
+
+  /* leaving the schedule moves it, keeping doses that are the same every day */
+  const auto later = start + std::chrono::days(200);
+  edits = apply(later);
+  EXPECT_TRUE(edits.empty());
+  EXPECT_EQ(iron.fills, 2u);
+  EXPECT_TRUE(list.get_schedule().contains(later));
+  EXPECT_TRUE(list.get_schedule().contains(later + std::chrono::days(-7)));
+  EXPECT_EQ(list.get_date(), later);
+  ASSERT_EQ(list.get_rows().size(), 2u);
+  EXPECT_EQ(list.get_rows()[0], (DoseRow{0, iron.get_dose(later)}));
+  EXPECT_EQ(list.get_rows()[1], (DoseRow{1, 2.0}));
+
+  /* unless they changed on the way */
+  tank->set_volume(reef_moonshiners::gallons_to_liters(120));
+  const auto earlier = start + std::chrono::days(-200);
+  edits = apply(earlier);
+  EXPECT_EQ(edits, (std::vector<DoseRowEdit>{{DoseRowEditType::CHANGE, 0, 1}}));
+  EXPECT_EQ(iron.fills, 3u);
+  EXPECT_EQ(list.get_rows()[0], (DoseRow{0, iron.get_dose(earlier)}));
+}
@@ -0,0 +1,84 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <reef_moonshiners/dose_schedule.hpp>
+#include <reef_moonshiners/elements.hpp>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+TEST(TestDoseSchedule, test_matches_get_dose)
+{
+  const std::chrono::year_month_day start{
+    std::chrono::year(2022), std::chrono::October, std::chrono::day(1)};
+  const std::chrono::year_month_day end = start + std::chrono::days(400);
+  auto tank = std::make_shared<reef_moonshiners::Tank>(reef_moonshiners::gallons_to_liters(120));
+
+  reef_moonshiners::Iron iron;
+  reef_moonshiners::Iodine iodine;
+  reef_moonshiners::Rubidium rubidium;
+  reef_moonshiners::Zinc zinc;
+  reef_moonshiners::Barium barium;
+  for (reef_moonshiners::ElementBase * element :
+    std::vector<reef_moonshiners::ElementBase *>{&iron, &iodine, &rubidium, &zinc, &barium})
+  {
+    element->set_tank(tank);
+    element->set_concentration(0.0, start);
+  }
+  iodine.set_drops(2);
+  rubidium.set_dosing_frequency(reef_moonshiners::RubidiumSelection::MONTHLY);
+  rubidium.set_initial_dose_date(start + std::chrono::days(3));
+  /* a correction running off the front of the schedule, and one inside it */
+  zinc.set_correction_start_date(start + std::chrono::days(-1));
+  barium.set_correction_start_date(start + std::chrono::days(200));
+
+  reef_moonshiners::DoseSchedule schedule{start, end, {&iron, &iodine, &rubidium, &zinc, &barium}};
+  ASSERT_EQ(schedule.get_day_count(), 400u);
+  ASSERT_EQ(schedule.get_element_count(), 5u);
+  EXPECT_TRUE(schedule.contains(start));
+  EXPECT_FALSE(schedule.contains(end));
+  for (size_t element = 0; element < schedule.get_element_count(); ++element) {
+    const auto doses = schedule.get_doses(element);
+    for (size_t day = 0; day < schedule.get_day_count(); ++day) {
+      const auto date = start + std::chrono::days(day);
+      EXPECT_EQ(doses[day], schedule.get_element(element)->get_dose(date));
+      EXPECT_EQ(schedule.get_dose(element, date), doses[day]);
+    }
+  }
+
+  /* updating one element after a change */
+  tank->set_volume(reef_moonshiners::gallons_to_liters(60));
+  iodine.set_drops(3);
+  schedule.update();
+  EXPECT_EQ(schedule.get_dose(1, start), 3.0);
+  EXPECT_EQ(schedule.get_dose(0, start), iron.get_dose(start));
+  EXPECT_EQ(schedule.get_dose(3, start), zinc.get_dose(start));
+
+  /* moving keeps the doses that are the same every day, and recomputes the rest */
+  for (const auto & [from, to] : {std::pair{150, 250}, std::pair{-30, 10}}) {
+    const auto moved = start + std::chrono::days(from);
+    schedule.move(moved, start + std::chrono::days(to));
+    ASSERT_EQ(schedule.get_day_count(), static_cast<size_t>(to - from));
+    EXPECT_EQ(schedule.get_start_date(), moved);
+    for (size_t element = 0; element < schedule.get_element_count(); ++element) {
+      for (size_t day = 0; day < schedule.get_day_count(); ++day) {
+        const auto date = moved + std::chrono::days(day);
+        EXPECT_EQ(schedule.get_dose(element, date), schedule.get_element(element)->get_dose(date));
+      }
+    }
+  }
+}
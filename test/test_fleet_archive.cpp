@@ -0,0 +1,268 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <reef_moonshiners/elements.hpp>
+#include <reef_moonshiners/fleet_archive.hpp>
+
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+
+const std::chrono::year_month_day start{2022y / 6 / 1};
+
+/**
+ * Tank whose zinc was corrected for a number of days
+ */
+struct Fleet
+{
+  explicit Fleet(const size_t tanks)
+  {
+    for (size_t x = 0; x < tanks; ++x) {
+      auto & tank = this->tanks.emplace_back(std::make_shared<reef_moonshiners::Tank>(100.0 + x));
+      auto & zinc = this->zinc.emplace_back(std::make_unique<reef_moonshiners::Zinc>());
+      auto & iron = this->iron.emplace_back(std::make_unique<reef_moonshiners::Iron>());
+      zinc->set_tank(tank);
+      iron->set_tank(tank);
+      zinc->set_concentration(1.0 + 0.01 * x, start);
+      iron->set_concentration(2.0, start);
+      zinc->set_correction_start_date(start);
+      for (int day = 0; day < static_cast<int>(x % 7); ++day) {
+        const auto date = start + std::chrono::days(day);
+        zinc->apply_dose(zinc->get_dose(date), date);
+      }
+    }
+  }
+
+  std::vector<std::shared_ptr<reef_moonshiners::Tank>> tanks;
+  std::vector<std::unique_ptr<reef_moonshiners::Zinc>> zinc;
+  std::vector<std::unique_ptr<reef_moonshiners::Iron>> iron;
+};
+
+std::string archive(const Fleet & fleet, const uint32_t block_rows)
+{
+  reef_moonshiners::FleetArchive out{block_rows};
+  for (size_t x = 0; x < fleet.tanks.size(); ++x) {
+    const reef_moonshiners::ElementBase * elements[] = {fleet.zinc[x].get(), fleet.iron[x].get()};
+    out.add_tank(1000 + x, *fleet.tanks[x], elements);
+  }
+  std::stringstream stream;
+  out.write_to(stream);
+  return stream.str();
+}
+
+}  // namespace
+
+TEST(TestFleetArchive, test_round_trip)
+{
+  const Fleet fleet{50};
+  const std::string bytes = archive(fleet, 16);
+
+  reef_moonshiners::FleetArchive in;
+  ASSERT_TRUE(in.read_from(bytes));
+  EXPECT_EQ(16u, in.get_block_rows());
+  ASSERT_TRUE(in.load());
+  const auto & columns = in.get_columns();
+  ASSERT_EQ(50u, columns.tank_id.size());
+  ASSERT_EQ(100u, columns.element_tank.size());
+  /* names are stored once */
+  EXPECT_EQ(2u, columns.names.size());
+  EXPECT_EQ(1049u, columns.tank_id.back());
+
+  for (size_t x = 0; x < fleet.tanks.size(); ++x) {
+    auto tank = std::make_shared<reef_moonshiners::Tank>();
+    reef_moonshiners::Zinc zinc;
+    reef_moonshiners::Iron iron;
+    zinc.set_tank(tank);
+    iron.set_tank(tank);
+    zinc.set_correction_start_date(start);
+    reef_moonshiners::ElementBase * elements[] = {&zinc, &iron};
+    ASSERT_TRUE(in.apply_to(x, *tank, elements));
+    EXPECT_EQ(fleet.tanks[x]->get_volume(), tank->get_volume());
+    EXPECT_EQ(fleet.zinc[x]->get_last_measured_concentration(),
+      zinc.get_last_measured_concentration());
+    EXPECT_EQ(start, zinc.get_last_measurement_date());
+    EXPECT_EQ(fleet.zinc[x]->get_dose_history().size(), zinc.get_dose_history().size());
+    EXPECT_EQ(
+      fleet.zinc[x]->get_current_concentration_estimate(),
+      zinc.get_current_concentration_estimate());
+  }
+  EXPECT_FALSE(in.apply_to(50, *fleet.tanks[0], {}));
+}
+
+TEST(TestFleetArchive, test_round_trip_doses)
+{
+  /* settings that change the doses survive export and import */
+  auto tank = std::make_shared<reef_moonshiners::Tank>(250.0);
+  reef_moonshiners::Zinc zinc;
+  reef_moonshiners::Iron iron;
+  reef_moonshiners::Iodine iodine;
+  reef_moonshiners::Rubidium rubidium;
+  reef_moonshiners::ElementBase * exported[] = {&zinc, &iron, &iodine, &rubidium};
+  for (auto * element : exported) {
+    element->set_tank(tank);
+    element->set_concentration(0.0, start);
+  }
+  zinc.set_correction_start_date(start + std::chrono::days(3));
+  zinc.apply_dose(zinc.get_dose(start + std::chrono::days(3)), start + std::chrono::days(3));
+  iron.set_multiplier(2.0);
+  iron.set_use_nano_dose(true);
+  iodine.set_drops(3);
+  rubidium.set_dosing_frequency(reef_moonshiners::RubidiumSelection::MONTHLY);
+  rubidium.set_initial_dose_date(start + std::chrono::days(5));
+
+  reef_moonshiners::FleetArchive out;
+  out.add_tank(1, *tank, exported);
+  std::stringstream stream;
+  out.write_to(stream);
+  const std::string bytes = stream.str();
+
+  reef_moonshiners::FleetArchive in;
+  ASSERT_TRUE(in.read_from(bytes));
+  ASSERT_TRUE(in.load());
+  auto imported_tank = std::make_shared<reef_moonshiners::Tank>();
+  reef_moonshiners::Zinc imported_zinc;
+  reef_moonshiners::Iron imported_iron;
+  reef_moonshiners::Iodine imported_iodine;
+  reef_moonshiners::Rubidium imported_rubidium;
+  reef_moonshiners::ElementBase * imported[] = {
+    &imported_zinc, &imported_iron, &imported_iodine, &imported_rubidium};
+  for (auto * element : imported) {
+    element->set_tank(imported_tank);
+  }
+  /* importing twice replaces the dose history rather than adding to it */
+  ASSERT_TRUE(in.apply_to(0, *imported_tank, imported));
+  ASSERT_TRUE(in.apply_to(0, *imported_tank, imported));
+  EXPECT_EQ(zinc.get_dose_history().size(), imported_zinc.get_dose_history().size());
+
+  for (size_t x = 0; x < std::size(exported); ++x) {
+    for (int day = 0; day < 90; ++day) {
+      const auto date = start + std::chrono::days(day);
+      EXPECT_EQ(exported[x]->get_dose(date), imported[x]->get_dose(date))
+        << exported[x]->get_name() << " on day " << day;
+    }
+  }
+  EXPECT_EQ(zinc.get_current_concentration_estimate(),
+    imported_zinc.get_current_concentration_estimate());
+}
+
+TEST(TestFleetArchive, test_single_column)
+{
+  const Fleet fleet{100};
+  const std::string bytes = archive(fleet, 32);
+  reef_moonshiners::FleetArchive in;
+  ASSERT_TRUE(in.read_from(bytes));
+
+  /* one column without decoding the rest */
+  std::vector<double> volumes;
+  ASSERT_TRUE(in.read_column("tank/volume", volumes));
+  ASSERT_EQ(100u, volumes.size());
+  EXPECT_EQ(100.0, volumes.front());
+  EXPECT_EQ(199.0, volumes.back());
+  EXPECT_TRUE(in.get_columns().tank_id.empty());
+
+  /* the wrong type is refused */
+  std::vector<uint32_t> wrong;
+  EXPECT_FALSE(in.read_column("tank/volume", wrong));
+  EXPECT_FALSE(in.read_column("tank/missing", volumes));
+
+  /* block stats let readers skip to the blocks they need */
+  std::vector<reef_moonshiners::BlockStats> stats;
+  ASSERT_TRUE(in.get_block_stats("tank/volume", stats));
+  ASSERT_EQ(4u, stats.size());
+  EXPECT_EQ(164.0, stats[2].min);
+  EXPECT_EQ(195.0, stats[2].max);
+  std::vector<double> block;
+  ASSERT_TRUE(in.read_column("tank/volume", block, 3, 1));
+  ASSERT_EQ(4u, block.size());
+  EXPECT_EQ(196.0, block.front());
+}
+
+TEST(TestFleetArchive, test_delta_dates)
+{
+  const Fleet fleet{100};
+  const std::string bytes = archive(fleet, 4096);
+  reef_moonshiners::FleetArchive in;
+  ASSERT_TRUE(in.read_from(bytes));
+  std::vector<int32_t> dates;
+  ASSERT_TRUE(in.read_column("dose/date", dates));
+  ASSERT_FALSE(dates.empty());
+  const int32_t first = static_cast<int32_t>(
+    std::chrono::sys_days{start}.time_since_epoch().count());
+  EXPECT_EQ(first, dates.front());
+
+  /* daily doses are one byte each, after the block's first date and width */
+  reef_moonshiners::SaveFile file;
+  ASSERT_TRUE(file.read_from(std::string_view{bytes}));
+  EXPECT_EQ(sizeof(int32_t) + 1 + (dates.size() - 1), file.get_section_size("dose/date"));
+
+  std::vector<reef_moonshiners::BlockStats> stats;
+  ASSERT_TRUE(in.get_block_stats("dose/date", stats));
+  ASSERT_EQ(1u, stats.size());
+  EXPECT_EQ(first, stats[0].min);
+  EXPECT_EQ(first + 5, stats[0].max);
+}
+
+TEST(TestFleetArchive, test_malformed)
+{
+  const Fleet fleet{10};
+  std::string bytes = archive(fleet, 4);
+  reef_moonshiners::FleetArchive in;
+  EXPECT_FALSE(in.read_from(std::string_view{bytes}.substr(0, bytes.size() - 1)));
+  EXPECT_FALSE(in.read_from(std::string_view{}));
+
+  /* row counts the column's bytes cannot hold are refused before anything is sized */
+  std::string header;
+  header += '\0';
+  header += static_cast<char>(sizeof(uint64_t));
+  for (const uint64_t byte : {10u, 0u, 0u, 0u, 0u, 0u, 0u, 0u, 4u, 0u, 0u, 0u}) {
+    header += static_cast<char>(byte);
+  }
+  std::string corrupt = bytes;
+  for (size_t at = corrupt.find(header); std::string::npos != at;
+    at = corrupt.find(header, at + 1))
+  {
+    /* 2^33 rows in three blocks of 2^32 - 1 */
+    corrupt[at + 2] = corrupt[at + 3] = corrupt[at + 4] = corrupt[at + 5] = '\0';
+    corrupt[at + 6] = '\2';
+    corrupt[at + 10] = corrupt[at + 11] = corrupt[at + 12] = corrupt[at + 13] = '\xff';
+  }
+  ASSERT_NE(corrupt, bytes);
+  ASSERT_TRUE(in.read_from(corrupt));
+  std::vector<uint64_t> ids;
+  EXPECT_FALSE(in.read_column("tank/id", ids));
+  EXPECT_TRUE(ids.empty());
+  EXPECT_FALSE(in.load());
+
+  /* a dose that refers to a missing element is refused by load */
+  reef_moonshiners::FleetArchive out;
+  auto & columns = out.get_columns();
+  columns.dose_element.push_back(3);
+  columns.dose_date.push_back(0);
+  columns.dose_ml.push_back(1.0);
+  std::stringstream stream;
+  out.write_to(stream);
+  bytes = stream.str();
+  ASSERT_TRUE(in.read_from(bytes));
+  EXPECT_FALSE(in.load());
+  EXPECT_TRUE(in.get_columns().dose_element.empty());
+}
@@ -0,0 +1,112 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <reef_moonshiners/icp_cache.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace
+{
+
+std::filesystem::path fresh_directory(const std::string & name)
+{
+  const auto path = std::filesystem::temp_directory_path() / (name + ".icp_cache");
+  std::filesystem::remove_all(path);
+  return path;
+}
+
+}  // namespace
+
+TEST(TestIcpCache, test_store_and_lookup)
+{
+  const auto directory = fresh_directory("test_store_and_lookup");
+  const std::string page = "<html>var dataTable = {\"0\": {}}</html>";
+  const std::chrono::system_clock::time_point validated{std::chrono::seconds{1663113600}};
+  {
+    reef_moonshiners::IcpCache cache{directory};
+    reef_moonshiners::IcpCacheEntry entry;
+    EXPECT_FALSE(cache.lookup("12345", entry));
+    entry.etag = "\"abc\"";
+    entry.last_modified = "Wed, 14 Sep 2022 00:00:00 GMT";
+    entry.validated = validated;
+    entry.values = {{"Zinc", 3.25}, {"Iron", 0.8}};
+    ASSERT_TRUE(cache.store("12345", page, entry));
+    /* the same page under another ID is stored once */
+    ASSERT_TRUE(cache.store("a/b c", page, entry));
+  }
+
+  /* a new cache over the same directory sees it all */
+  reef_moonshiners::IcpCache cache{directory};
+  reef_moonshiners::IcpCacheEntry entry;
+  ASSERT_TRUE(cache.lookup("12345", entry));
+  EXPECT_EQ(entry.etag, "\"abc\"");
+  EXPECT_EQ(entry.last_modified, "Wed, 14 Sep 2022 00:00:00 GMT");
+  EXPECT_EQ(entry.validated, validated);
+  EXPECT_EQ(entry.page_hash, reef_moonshiners::IcpCache::hash_page(page));
+  EXPECT_EQ(entry.page_size, page.size());
+  ASSERT_EQ(entry.values.size(), 2u);
+  EXPECT_EQ(entry.values["Zinc"], 3.25);
+  EXPECT_EQ(entry.values["Iron"], 0.8);
+  std::string stored;
+  ASSERT_TRUE(cache.load_page(entry, stored));
+  EXPECT_EQ(stored, page);
+
+  EXPECT_EQ(
+    cache.get_analysis_ids(), (std::vector<std::string>{"12345", "a/b c"}));
+  size_t pages = 0;
+  for (const auto & file : std::filesystem::directory_iterator{directory / "pages"}) {
+    (void)file;
+    ++pages;
+  }
+  EXPECT_EQ(pages, 1u);
+
+  const auto later = validated + std::chrono::hours{1};
+  ASSERT_TRUE(cache.mark_validated("a/b c", later));
+  ASSERT_TRUE(cache.lookup("a/b c", entry));
+  EXPECT_EQ(entry.validated, later);
+  EXPECT_EQ(entry.values.size(), 2u);
+  EXPECT_FALSE(cache.mark_validated("99999", later));
+  EXPECT_FALSE(cache.store("", page, entry));
+  std::filesystem::remove_all(directory);
+}
+
+TEST(TestIcpCache, test_damaged)
+{
+  const auto directory = fresh_directory("test_damaged");
+  reef_moonshiners::IcpCache cache{directory};
+  reef_moonshiners::IcpCacheEntry entry;
+  const std::string page = "<html>results</html>";
+  ASSERT_TRUE(cache.store("1", page, entry));
+  ASSERT_TRUE(cache.lookup("1", entry));
+
+  /* a page changed behind the cache's back is not served */
+  for (const auto & file : std::filesystem::directory_iterator{directory / "pages"}) {
+    std::ofstream{file.path(), std::ios::binary} << "<html>tampered</html>";
+  }
+  std::string stored;
+  EXPECT_FALSE(cache.load_page(entry, stored));
+  /* storing it again repairs it */
+  ASSERT_TRUE(cache.store("1", page, entry));
+  EXPECT_TRUE(cache.load_page(entry, stored));
+
+  /* a truncated record is a miss */
+  const auto record = directory / "analyses" / "1.dat";
+  std::filesystem::resize_file(record, std::filesystem::file_size(record) / 2);
+  EXPECT_FALSE(cache.lookup("1", entry));
+  std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,109 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <reef_moonshiners/elements.hpp>
+#include <reef_moonshiners/icp_elements.hpp>
+
+#include <cctype>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using reef_moonshiners::IcpElement;
+using reef_moonshiners::find_icp_element;
+
+/* resolved at compile time */
+static_assert(find_icp_element("Zinc") == IcpElement::ZINC);
+static_assert(find_icp_element("zn") == IcpElement::ZINC);
+static_assert(find_icp_element("Sulphur") == IcpElement::SULFUR);
+static_assert(find_icp_element("Zinc ") == IcpElement::UNKNOWN);
+
+TEST(TestIcpElements, test_find)
+{
+  for (const auto & alias : reef_moonshiners::icp_element_aliases) {
+    EXPECT_EQ(find_icp_element(alias.name), alias.element) << alias.name;
+  }
+  for (size_t x = 0; x < reef_moonshiners::icp_element_count; ++x) {
+    const auto element = static_cast<IcpElement>(x);
+    const std::string_view name = reef_moonshiners::icp_element_names[x];
+    EXPECT_EQ(reef_moonshiners::get_icp_element_name(element), name);
+    std::string upper{name};
+    for (auto & c : upper) {
+      c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    EXPECT_EQ(find_icp_element(upper), element) << upper;
+  }
+  EXPECT_EQ(find_icp_element("Aluminum"), IcpElement::ALUMINIUM);
+  EXPECT_EQ(find_icp_element(""), IcpElement::UNKNOWN);
+  EXPECT_EQ(find_icp_element("Chloride"), IcpElement::UNKNOWN);
+  EXPECT_EQ(find_icp_element("Zincc"), IcpElement::UNKNOWN);
+  EXPECT_EQ(find_icp_element("Zin"), IcpElement::UNKNOWN);
+}
+
+TEST(TestIcpElements, test_every_element_is_reported)
+{
+  const reef_moonshiners::Bromine bromine;
+  const reef_moonshiners::Boron boron;
+  const reef_moonshiners::Fluorine fluorine;
+  const reef_moonshiners::Molybdenum molybdenum;
+  const reef_moonshiners::Nickel nickel;
+  const reef_moonshiners::Zinc zinc;
+  const reef_moonshiners::Strontium strontium;
+  const reef_moonshiners::Potassium potassium;
+  const reef_moonshiners::Manganese manganese;
+  const reef_moonshiners::Chromium chromium;
+  const reef_moonshiners::Selenium selenium;
+  const reef_moonshiners::Cobalt cobalt;
+  const reef_moonshiners::Iron iron;
+  const reef_moonshiners::Iodine iodine;
+  const reef_moonshiners::Vanadium vanadium;
+  const reef_moonshiners::Barium barium;
+  const reef_moonshiners::Rubidium rubidium;
+  const std::vector<const reef_moonshiners::ElementBase *> elements{
+    &bromine, &boron, &fluorine, &molybdenum, &nickel, &zinc, &strontium, &potassium,
+    &manganese, &chromium, &selenium, &cobalt, &iron, &iodine, &vanadium, &barium, &rubidium};
+  for (const reef_moonshiners::ElementBase * element : elements) {
+    EXPECT_NE(element->get_icp_element(), IcpElement::UNKNOWN) << element->get_name();
+    EXPECT_EQ(
+      reef_moonshiners::get_icp_element_name(element->get_icp_element()), element->get_name());
+  }
+}
+
+TEST(TestIcpElements, test_results)
+{
+  reef_moonshiners::IcpResults results;
+  EXPECT_EQ(results.size(), 0u);
+  EXPECT_FALSE(results.contains(IcpElement::ZINC));
+  EXPECT_TRUE(results.set(IcpElement::ZINC, 3.25));
+  EXPECT_FALSE(results.set(IcpElement::UNKNOWN, 1.0));
+  EXPECT_TRUE(results.contains(IcpElement::ZINC));
+  EXPECT_FALSE(results.contains(IcpElement::UNKNOWN));
+  EXPECT_EQ(results.get(IcpElement::ZINC), 3.25);
+  EXPECT_EQ(results.get(IcpElement::IRON), 0.0);
+  EXPECT_EQ(results.size(), 1u);
+
+  reef_moonshiners::IcpConcentrations values{{"Iron", 0.8}, {"Cl", 19E6}, {"SR", 8E3}};
+  std::vector<std::string> unknown;
+  reef_moonshiners::resolve_icp_results(values, results, unknown);
+  EXPECT_EQ(results.size(), 2u);
+  EXPECT_FALSE(results.contains(IcpElement::ZINC));
+  EXPECT_EQ(results.get(IcpElement::IRON), 0.8);
+  EXPECT_EQ(results.get(IcpElement::STRONTIUM), 8E3);
+  EXPECT_EQ(unknown, (std::vector<std::string>{"Cl"}));
+
+  reef_moonshiners::get_icp_concentrations(results, values);
+  EXPECT_EQ(values, (reef_moonshiners::IcpConcentrations{{"Iron", 0.8}, {"Strontium", 8E3}}));
+}
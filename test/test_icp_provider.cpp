@@ -0,0 +1,210 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <reef_moonshiners/icp_provider.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using reef_moonshiners::IcpElement;
+
+namespace
+{
+
+constexpr std::chrono::year_month_day sampled{
+  std::chrono::year{2022}, std::chrono::September, std::chrono::day{14}};
+
+}  // namespace
+
+TEST(TestIcpProvider, test_registry)
+{
+  const auto providers = reef_moonshiners::get_icp_providers();
+  ASSERT_EQ(providers.size(), 3u);
+  EXPECT_EQ(providers[0]->get_name(), "ATI ICP-OES");
+  EXPECT_FALSE(providers[0]->is_file_based());
+  EXPECT_EQ(providers[1]->get_name(), "CSV export");
+  EXPECT_TRUE(providers[1]->is_file_based());
+  EXPECT_EQ(providers[2]->get_name(), "JSON export");
+  EXPECT_TRUE(providers[2]->is_file_based());
+}
+
+TEST(TestIcpProvider, test_values_and_units)
+{
+  double value = 0.0;
+  EXPECT_TRUE(reef_moonshiners::parse_icp_value(" 3.25 ", value));
+  EXPECT_DOUBLE_EQ(value, 3.25);
+  EXPECT_TRUE(reef_moonshiners::parse_icp_value("0,8", value));
+  EXPECT_DOUBLE_EQ(value, 0.8);
+  EXPECT_TRUE(reef_moonshiners::parse_icp_value("1.2e-3", value));
+  EXPECT_DOUBLE_EQ(value, 1.2E-3);
+  EXPECT_FALSE(reef_moonshiners::parse_icp_value("", value));
+  EXPECT_FALSE(reef_moonshiners::parse_icp_value("3.2 mg", value));
+  EXPECT_FALSE(reef_moonshiners::parse_icp_value("1,000.5", value));
+
+  EXPECT_EQ(reef_moonshiners::get_icp_unit_scale(""), 1.0);
+  EXPECT_EQ(reef_moonshiners::get_icp_unit_scale("ug/L"), 1.0);
+  EXPECT_EQ(reef_moonshiners::get_icp_unit_scale("\xC2\xB5g/l"), 1.0);
+  EXPECT_EQ(reef_moonshiners::get_icp_unit_scale("PPB"), 1.0);
+  EXPECT_EQ(reef_moonshiners::get_icp_unit_scale(" mg/L "), 1E3);
+  EXPECT_EQ(reef_moonshiners::get_icp_unit_scale("ppm"), 1E3);
+  EXPECT_EQ(reef_moonshiners::get_icp_unit_scale("g/L"), 0.0);
+}
+
+TEST(TestIcpProvider, test_long_csv)
+{
+  const std::string report =
+    "\xEF\xBB\xBF# exported from the lab portal\r\n"
+    "Date;Element;Value;Unit\r\n"
+    "2022-09-14;Zinc;3,25;\xC2\xB5g/L\r\n"
+    "\r\n"
+    "2022-09-14;\"Na\";10,9325;mg/L\r\n"
+    "2022-09-14;Lithium;<0,5;ug/L\r\n"
+    "2022-09-14;Chloride;19000;mg/L\r\n"
+    "2022-09-14;Iron;nd;ug/L\r\n";
+  reef_moonshiners::CsvIcpProvider provider;
+  reef_moonshiners::IcpReport parsed;
+  std::string error;
+  ASSERT_TRUE(provider.parse(report, parsed, error)) << error;
+  EXPECT_EQ(parsed.results.size(), 2u);
+  EXPECT_DOUBLE_EQ(parsed.results.get(IcpElement::ZINC), 3.25);
+  EXPECT_DOUBLE_EQ(parsed.results.get(IcpElement::SODIUM), 10932.5);
+  EXPECT_FALSE(parsed.results.contains(IcpElement::LITHIUM));
+  EXPECT_FALSE(parsed.results.contains(IcpElement::IRON));
+  EXPECT_EQ(parsed.unknown, (std::vector<std::string_view>{"Chloride"}));
+  EXPECT_EQ(parsed.collection_date, sampled);
+}
+
+TEST(TestIcpProvider, test_wide_csv)
+{
+  const std::string report =
+    "Sample\tDate\tZinc (ug/L)\tSodium [mg/L]\tMg\tBoron (ppm)\n"
+    "Display\t2022-09-14\t3.25\t10.9325\t1350\t\n";
+  reef_moonshiners::CsvIcpProvider provider;
+  reef_moonshiners::IcpReport parsed;
+  std::string error;
+  ASSERT_TRUE(provider.parse(report, parsed, error)) << error;
+  EXPECT_EQ(parsed.results.size(), 3u);
+  EXPECT_DOUBLE_EQ(parsed.results.get(IcpElement::ZINC), 3.25);
+  EXPECT_DOUBLE_EQ(parsed.results.get(IcpElement::SODIUM), 10932.5);
+  EXPECT_DOUBLE_EQ(parsed.results.get(IcpElement::MAGNESIUM), 1350);
+  EXPECT_FALSE(parsed.results.contains(IcpElement::BORON));
+  EXPECT_EQ(parsed.unknown, (std::vector<std::string_view>{"Sample"}));
+  EXPECT_EQ(parsed.collection_date, sampled);
+}
+
+TEST(TestIcpProvider, test_malformed_csv)
+{
+  reef_moonshiners::CsvIcpProvider provider;
+  reef_moonshiners::IcpReport parsed;
+  std::string error;
+  EXPECT_FALSE(provider.parse("", parsed, error));
+  EXPECT_EQ(error, "no results found");
+  EXPECT_FALSE(provider.parse("Element,Value\nZinc,three\n", parsed, error));
+  EXPECT_EQ(error, "malformed value for \"Zinc\"");
+  EXPECT_FALSE(provider.parse("Element,Value,Unit\nZinc,3,g/L\n", parsed, error));
+  EXPECT_EQ(error, "unknown unit \"g/L\" for \"Zinc\"");
+  EXPECT_FALSE(provider.parse("Element,Value\nZinc,3,4\n", parsed, error));
+  EXPECT_EQ(error, "malformed row on line 2");
+  EXPECT_FALSE(provider.parse("Element,Value\n\"Zinc,3\n", parsed, error));
+  EXPECT_EQ(error, "malformed row on line 2");
+  EXPECT_FALSE(provider.parse("Zinc,Iron\n1,2\n3,4\n", parsed, error));
+  EXPECT_EQ(error, "more than one sample in line 3");
+  EXPECT_FALSE(provider.parse("Date,Zinc\n14/09/2022,1\n", parsed, error));
+  EXPECT_EQ(error, "malformed date on line 2");
+  EXPECT_FALSE(provider.parse("Element,Value\nChloride,1\n", parsed, error));
+  EXPECT_EQ(error, "no results found");
+  EXPECT_EQ(parsed.results.size(), 0u);
+}
+
+TEST(TestIcpProvider, test_json)
+{
+  const std::string object =
+    "{\"date\": \"2022-09-14\", \"lab\": {\"name\": \"Example\", \"ids\": [1, 2]},\n"
+    " \"Zinc\": 3.25, \"Na\": {\"unit\": \"mg/L\", \"value\": \"10,9325\"},\n"
+    " \"Lithium\": null, \"Iron\": \"<0.5\", \"Chloride\": 19000}\n";
+  reef_moonshiners::JsonIcpProvider provider;
+  reef_moonshiners::IcpReport parsed;
+  std::string error;
+  ASSERT_TRUE(provider.parse(object, parsed, error)) << error;
+  EXPECT_EQ(parsed.results.size(), 2u);
+  EXPECT_DOUBLE_EQ(parsed.results.get(IcpElement::ZINC), 3.25);
+  EXPECT_DOUBLE_EQ(parsed.results.get(IcpElement::SODIUM), 10932.5);
+  EXPECT_FALSE(parsed.results.contains(IcpElement::LITHIUM));
+  EXPECT_FALSE(parsed.results.contains(IcpElement::IRON));
+  EXPECT_EQ(parsed.unknown, (std::vector<std::string_view>{"lab", "Chloride"}));
+  EXPECT_EQ(parsed.collection_date, sampled);
+
+  const std::string nested =
+    "{\"date\": \"2022-09-14\", \"results\": ["
+    "{\"element\": \"Zinc\", \"value\": 3.25, \"unit\": \"ug/L\", \"method\": \"ICP-OES\"},"
+    "{\"symbol\": \"Mg\", \"result\": 1.35, \"units\": \"ppm\"}]}";
+  ASSERT_TRUE(provider.parse(nested, parsed, error)) << error;
+  EXPECT_EQ(parsed.results.size(), 2u);
+  EXPECT_DOUBLE_EQ(parsed.results.get(IcpElement::MAGNESIUM), 1350);
+  EXPECT_EQ(parsed.collection_date, sampled);
+
+  ASSERT_TRUE(provider.parse("[{\"name\": \"Zn\", \"value\": 2}]", parsed, error)) << error;
+  EXPECT_DOUBLE_EQ(parsed.results.get(IcpElement::ZINC), 2.0);
+  EXPECT_FALSE(parsed.collection_date);
+}
+
+TEST(TestIcpProvider, test_malformed_json)
+{
+  reef_moonshiners::JsonIcpProvider provider;
+  reef_moonshiners::IcpReport parsed;
+  std::string error;
+  EXPECT_FALSE(provider.parse("{\"Zinc\": 3.25", parsed, error));
+  EXPECT_EQ(error, "malformed JSON");
+  EXPECT_FALSE(provider.parse("{\"Zinc\": 3.25} trailing", parsed, error));
+  EXPECT_EQ(error, "malformed JSON");
+  EXPECT_FALSE(provider.parse("{\"Zinc\": true}", parsed, error));
+  EXPECT_EQ(error, "malformed value for \"Zinc\"");
+  EXPECT_FALSE(provider.parse("{\"Zinc\": {\"value\": 1, \"unit\": \"g\"}}", parsed, error));
+  EXPECT_EQ(error, "unknown unit \"g\" for \"Zinc\"");
+  EXPECT_FALSE(provider.parse("{\"date\": \"yesterday\", \"Zinc\": 1}", parsed, error));
+  EXPECT_EQ(error, "malformed date");
+  EXPECT_FALSE(provider.parse("[{\"value\": 1}]", parsed, error));
+  EXPECT_EQ(error, "malformed result 0");
+  EXPECT_FALSE(provider.parse("{}", parsed, error));
+  EXPECT_EQ(error, "no results found");
+
+  /* every truncation fails cleanly */
+  const std::string report = "{\"Zinc\": 3.25, \"Na\": {\"value\": 10.9, \"unit\": \"mg/L\"}}";
+  for (size_t size = 0; size < report.size(); ++size) {
+    EXPECT_FALSE(provider.parse(std::string_view{report}.substr(0, size), parsed, error)) << size;
+  }
+  /* nesting is bounded */
+  EXPECT_FALSE(provider.parse("{\"x\": " + std::string(10000, '[') + "}", parsed, error));
+}
+
+TEST(TestIcpProvider, test_ati)
+{
+  const std::string page =
+    "<script>var dataTable = new AnalysisTable({\n"
+    "\"0\": {\"element\": {\"description_en\": \"Zinc\", \"units_id\": 1},"
+    " \"elements_value\": 3.25},\n"
+    "tank: {}});</script>";
+  reef_moonshiners::AtiIcpProvider provider;
+  reef_moonshiners::IcpReport parsed;
+  std::string error;
+  ASSERT_TRUE(provider.parse(page, parsed, error)) << error;
+  EXPECT_EQ(parsed.results.size(), 1u);
+  EXPECT_DOUBLE_EQ(parsed.results.get(IcpElement::ZINC), 3.25);
+  EXPECT_FALSE(parsed.collection_date);
+  EXPECT_FALSE(provider.parse("<html></html>", parsed, error));
+  EXPECT_EQ(error, "data table not found");
+}
@@ -0,0 +1,116 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <reef_moonshiners/correction_element.hpp>
+#include <reef_moonshiners/journal.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace
+{
+
+std::filesystem::path journal_path(const std::string & name)
+{
+  const auto path = std::filesystem::temp_directory_path() / (name + ".journal");
+  std::filesystem::remove(path);
+  return path;
+}
+
+const std::chrono::year_month_day today{
+  std::chrono::year(2022), std::chrono::November, std::chrono::day(12)};
+
+}  // namespace
+
+TEST(TestJournal, test_replay)
+{
+  const auto path = journal_path("test_replay");
+  {
+    reef_moonshiners::Journal journal{path};
+    EXPECT_TRUE(journal.replay().empty());
+    EXPECT_TRUE(journal.append({reef_moonshiners::JournalEntryType::SET_SETTING, "tank", {}, 300}));
+    EXPECT_TRUE(
+      journal.append(
+        {reef_moonshiners::JournalEntryType::SET_CONCENTRATION, "Zinc", today, 2.5}));
+    EXPECT_TRUE(
+      journal.append({reef_moonshiners::JournalEntryType::APPLY_DOSE, "Zinc", today, 1.25}));
+    EXPECT_EQ(journal.get_entry_count(), 3u);
+  }
+  reef_moonshiners::Journal journal{path};
+  const auto entries = journal.replay();
+  ASSERT_EQ(entries.size(), 3u);
+  EXPECT_EQ(journal.get_entry_count(), 3u);
+  EXPECT_EQ(entries[0].type, reef_moonshiners::JournalEntryType::SET_SETTING);
+  EXPECT_EQ(entries[0].key, "tank");
+  EXPECT_EQ(entries[0].value, 300.0);
+  EXPECT_EQ(entries[1].type, reef_moonshiners::JournalEntryType::SET_CONCENTRATION);
+  EXPECT_EQ(entries[1].date, today);
+  EXPECT_EQ(entries[2].key, "Zinc");
+  EXPECT_EQ(entries[2].value, 1.25);
+
+  EXPECT_TRUE(journal.clear());
+  EXPECT_EQ(journal.get_entry_count(), 0u);
+  EXPECT_TRUE(journal.replay().empty());
+}
+
+TEST(TestJournal, test_torn_tail)
+{
+  const auto path = journal_path("test_torn_tail");
+  {
+    reef_moonshiners::Journal journal{path};
+    for (int x = 0; x < 10; ++x) {
+      journal.append(
+        {reef_moonshiners::JournalEntryType::APPLY_DOSE, "Boron", today + std::chrono::days(x),
+          static_cast<double>(x)});
+    }
+  }
+  /* a crash part way through the last entry */
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+  reef_moonshiners::Journal journal{path};
+  auto entries = journal.replay();
+  ASSERT_EQ(entries.size(), 9u);
+  EXPECT_EQ(entries.back().value, 8.0);
+
+  /* entries appended after recovery are readable */
+  journal.append({reef_moonshiners::JournalEntryType::APPLY_DOSE, "Boron", today, 42.0});
+  entries = journal.replay();
+  ASSERT_EQ(entries.size(), 10u);
+  EXPECT_EQ(entries.back().value, 42.0);
+  std::filesystem::remove(path);
+}
+
+TEST(TestJournal, test_corrupt_size)
+{
+  const auto path = journal_path("test_corrupt_size");
+  {
+    reef_moonshiners::Journal journal{path};
+    journal.append({reef_moonshiners::JournalEntryType::APPLY_DOSE, "Boron", today, 1.0});
+  }
+  const auto intact = std::filesystem::file_size(path);
+  {
+    /* a size that would ask for 4 GiB, followed by too few bytes for it */
+    std::ofstream file{path, std::ios::binary | std::ios::app};
+    const char tail[] = {'\xff', '\xff', '\xff', '\xff', 'x', 'y', 'z'};
+    file.write(tail, sizeof(tail));
+  }
+  reef_moonshiners::Journal journal{path};
+  const auto entries = journal.replay();
+  ASSERT_EQ(entries.size(), 1u);
+  EXPECT_EQ(entries.back().value, 1.0);
+  EXPECT_EQ(std::filesystem::file_size(path), intact);
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,141 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <reef_moonshiners/elements.hpp>
+#include <reef_moonshiners/mapped_file.hpp>
+#include <reef_moonshiners/save_file.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+
+std::filesystem::path write_file(const std::string & name, const std::string & bytes)
+{
+  const auto path = std::filesystem::temp_directory_path() / name;
+  std::ofstream file{path, std::ios::binary};
+  file.write(bytes.data(), bytes.size());
+  return path;
+}
+
+const std::chrono::year_month_day start{
+  std::chrono::year(2022), std::chrono::December, std::chrono::day(20)};
+
+}  // namespace
+
+TEST(TestMappedFile, test_map)
+{
+  reef_moonshiners::MappedFile file;
+  EXPECT_FALSE(file.open(std::filesystem::temp_directory_path() / "does_not_exist.dat"));
+  EXPECT_FALSE(file.is_open());
+
+  const auto path = write_file("test_map.dat", "hello, reef");
+  ASSERT_TRUE(file.open(path));
+  EXPECT_TRUE(file.is_open());
+  EXPECT_EQ(file.get_data(), "hello, reef");
+
+  reef_moonshiners::MappedFile moved{std::move(file)};
+  EXPECT_FALSE(file.is_open());
+  EXPECT_EQ(moved.get_data(), "hello, reef");
+
+  /* streams read and seek in place */
+  reef_moonshiners::MemoryStream stream{moved.get_data()};
+  std::string word;
+  stream >> word;
+  EXPECT_EQ(word, "hello,");
+  EXPECT_EQ(stream.tellg(), 6);
+  stream.seekg(-4, std::ios::end);
+  stream >> word;
+  EXPECT_EQ(word, "reef");
+  stream.seekg(100);
+  EXPECT_FALSE(stream);
+
+  const auto empty = write_file("test_map_empty.dat", "");
+  ASSERT_TRUE(moved.open(empty));
+  EXPECT_TRUE(moved.get_data().empty());
+  moved.close();
+  std::filesystem::remove(path);
+  std::filesystem::remove(empty);
+}
+
+TEST(TestMappedFile, test_save_file)
+{
+  reef_moonshiners::ElementBase::set_load_version(5);
+  auto tank = std::make_shared<reef_moonshiners::Tank>(reef_moonshiners::gallons_to_liters(90));
+  reef_moonshiners::Boron boron_out;
+  boron_out.set_tank(tank);
+  boron_out.set_concentration(4.5E3, start);
+  boron_out.set_correction_start_date(start);
+  for (int day = 0; day < 100; day += 3) {
+    boron_out.apply_dose(0.5 * day, start + std::chrono::days(day));
+  }
+  reef_moonshiners::SaveFile out;
+  boron_out.write_settings_to(out.add_section("Boron"));
+  boron_out.write_ledger_to(out.add_section("Boron/ledger"));
+  std::ostringstream bytes;
+  out.write_to(bytes);
+  const auto path = write_file("test_mapped_save_file.dat", bytes.str());
+
+  reef_moonshiners::MappedFile file;
+  ASSERT_TRUE(file.open(path));
+  reef_moonshiners::SaveFile in;
+  ASSERT_TRUE(in.read_from(file.get_data()));
+  reef_moonshiners::Boron boron_in;
+  boron_in.set_tank(tank);
+  reef_moonshiners::MemoryStream settings{in.get_section("Boron")};
+  boron_in.read_settings_from(settings);
+  EXPECT_EQ(boron_in.get_dose(start), boron_out.get_dose(start));
+  EXPECT_TRUE(in.get_section("missing").empty());
+
+  /* the history is read where it lies */
+  reef_moonshiners::MemoryStream ledger{in.get_section("Boron/ledger")};
+  boron_in.read_ledger_from(ledger);
+  ASSERT_TRUE(ledger);
+  for (int day = 0; day < 120; ++day) {
+    EXPECT_EQ(
+      boron_in.get_dose(start + std::chrono::days(day)),
+      boron_out.get_dose(start + std::chrono::days(day)));
+  }
+
+  /* a truncated history is rejected */
+  const auto section = in.get_section("Boron/ledger");
+  reef_moonshiners::MemoryStream truncated{section.substr(0, section.size() - 1)};
+  boron_in.read_ledger_from(truncated);
+  EXPECT_FALSE(truncated);
+  file.close();
+  std::filesystem::remove(path);
+}
+
+TEST(TestMappedFile, test_replace_file)
+{
+  const auto directory = std::filesystem::temp_directory_path() / "test_replace_file";
+  std::filesystem::remove_all(directory);
+  const auto path = directory / "nested" / "replaced.dat";
+
+  /* the parent directory is created */
+  ASSERT_TRUE(reef_moonshiners::replace_file(path, "first"));
+  ASSERT_TRUE(reef_moonshiners::replace_file(path, std::string_view{"second\0", 7}));
+  EXPECT_FALSE(std::filesystem::exists(path.string() + ".tmp"));
+
+  reef_moonshiners::MappedFile file;
+  ASSERT_TRUE(file.open(path));
+  EXPECT_EQ(file.get_data(), std::string_view("second\0", 7));
+  file.close();
+  std::filesystem::remove_all(directory);
+}
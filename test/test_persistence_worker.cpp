@@ -0,0 +1,161 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <reef_moonshiners/persistence_worker.hpp>
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+std::filesystem::path journal_path(const std::string & name)
+{
+  const auto path = std::filesystem::temp_directory_path() / (name + ".journal");
+  std::filesystem::remove(path);
+  return path;
+}
+
+/**
+ * Collects the snapshots written by a worker
+ */
+struct Snapshots
+{
+  reef_moonshiners::PersistenceWorker::SnapshotWriter writer()
+  {
+    return [this](const std::string & snapshot) {
+             std::lock_guard<std::mutex> lock{mutex};
+             written.push_back(snapshot);
+             return true;
+           };
+  }
+
+  std::vector<std::string> get()
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    return written;
+  }
+
+  std::mutex mutex;
+  std::vector<std::string> written;
+};
+
+reef_moonshiners::JournalEntry tank_volume(const double liters)
+{
+  return {reef_moonshiners::JournalEntryType::SET_SETTING, "tank_volume", {}, liters};
+}
+
+}  // namespace
+
+TEST(TestPersistenceWorker, test_coalesce)
+{
+  const auto path = journal_path("test_coalesce");
+  Snapshots snapshots;
+  {
+    reef_moonshiners::PersistenceWorker worker{
+      reef_moonshiners::Journal{path}, snapshots.writer(), std::chrono::seconds(10)};
+    /* typing "180.5" */
+    for (const double liters : {1.0, 18.0, 180.0, 180.0, 180.5}) {
+      worker.append(tank_volume(liters));
+    }
+    worker.append({reef_moonshiners::JournalEntryType::SET_SETTING, "refugium", {}, 2.0});
+    worker.flush();
+    EXPECT_EQ(worker.get_snapshot_count(), 0u);
+  }
+  reef_moonshiners::Journal journal{path};
+  const auto entries = journal.replay();
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].key, "tank_volume");
+  EXPECT_EQ(entries[0].value, 180.5);
+  EXPECT_EQ(entries[1].key, "refugium");
+  EXPECT_TRUE(snapshots.get().empty());
+  journal.clear();
+}
+
+TEST(TestPersistenceWorker, test_snapshot)
+{
+  const auto path = journal_path("test_snapshot");
+  Snapshots snapshots;
+  {
+    reef_moonshiners::PersistenceWorker worker{
+      reef_moonshiners::Journal{path}, snapshots.writer(), std::chrono::milliseconds(20)};
+    worker.append(tank_volume(100.0));
+    worker.save("first");
+    worker.save("second");
+    worker.append(tank_volume(200.0));
+    /* the worker writes once the edits settle, without a flush */
+    for (int x = 0; x < 500 && snapshots.get().empty(); ++x) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    worker.flush();
+    EXPECT_EQ(worker.get_snapshot_count(), 1u);
+    /* queued work is written when the worker stops */
+    worker.append(tank_volume(300.0));
+  }
+  ASSERT_EQ(snapshots.get().size(), 1u);
+  EXPECT_EQ(snapshots.get().front(), "second");
+  /* only what came after the snapshot is left in the journal */
+  reef_moonshiners::Journal journal{path};
+  const auto entries = journal.replay();
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].value, 200.0);
+  EXPECT_EQ(entries[1].value, 300.0);
+  journal.clear();
+}
+
+TEST(TestPersistenceWorker, test_failed_snapshot)
+{
+  const auto path = journal_path("test_failed_snapshot");
+  {
+    reef_moonshiners::PersistenceWorker worker{
+      reef_moonshiners::Journal{path}, [](const std::string &) {return false;},
+      std::chrono::milliseconds(0)};
+    worker.append(tank_volume(100.0));
+    worker.save("lost");
+    worker.flush();
+    EXPECT_EQ(worker.get_snapshot_count(), 0u);
+  }
+  /* the journal still holds the change */
+  reef_moonshiners::Journal journal{path};
+  EXPECT_EQ(journal.replay().size(), 1u);
+  journal.clear();
+}
+
+TEST(TestPersistenceWorker, test_failed_append)
+{
+  /* a journal whose directory does not exist cannot be written */
+  const auto path = std::filesystem::temp_directory_path() / "test_failed_append" / "journal";
+  std::filesystem::remove_all(path.parent_path());
+  Snapshots snapshots;
+  {
+    reef_moonshiners::PersistenceWorker * p_worker = nullptr;
+    reef_moonshiners::PersistenceWorker worker{
+      reef_moonshiners::Journal{path}, snapshots.writer(), std::chrono::milliseconds(0),
+      [&p_worker] {p_worker->save("full state");}};
+    p_worker = &worker;
+    worker.append(tank_volume(100.0));
+    worker.flush();
+    EXPECT_EQ(worker.get_append_failure_count(), 1u);
+    /* the snapshot asked for holds the change instead */
+    worker.flush();
+    EXPECT_EQ(worker.get_snapshot_count(), 1u);
+  }
+  ASSERT_EQ(snapshots.get().size(), 1u);
+  EXPECT_EQ(snapshots.get().front(), "full state");
+}
@@ -0,0 +1,143 @@
+// Copyright 2022 Hunter L. Allen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <reef_moonshiners/elements.hpp>
+#include <reef_moonshiners/save_file.hpp>
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+TEST(TestSaveFile, test_deterministic)
+{
+  reef_moonshiners::SaveFile forward;
+  forward.add_section("alpha") << "first";
+  forward.add_section("beta") << "second";
+  forward.add_section("gamma") << "third";
+  reef_moonshiners::SaveFile backward;
+  backward.add_section("gamma") << "third";
+  backward.add_section("beta") << "replaced";
+  backward.add_section("beta") << "second";
+  backward.add_section("alpha") << "first";
+
+  std::stringstream forward_stream, backward_stream;
+  forward.write_to(forward_stream);
+  backward.write_to(backward_stream);
+  EXPECT_EQ(forward_stream.str(), backward_stream.str());
+}
+
+TEST(TestSaveFile, test_seek)
+{
+  std::stringstream stream;
+  /* something ahead of the table, as the save file version is */
+  reef_moonshiners::binary_out(stream, size_t{5});
+  reef_moonshiners::SaveFile out;
+  reef_moonshiners::binary_out(out.add_section("numbers"), 42.0);
+  out.add_section("unknown") << "written by a newer version";
+  out.add_section("text") << "hello";
+  out.write_to(stream);
+
+  size_t version = 0;
+  reef_moonshiners::binary_in(stream, version);
+  EXPECT_EQ(version, 5u);
+  reef_moonshiners::SaveFile in;
+  ASSERT_TRUE(in.read_from(stream));
+  EXPECT_EQ(in.get_section_names().size(), 3u);
+  EXPECT_FALSE(in.contains("missing"));
+  EXPECT_FALSE(in.seek(stream, "missing"));
+  EXPECT_EQ(in.get_section_size("numbers"), sizeof(double));
+
+  /* sections are read in any order */
+  std::string text;
+  ASSERT_TRUE(in.read_section(stream, "text", text));
+  EXPECT_EQ(text, "hello");
+  ASSERT_TRUE(in.seek(stream, "numbers"));
+  double number = 0.0;
+  reef_moonshiners::binary_in(stream, number);
+  EXPECT_EQ(number, 42.0);
+}
+
+TEST(TestSaveFile, test_malformed)
+{
+  reef_moonshiners::SaveFile out;
+  out.add_section("section") << "some data";
+  std::stringstream stream;
+  out.write_to(stream);
+  std::string bytes = stream.str();
+
+  /* a truncated file has a section past its end */
+  std::stringstream truncated{bytes.substr(0, bytes.size() - 1)};
+  reef_moonshiners::SaveFile in;
+  EXPECT_FALSE(in.read_from(truncated));
+  EXPECT_FALSE(in.contains("section"));
+
+  /* as does a garbage section count */
+  bytes[0] = '\x7f';
+  std::stringstream garbage{bytes};
+  EXPECT_FALSE(in.read_from(garbage));
+
+  std::stringstream empty;
+  EXPECT_FALSE(in.read_from(empty));
+}
+
+TEST(TestSaveFile, test_deferred_ledger)
+{
+  const std::chrono::year_month_day now{
+    std::chrono::floor<std::chrono::days>(std::chrono::system_clock::now())};
+  reef_moonshiners::ElementBase::set_load_version(5);
+  auto tank = std::make_shared<reef_moonshiners::Tank>(reef_moonshiners::gallons_to_liters(75));
+  reef_moonshiners::Zinc zinc_out;
+  zinc_out.set_tank(tank);
+  zinc_out.set_concentration(0.0, now + std::chrono::days(-10));
+  zinc_out.set_correction_start_date(now + std::chrono::days(-10));
+  for (int day = -10; day < 0; ++day) {
+    const auto date = now + std::chrono::days(day);
+    zinc_out.apply_dose(zinc_out.get_dose(date), date);
+  }
+
+  reef_moonshiners::SaveFile out;
+  zinc_out.write_settings_to(out.add_section(zinc_out.get_name()));
+  zinc_out.write_ledger_to(out.add_section(zinc_out.get_name() + "/ledger"));
+  std::stringstream stream;
+  out.write_to(stream);
+
+  reef_moonshiners::SaveFile in;
+  ASSERT_TRUE(in.read_from(stream));
+  reef_moonshiners::Zinc zinc_in;
+  zinc_in.set_tank(tank);
+  ASSERT_TRUE(in.seek(stream, "Zinc"));
+  zinc_in.read_settings_from(stream);
+  std::string ledger;
+  ASSERT_TRUE(in.read_section(stream, "Zinc/ledger", ledger));
+  zinc_in.defer_ledger(std::move(ledger), 5);
+  /* the plan does not need the history */
+  EXPECT_EQ(zinc_in.get_dose(now), zinc_out.get_dose(now));
+  EXPECT_EQ(
+    zinc_in.get_current_concentration_estimate(),
+    zinc_out.get_current_concentration_estimate());
+  EXPECT_GT(zinc_in.get_current_concentration_estimate(), 0.0);
+
+  /* a deferred history is read before it is written back */
+  reef_moonshiners::Zinc zinc_copy;
+  zinc_copy.set_tank(tank);
+  zinc_copy.defer_ledger("", 5);
+  std::stringstream round_trip;
+  zinc_in.write_to(round_trip);
+  zinc_copy.read_from(round_trip);
+  EXPECT_EQ(
+    zinc_copy.get_current_concentration_estimate(),
+    zinc_out.get_current_concentration_estimate());
+}